@@ -0,0 +1,151 @@
+/**
+OKX Candle Store
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
+*/
+
+#ifndef INCLUDE_STONKY_OKX_CANDLE_STORE_H
+#define INCLUDE_STONKY_OKX_CANDLE_STORE_H
+
+#include "okx_models.h"
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace stonky::okx {
+/// Decimal columns of a stored candle, each is a column of mantissas and a column of scales
+enum class CandleColumn : std::size_t {
+    o,
+    h,
+    l,
+    c,
+    vol,
+    volCcy,
+    volCcyQuote
+};
+
+inline constexpr std::size_t CANDLE_DECIMAL_COLUMNS = 7;
+
+/**
+ * Rows of one block of a CandleStore file, the spans point directly to the mapped file
+ */
+struct CandleSegment {
+    std::span<const std::int64_t> ts{};
+    std::array<std::span<const std::int64_t>, CANDLE_DECIMAL_COLUMNS> mantissas{};
+    std::array<std::span<const std::int8_t>, CANDLE_DECIMAL_COLUMNS> scales{};
+    std::span<const std::uint8_t> confirm{};
+
+    [[nodiscard]] std::size_t size() const { return ts.size(); }
+
+    [[nodiscard]] Decimal value(CandleColumn column, std::size_t row) const;
+
+    [[nodiscard]] Candle candle(std::size_t row) const;
+};
+
+/**
+ * Zero-copy view of a time range of a CandleStore, it keeps the file mapped while it exists
+ */
+class CandleRange {
+    std::shared_ptr<const void> m_mapping{};
+    std::vector<CandleSegment> m_segments{};
+
+public:
+    CandleRange() = default;
+
+    CandleRange(std::shared_ptr<const void> mapping, std::vector<CandleSegment> segments);
+
+    /**
+     * @return Consecutive parts of the range, one per block of the file
+     */
+    [[nodiscard]] const std::vector<CandleSegment> &segments() const { return m_segments; }
+
+    [[nodiscard]] std::size_t size() const;
+
+    [[nodiscard]] bool empty() const { return size() == 0; }
+
+    /**
+     * Materialize the range
+     * @return Candles in chronological order
+     */
+    [[nodiscard]] std::vector<Candle> toCandles() const;
+};
+
+/**
+ * Append-only columnar store of a candle series, one file per (instId, BarSize). The file is a header followed by
+ * blocks of a fixed number of rows, each block holds the ts, mantissa, scale and confirm columns of its rows. The file
+ * is memory mapped, reading a range is a binary search in the sparse index of the first timestamps of the blocks and
+ * in one ts column, the data itself is not copied or parsed. Only one instance may write to a file at a time.
+ */
+class CandleStore {
+    struct P;
+    std::unique_ptr<P> m_p{};
+
+public:
+    /// Rows of one block
+    static constexpr std::size_t BLOCK_ROWS = 4096;
+
+    /**
+     * Open the store of the series, the file is created if it does not exist
+     * @param directory directory of the store files, created if it does not exist
+     * @param instId instrument Id, e.g. "ETH-USDT-SWAP"
+     * @param barSize
+     * @throws std::runtime_error if the file cannot be created or belongs to another series or format
+     */
+    CandleStore(const std::filesystem::path &directory, const std::string &instId, BarSize barSize);
+
+    ~CandleStore();
+
+    /**
+     * @return Path of the file of the series, e.g. "<directory>/ETH-USDT-SWAP-1m.candles"
+     */
+    [[nodiscard]] static std::filesystem::path filePath(const std::filesystem::path &directory, const std::string &instId, BarSize barSize);
+
+    /**
+     * Append candles newer than the last stored one, older ones and unconfirmed candles are skipped
+     * @param candles in any order
+     * @return Number of appended candles
+     */
+    std::size_t append(std::span<const Candle> candles) const;
+
+    /**
+     * Writer for getHistoricalPrices, getHistoricalPricesParallel and downloadAndParseHistoricalCandles. Chronological
+     * pages newer than everything written so far are appended at once, the newest-first pages of getHistoricalPrices
+     * are staged in memory until flush().
+     * @return Callback valid while the store exists
+     */
+    [[nodiscard]] std::function<void(const std::vector<Candle> &)> writer() const;
+
+    /**
+     * Append the staged pages of the writer
+     * @return Number of appended candles
+     */
+    std::size_t flush() const;
+
+    /**
+     * Write the mapped data to the disk
+     */
+    void sync() const;
+
+    [[nodiscard]] std::size_t size() const;
+
+    [[nodiscard]] std::optional<std::int64_t> firstTs() const;
+
+    [[nodiscard]] std::optional<std::int64_t> lastTs() const;
+
+    /**
+     * @param from timestamp in ms, inclusive
+     * @param to timestamp in ms, inclusive
+     * @return View of the stored candles in [from, to]
+     */
+    [[nodiscard]] CandleRange range(std::int64_t from, std::int64_t to) const;
+};
+} // namespace stonky::okx
+#endif // INCLUDE_STONKY_OKX_CANDLE_STORE_H
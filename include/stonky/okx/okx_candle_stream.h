@@ -0,0 +1,86 @@
+/**
+OKX Candle Stream
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
+*/
+
+#ifndef INCLUDE_STONKY_OKX_CANDLE_STREAM_H
+#define INCLUDE_STONKY_OKX_CANDLE_STREAM_H
+
+#include "okx_models.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace stonky::okx {
+class RESTClient;
+
+/**
+ * Pull-style source of candles. Pages are handed out in chronological order and the next page is downloaded only
+ * after the previous one is taken, so only a constant number of pages is held in memory.
+ */
+class CandleStream {
+public:
+    virtual ~CandleStream() = default;
+
+    /**
+     * Get next page of candles
+     * @param page replaced with the next page, oldest candle first
+     * @return false if the stream is exhausted, the page is then empty
+     * @throws nlohmann::json::exception, std::exception
+     */
+    virtual bool next(std::vector<Candle> &page) = 0;
+};
+
+/**
+ * Candles from the history-candles REST endpoint, the range is walked forward in windows of one full page and one
+ * window is prefetched while the caller processes the current page. Unconfirmed candle is not returned.
+ */
+class RESTCandleStream final : public CandleStream {
+    struct P;
+    std::unique_ptr<P> m_p{};
+
+public:
+    /**
+     * @param client REST client which has to outlive the stream
+     * @param instId instrument Id, e.g. "ETH-USDT-SWAP"
+     * @param barSize
+     * @param from timestamp in ms (exclusive)
+     * @param to timestamp in ms (exclusive)
+     */
+    RESTCandleStream(const RESTClient &client, std::string instId, BarSize barSize, std::int64_t from, std::int64_t to);
+
+    ~RESTCandleStream() override;
+
+    bool next(std::vector<Candle> &page) override;
+};
+
+/**
+ * Candles from OKX bulk market data ZIP files, one file is one page. Files are downloaded one at a time, the next
+ * file is prefetched while the caller processes the current page.
+ */
+class ZipCandleStream final : public CandleStream {
+    struct P;
+    std::unique_ptr<P> m_p{};
+
+public:
+    /**
+     * @param client REST client which has to outlive the stream
+     * @param instType Instrument type (SPOT, SWAP, FUTURES, OPTION)
+     * @param instFamily Instrument family (e.g., "BTC-USDT")
+     * @param instId Instrument Id (e.g., "BTC-USDT-SWAP"), the files of a family contain all of its instruments
+     * @param dateAggrType Date aggregation type (daily or monthly)
+     * @param begin Begin timestamp in ms (inclusive)
+     * @param end End timestamp in ms (inclusive)
+     */
+    ZipCandleStream(const RESTClient &client, InstrumentType instType, std::string instFamily, std::string instId, DateAggrType dateAggrType,
+                    std::int64_t begin, std::int64_t end);
+
+    ~ZipCandleStream() override;
+
+    bool next(std::vector<Candle> &page) override;
+};
+} // namespace stonky::okx
+#endif // INCLUDE_STONKY_OKX_CANDLE_STREAM_H
@@ -0,0 +1,456 @@
+/**
+OKX Decimal
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
+*/
+
+#ifndef INCLUDE_STONKY_OKX_DECIMAL_H
+#define INCLUDE_STONKY_OKX_DECIMAL_H
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <compare>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#ifdef OKX_USE_CPP_DEC_FLOAT
+#include <boost/multiprecision/cpp_dec_float.hpp>
+#endif
+
+namespace stonky::okx {
+/**
+ * Fixed-point decimal number, value = mantissa * 10^-scale. Parsing keeps the scale of the input so that
+ * the string representation round-trips exactly ("1.50" stays "1.50"). Addition, subtraction, multiplication and
+ * comparison are exact, they throw std::overflow_error if the result does not fit the mantissa.
+ * @tparam MantissaType signed integer type, std::int64_t (18 significant digits) or __int128 (38 significant digits)
+ */
+template<typename MantissaType>
+class FixedDecimal {
+    MantissaType m_mantissa = 0;
+    std::int32_t m_scale = 0;
+
+    static constexpr MantissaType maxMantissa() {
+        MantissaType retVal = 0;
+
+        for (std::size_t i = 0; i < sizeof(MantissaType) * 8 - 1; ++i) {
+            retVal = retVal * 2 + 1;
+        }
+
+        return retVal;
+    }
+
+    static constexpr std::int32_t maxDigits() {
+        std::int32_t retVal = 0;
+
+        for (auto value = maxMantissa(); value >= 10; value /= 10) {
+            ++retVal;
+        }
+
+        return retVal;
+    }
+
+public:
+    static constexpr MantissaType MAX_MANTISSA = maxMantissa();
+
+    /// Number of decimal digits which always fit the mantissa, also the maximum scale
+    static constexpr std::int32_t MAX_DIGITS = maxDigits();
+
+private:
+    static constexpr std::array<MantissaType, MAX_DIGITS + 1> POWERS_OF_TEN = [] {
+        std::array<MantissaType, MAX_DIGITS + 1> retVal{};
+        retVal[0] = 1;
+
+        for (std::size_t i = 1; i < retVal.size(); ++i) {
+            retVal[i] = retVal[i - 1] * 10;
+        }
+
+        return retVal;
+    }();
+
+    static bool multiplyOverflows(const MantissaType a, const MantissaType b) {
+        if (a == 0 || b == 0) {
+            return false;
+        }
+
+        const auto absA = a < 0 ? -a : a;
+        const auto absB = b < 0 ? -b : b;
+        return absA > MAX_MANTISSA / absB;
+    }
+
+    static bool addOverflows(const MantissaType a, const MantissaType b) {
+        return (b > 0 && a > MAX_MANTISSA - b) || (b < 0 && a < -MAX_MANTISSA - b);
+    }
+
+    /// Round half away from zero when precision is dropped
+    static MantissaType dropDigits(const MantissaType mantissa, const std::int32_t digits) {
+        if (digits > MAX_DIGITS) {
+            return 0;
+        }
+
+        const auto divisor = POWERS_OF_TEN[digits];
+        auto retVal = mantissa / divisor;
+        const auto remainder = mantissa % divisor;
+
+        if (remainder * 2 >= divisor) {
+            ++retVal;
+        } else if (-remainder * 2 >= divisor) {
+            --retVal;
+        }
+
+        return retVal;
+    }
+
+    /// Mantissa expressed with a bigger scale, false if it does not fit
+    static bool rescale(const MantissaType mantissa, const std::int32_t fromScale, const std::int32_t toScale, MantissaType &result) {
+        const auto digits = toScale - fromScale;
+
+        if (digits > MAX_DIGITS || multiplyOverflows(mantissa, POWERS_OF_TEN[digits])) {
+            return false;
+        }
+
+        result = mantissa * POWERS_OF_TEN[digits];
+        return true;
+    }
+
+    static FixedDecimal normalized(MantissaType mantissa, std::int32_t scale) {
+        if (scale > MAX_DIGITS) {
+            mantissa = dropDigits(mantissa, scale - MAX_DIGITS);
+            scale = MAX_DIGITS;
+        }
+
+        FixedDecimal retVal;
+        retVal.m_mantissa = mantissa;
+        retVal.m_scale = scale;
+        return retVal;
+    }
+
+public:
+    FixedDecimal() = default;
+
+    /**
+     * Parse decimal string, e.g. "-12.345", "0.00012" or "1.5e-7"
+     * @throws std::invalid_argument if the string is not a number or its integer part does not fit
+     */
+    explicit FixedDecimal(const std::string_view str) {
+        assign(str);
+    }
+
+    explicit FixedDecimal(const char *str) : FixedDecimal(std::string_view(str)) {
+    }
+
+    /// Implicit like the arithmetic constructors of boost::multiprecision numbers, e.g. order.sz = 10
+    template<typename IntegerType> requires std::is_integral_v<IntegerType>
+    FixedDecimal(const IntegerType value) : m_mantissa(static_cast<MantissaType>(value)) {
+    }
+
+    /**
+     * Create from the shortest decimal representation of the double, e.g. 0.362 becomes exactly "0.362"
+     * @throws std::invalid_argument if the value is not finite or does not fit
+     */
+    template<typename FloatType> requires std::is_floating_point_v<FloatType>
+    FixedDecimal(const FloatType value) {
+        std::array<char, 32> buffer{};
+        const auto [ptr, ec] = std::to_chars(buffer.data(), buffer.data() + buffer.size(), static_cast<double>(value));
+
+        if (ec != std::errc()) {
+            throw std::invalid_argument("Decimal conversion of floating point value failed");
+        }
+
+        assign(std::string_view(buffer.data(), ptr - buffer.data()));
+    }
+
+    /**
+     * Create from raw mantissa and scale, value = mantissa * 10^-scale
+     */
+    static FixedDecimal fromMantissa(const MantissaType mantissa, const std::int32_t scale) {
+        return normalized(mantissa, scale < 0 ? 0 : scale);
+    }
+
+    /**
+     * Parse decimal string without throwing
+     * @return false if the string is not a number or does not fit, the value is then not changed
+     */
+    static bool tryParse(const std::string_view str, FixedDecimal &value) noexcept {
+        std::size_t pos = 0;
+        bool negative = false;
+
+        if (pos < str.size() && (str[pos] == '-' || str[pos] == '+')) {
+            negative = str[pos] == '-';
+            ++pos;
+        }
+
+        MantissaType mantissa = 0;
+        std::int32_t scale = 0;
+        std::size_t digits = 0;
+        bool fraction = false;
+        bool truncated = false;
+        bool roundUp = false;
+
+        for (; pos < str.size(); ++pos) {
+            const auto ch = str[pos];
+
+            if (ch == '.' && !fraction) {
+                fraction = true;
+                continue;
+            }
+
+            if (ch < '0' || ch > '9') {
+                break;
+            }
+
+            ++digits;
+            const auto digit = static_cast<MantissaType>(ch - '0');
+
+            if (truncated) {
+                continue;
+            }
+
+            if (mantissa > (MAX_MANTISSA - digit) / 10) {
+                /// Digits behind the precision of the mantissa are rounded away, the integer part has to fit
+                if (!fraction) {
+                    return false;
+                }
+
+                truncated = true;
+                roundUp = digit >= 5;
+                continue;
+            }
+
+            mantissa = mantissa * 10 + digit;
+
+            if (fraction) {
+                ++scale;
+            }
+        }
+
+        if (digits == 0) {
+            return false;
+        }
+
+        if (pos < str.size() && (str[pos] == 'e' || str[pos] == 'E')) {
+            ++pos;
+            bool negativeExponent = false;
+
+            if (pos < str.size() && (str[pos] == '-' || str[pos] == '+')) {
+                negativeExponent = str[pos] == '-';
+                ++pos;
+            }
+
+            std::int32_t exponent = 0;
+            const auto exponentStart = pos;
+
+            for (; pos < str.size() && str[pos] >= '0' && str[pos] <= '9' && exponent < 10000; ++pos) {
+                exponent = exponent * 10 + (str[pos] - '0');
+            }
+
+            if (pos == exponentStart) {
+                return false;
+            }
+
+            scale += negativeExponent ? exponent : -exponent;
+        }
+
+        if (pos != str.size()) {
+            return false;
+        }
+
+        if (roundUp && mantissa < MAX_MANTISSA) {
+            ++mantissa;
+        }
+
+        if (scale < 0) {
+            if (!rescale(mantissa, scale, 0, mantissa)) {
+                return false;
+            }
+
+            scale = 0;
+        }
+
+        value = normalized(negative ? -mantissa : mantissa, scale);
+        return true;
+    }
+
+    /**
+     * Parse decimal string, the same as the string constructor
+     */
+    FixedDecimal &assign(const std::string_view str) {
+        if (!tryParse(str, *this)) {
+            throw std::invalid_argument("Invalid decimal number: " + std::string(str));
+        }
+
+        return *this;
+    }
+
+    [[nodiscard]] MantissaType mantissa() const { return m_mantissa; }
+
+    [[nodiscard]] std::int32_t scale() const { return m_scale; }
+
+    /**
+     * Exact string representation, the scale of the parsed string is kept
+     */
+    [[nodiscard]] std::string str() const {
+        std::array<char, MAX_DIGITS + 4> buffer{};
+        auto end = buffer.end();
+        auto it = end;
+        auto value = m_mantissa;
+        std::int32_t written = 0;
+
+        do {
+            const auto digit = static_cast<int>(value % 10);
+            *--it = static_cast<char>('0' + (digit < 0 ? -digit : digit));
+            value /= 10;
+            ++written;
+
+            if (written == m_scale) {
+                *--it = '.';
+            }
+        } while (value != 0 || written < m_scale);
+
+        if (*it == '.') {
+            *--it = '0';
+        }
+
+        if (m_mantissa < 0) {
+            *--it = '-';
+        }
+
+        return {it, end};
+    }
+
+    /**
+     * String representation with exactly given number of fractional digits, rounded half away from zero. Named
+     * differently from the str(digits) of cpp_dec_float, which counts significant digits.
+     */
+    [[nodiscard]] std::string strFixed(const std::int32_t fractionalDigits) const {
+        if (fractionalDigits >= m_scale) {
+            MantissaType mantissa;
+
+            if (rescale(m_mantissa, m_scale, fractionalDigits, mantissa)) {
+                return fromMantissa(mantissa, fractionalDigits).str();
+            }
+
+            return str();
+        }
+
+        return fromMantissa(dropDigits(m_mantissa, m_scale - fractionalDigits), fractionalDigits).str();
+    }
+
+    template<typename ValueType>
+    [[nodiscard]] ValueType convert_to() const {
+        if constexpr (std::is_floating_point_v<ValueType>) {
+            /// Both operands are exact up to 2^53 / 10^22, one division then rounds correctly
+            return static_cast<ValueType>(static_cast<double>(m_mantissa) / static_cast<double>(POWERS_OF_TEN[m_scale]));
+        } else {
+            return static_cast<ValueType>(m_mantissa / POWERS_OF_TEN[m_scale]);
+        }
+    }
+
+    [[nodiscard]] bool isZero() const { return m_mantissa == 0; }
+
+    friend FixedDecimal operator-(const FixedDecimal &value) {
+        return fromMantissa(-value.m_mantissa, value.m_scale);
+    }
+
+    friend FixedDecimal operator+(const FixedDecimal &lhs, const FixedDecimal &rhs) {
+        const auto scale = std::max(lhs.m_scale, rhs.m_scale);
+        MantissaType a;
+        MantissaType b;
+
+        if (!rescale(lhs.m_mantissa, lhs.m_scale, scale, a) || !rescale(rhs.m_mantissa, rhs.m_scale, scale, b) || addOverflows(a, b)) {
+            throw std::overflow_error("Decimal addition overflow");
+        }
+
+        return fromMantissa(a + b, scale);
+    }
+
+    friend FixedDecimal operator-(const FixedDecimal &lhs, const FixedDecimal &rhs) {
+        return lhs + -rhs;
+    }
+
+    friend FixedDecimal operator*(const FixedDecimal &lhs, const FixedDecimal &rhs) {
+        auto a = lhs.m_mantissa;
+        auto b = rhs.m_mantissa;
+        auto scale = lhs.m_scale + rhs.m_scale;
+
+        /// Precision is dropped from the longer operand until the product fits
+        while (multiplyOverflows(a, b) && scale > 0) {
+            auto &longer = (a < 0 ? -a : a) > (b < 0 ? -b : b) ? a : b;
+            longer = dropDigits(longer, 1);
+            --scale;
+        }
+
+        if (multiplyOverflows(a, b)) {
+            throw std::overflow_error("Decimal multiplication overflow");
+        }
+
+        return normalized(a * b, scale);
+    }
+
+    FixedDecimal &operator+=(const FixedDecimal &other) { return *this = *this + other; }
+
+    FixedDecimal &operator-=(const FixedDecimal &other) { return *this = *this - other; }
+
+    FixedDecimal &operator*=(const FixedDecimal &other) { return *this = *this * other; }
+
+    friend bool operator==(const FixedDecimal &lhs, const FixedDecimal &rhs) {
+        return (lhs <=> rhs) == std::strong_ordering::equal;
+    }
+
+    friend std::strong_ordering operator<=>(const FixedDecimal &lhs, const FixedDecimal &rhs) {
+        if (lhs.m_scale == rhs.m_scale) {
+            return lhs.m_mantissa <=> rhs.m_mantissa;
+        }
+
+        const auto scale = std::max(lhs.m_scale, rhs.m_scale);
+        MantissaType a;
+        MantissaType b;
+
+        if (rescale(lhs.m_mantissa, lhs.m_scale, scale, a) && rescale(rhs.m_mantissa, rhs.m_scale, scale, b)) {
+            return a <=> b;
+        }
+
+        /// One of the values is too big to be rescaled, compare integer parts first, then fractional parts
+        const auto integerA = lhs.m_mantissa / POWERS_OF_TEN[lhs.m_scale];
+        const auto integerB = rhs.m_mantissa / POWERS_OF_TEN[rhs.m_scale];
+
+        if (integerA != integerB) {
+            return integerA <=> integerB;
+        }
+
+        const auto fractionA = static_cast<long double>(lhs.m_mantissa % POWERS_OF_TEN[lhs.m_scale]) / static_cast<long double>(POWERS_OF_TEN[lhs.m_scale]);
+        const auto fractionB = static_cast<long double>(rhs.m_mantissa % POWERS_OF_TEN[rhs.m_scale]) / static_cast<long double>(POWERS_OF_TEN[rhs.m_scale]);
+
+        if (fractionA < fractionB) {
+            return std::strong_ordering::less;
+        }
+
+        return fractionA > fractionB ? std::strong_ordering::greater : std::strong_ordering::equal;
+    }
+
+    friend std::ostream &operator<<(std::ostream &os, const FixedDecimal &value) {
+        return os << value.str();
+    }
+};
+
+/// 18 significant digits, enough for all OKX prices and sizes
+using Decimal64 = FixedDecimal<std::int64_t>;
+
+#ifdef __SIZEOF_INT128__
+/// 38 significant digits
+__extension__ using Decimal128 = FixedDecimal<__int128>;
+#endif
+
+#ifdef OKX_USE_CPP_DEC_FLOAT
+using Decimal = boost::multiprecision::cpp_dec_float_50;
+#else
+using Decimal = Decimal64;
+#endif
+} // namespace stonky::okx
+#endif // INCLUDE_STONKY_OKX_DECIMAL_H
@@ -12,6 +12,7 @@ Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
 #include "stonky/interface/i_json.h"
 #include "stonky/okx/okx_models.h"
 #include <nlohmann/json.hpp>
+#include <string_view>
 
 namespace stonky::okx {
 struct WSSubscription final : IJson {
@@ -43,19 +44,22 @@ struct WSResponse final : IJson {
     void fromJson(const nlohmann::json &json) override;
 };
 
-struct DataEvent final : IJson {
-    std::string channel{};
-    std::string instId{};
-    nlohmann::json data{};
-
-    ~DataEvent() override = default;
-
-    [[nodiscard]] nlohmann::json toJson() const override;
-
-    void fromJson(const nlohmann::json &json) override;
+/**
+ * WebSocket push message. All members are views into the session read buffer and are valid only for the duration of
+ * the data event callback, copy what has to be kept.
+ */
+struct DataEvent {
+    std::string_view channel{};
+    std::string_view instId{};
+    /// "snapshot" or "update" for order book channels, empty otherwise
+    std::string_view action{};
+    /// Raw JSON text of the data array, decode it with readEventData()
+    std::string_view data{};
 };
 
 struct DataEventCandlestick final : IJson {
+    std::string instId{};
+    BarSize barSize{BarSize::_1m};
     std::vector<Candle> candles{};
 
     [[nodiscard]] nlohmann::json toJson() const override;
@@ -64,11 +68,60 @@ struct DataEventCandlestick final : IJson {
 };
 
 struct DataEventTicker final : IJson {
+    std::string instId{};
     std::vector<Ticker> tickers{};
 
     [[nodiscard]] nlohmann::json toJson() const override;
 
     void fromJson(const nlohmann::json &json) override;
 };
+
+struct Trade {
+    std::string instId{};
+    std::string tradeId{};
+    Decimal px{};
+    Decimal sz{};
+    Side side{Side::buy};
+    std::int64_t ts{};
+
+    /// Number of trades aggregated into this one
+    std::int32_t count{1};
+};
+
+struct DataEventTrade {
+    std::string instId{};
+    std::vector<Trade> trades{};
+};
+
+struct DataEventFundingRate {
+    std::string instId{};
+    std::vector<FundingRate> rates{};
+};
+
+/// Order book level, ["px", "sz", "0", "numOrders"]. Price and size are always fixed-point, they keep the original
+/// string form needed by the checksum.
+struct BookLevel {
+    Decimal64 px{};
+    Decimal64 sz{};
+    std::int32_t numOrders{};
+};
+
+/// Message of the books, books5, bbo-tbt, books-l2-tbt and books50-l2-tbt channels
+struct DataEventOrderBook {
+    std::string instId{};
+    std::string channel{};
+
+    /// True for a full snapshot, false for an incremental update
+    bool snapshot{true};
+
+    std::vector<BookLevel> asks{};
+    std::vector<BookLevel> bids{};
+    std::int64_t ts{};
+    std::int32_t checksum{};
+    std::int64_t seqId{};
+
+    /// -1 in snapshots
+    std::int64_t prevSeqId{-1};
+};
 }
 #endif //INCLUDE_STONKY_OKX_EVENT_MODELS_H
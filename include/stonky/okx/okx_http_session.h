@@ -9,9 +9,12 @@ Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
 #ifndef INCLUDE_STONKY_OKX_HTTP_SESSION_H
 #define INCLUDE_STONKY_OKX_HTTP_SESSION_H
 
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
 #include <boost/asio/connect.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
+#include <chrono>
 #include <string>
 #include <map>
 #include <nlohmann/json_fwd.hpp>
@@ -21,19 +24,93 @@ namespace beast = boost::beast;
 namespace http = beast::http;
 namespace net = boost::asio;
 
+struct ConnectionPoolOptions {
+    /// Maximum number of idle keep-alive connections kept per host
+    std::size_t maxIdleConnections = 8;
+
+    /// Idle connections older than this are closed instead of being reused
+    std::chrono::seconds idleTimeout{25};
+};
+
+struct ConnectionPoolStats {
+    /// Number of new TCP connections + TLS handshakes
+    std::uint64_t connectionsOpened = 0;
+
+    /// Number of requests served on an already established connection
+    std::uint64_t connectionsReused = 0;
+
+    /// Number of idle connections dropped because of timeout, pool size or failed health check
+    std::uint64_t connectionsEvicted = 0;
+
+    /// Number of requests transparently repeated on a fresh connection after a stale keep-alive connection failed
+    std::uint64_t reconnects = 0;
+};
+
 class HTTPSession {
     struct P;
     std::unique_ptr<P> m_p{};
 
 public:
+    /**
+     * Create session running its own I/O thread
+     * @param apiKey
+     * @param apiSecret
+     * @param passphrase
+     */
     HTTPSession(const std::string &apiKey, const std::string &apiSecret, const std::string &passphrase);
 
+    /**
+     * Create session performing all I/O on the caller supplied executor, the session must outlive all its pending
+     * operations and the synchronous methods must not be called from the executor's threads
+     * @param executor
+     * @param apiKey
+     * @param apiSecret
+     * @param passphrase
+     */
+    HTTPSession(const net::any_io_executor &executor, const std::string &apiKey, const std::string &apiSecret, const std::string &passphrase);
+
     ~HTTPSession();
 
+    /**
+     * Get the executor used for all network I/O of the session
+     * @return
+     */
+    [[nodiscard]] net::any_io_executor executor() const;
+
+    /**
+     * Set the REST API host, useful for testing against a local TLS server
+     * @param host e.g. "www.okx.com" or "127.0.0.1"
+     * @param port e.g. "443"
+     */
+    void setHost(const std::string &host, const std::string &port = "443") const;
+
+    /**
+     * Set keep-alive connection pool options
+     * @param options
+     */
+    void setConnectionPoolOptions(const ConnectionPoolOptions &options) const;
+
+    /**
+     * Get keep-alive connection pool counters
+     * @return
+     */
+    [[nodiscard]] ConnectionPoolStats connectionPoolStats() const;
+
     [[nodiscard]] http::response<http::string_body> get(const std::string &path, const std::map<std::string, std::string> &parameters, bool isPublic = true) const;
 
     [[nodiscard]] http::response<http::string_body> post(const std::string &path, const nlohmann::json &json, bool isPublic = true) const;
 
+    /**
+     * Asynchronous version of get(), parameters are taken by value so the coroutine does not depend on caller's objects
+     */
+    [[nodiscard]] net::awaitable<http::response<http::string_body> >
+    asyncGet(std::string path, std::map<std::string, std::string> parameters, bool isPublic = true) const;
+
+    /**
+     * Asynchronous version of post(), parameters are taken by value so the coroutine does not depend on caller's objects
+     */
+    [[nodiscard]] net::awaitable<http::response<http::string_body> > asyncPost(std::string path, nlohmann::json json, bool isPublic = true) const;
+
     /**
      * Download binary data from external URL (for ZIP files from static.okx.com)
      * @param url Full URL including https://
@@ -0,0 +1,157 @@
+/**
+OKX JSON Reader
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
+*/
+
+#ifndef INCLUDE_STONKY_OKX_JSON_READER_H
+#define INCLUDE_STONKY_OKX_JSON_READER_H
+
+#include "okx_event_models.h"
+#include "okx_models.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace stonky::okx {
+/**
+ * Forward-only, on-demand JSON reader working directly on the response buffer. Nothing is parsed until it is asked
+ * for and values which are not needed are skipped without allocation. Strings without escape sequences are
+ * returned as views into the buffer.
+ */
+class JsonCursor {
+    std::string_view m_json;
+    std::size_t m_pos = 0;
+    std::string m_scratch;
+
+    /// Set right after '{' or '[', the first member or element is not preceded by ','
+    bool m_first = false;
+
+    void skipWhitespace();
+
+    [[nodiscard]] char peek();
+
+    void expect(char ch);
+
+    void expectLiteral(std::string_view literal);
+
+    void skipNumber();
+
+    [[noreturn]] void fail(std::string_view what) const;
+
+    std::string_view decodeEscapedString(std::size_t start);
+
+public:
+    explicit JsonCursor(std::string_view json);
+
+    /**
+     * Consume '{', keys are then read by nextKey()
+     */
+    void beginObject();
+
+    /**
+     * Read the next key of the current object, the value has to be read or skipped before the next call
+     * @param key view valid until the next read of a string
+     * @return false if the object is finished, the closing '}' is consumed
+     * @throws std::runtime_error if the member is not preceded by ','
+     */
+    bool nextKey(std::string_view &key);
+
+    /**
+     * Consume '[', elements are then read by nextElement()
+     */
+    void beginArray();
+
+    /**
+     * Move to the next element of the current array
+     * @return false if the array is finished, the closing ']' is consumed
+     * @throws std::runtime_error if the element is not preceded by ','
+     */
+    bool nextElement();
+
+    /**
+     * Consume null if it is the next value
+     * @return true if null was consumed
+     * @throws std::runtime_error if the value starts with 'n' but is not null
+     */
+    bool tryNull();
+
+    /**
+     * Read string value
+     * @return view valid until the next read of a string
+     */
+    std::string_view readString();
+
+    /**
+     * Read string value, null is read as empty string
+     */
+    std::string_view readStringOrNull();
+
+    /**
+     * Skip the next value including all nested objects and arrays, the skipped value is validated
+     */
+    void skipValue();
+
+    /**
+     * Skip the next value and return its source text
+     * @return view into the input, e.g. the whole array of a "data" member
+     */
+    std::string_view readRaw();
+
+    /**
+     * Read decimal stored as a string, empty string and null are read as 0
+     */
+    Decimal readDecimal();
+
+    /**
+     * Read integer stored as a string or as a number, empty string and null are read as 0
+     */
+    std::int64_t readInt64();
+
+    /**
+     * Check that only whitespace follows the top-level value
+     */
+    void end();
+};
+
+/**
+ * Fill the models directly from the response body in a single pass, without building a DOM. The Response::data
+ * member is left empty.
+ * @throws std::runtime_error if the body is not valid JSON
+ */
+void readResponse(std::string_view body, Tickers &tickers);
+
+void readResponse(std::string_view body, Candles &candles);
+
+void readResponse(std::string_view body, Instruments &instruments);
+
+/**
+ * Read the envelope of a WebSocket push message, {"arg": {...}, "action": ..., "data": [...]}. Only the arg object is
+ * parsed, the data array is returned as a view and decoded later by the channel handler.
+ * @param frame complete text frame
+ * @param event filled with views into the frame
+ * @return false if the frame is a control event ("event" member present), event is then left incomplete
+ * @throws std::runtime_error if the frame is not valid JSON
+ */
+bool readDataEvent(std::string_view frame, DataEvent &event);
+
+/**
+ * Decode the data array of a WebSocket push message
+ * @param data DataEvent::data
+ */
+void readEventData(std::string_view data, DataEventTicker &event);
+
+void readEventData(std::string_view data, DataEventCandlestick &event);
+
+void readEventData(std::string_view data, DataEventTrade &event);
+
+void readEventData(std::string_view data, DataEventFundingRate &event);
+
+/**
+ * Decode an order book message, asks and bids of all data elements are appended in order
+ */
+void readEventData(std::string_view data, DataEventOrderBook &event);
+} // namespace stonky::okx
+#endif // INCLUDE_STONKY_OKX_JSON_READER_H
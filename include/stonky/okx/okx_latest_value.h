@@ -0,0 +1,158 @@
+/**
+OKX Latest Value Cache
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
+*/
+
+#ifndef INCLUDE_STONKY_OKX_LATEST_VALUE_H
+#define INCLUDE_STONKY_OKX_LATEST_VALUE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ranges>
+
+namespace stonky::okx {
+/**
+ * Slot holding the latest value of a stream. The writer publishes a new immutable value on every message (RCU),
+ * readers take a reference to the current one without blocking the writer or each other. Only readers waiting for
+ * the next value touch the mutex, the writer locks it just when somebody waits.
+ */
+template<typename ValueType>
+class LatestValue {
+    std::atomic<std::shared_ptr<const ValueType> > m_value{};
+    std::atomic<std::uint64_t> m_version{0};
+    mutable std::atomic<std::int32_t> m_waiters{0};
+    std::atomic<bool> m_closed{false};
+    mutable std::mutex m_waitLocker;
+    mutable std::condition_variable m_waitCV;
+
+    void notify() {
+        if (m_waiters.load() > 0) {
+            /// Waiters check the version under the mutex, taking it here means none of them can miss the notification
+            std::lock_guard lk(m_waitLocker);
+        }
+
+        m_waitCV.notify_all();
+    }
+
+public:
+    /**
+     * Publish a new value and wake up the waiting readers
+     */
+    void store(ValueType value) {
+        m_value.store(std::make_shared<const ValueType>(std::move(value)));
+        m_version.fetch_add(1);
+        notify();
+    }
+
+    /**
+     * @return The latest value, nullptr if nothing has been received yet
+     */
+    [[nodiscard]] std::shared_ptr<const ValueType> load() const { return m_value.load(); }
+
+    /**
+     * @return Number of values stored so far
+     */
+    [[nodiscard]] std::uint64_t version() const { return m_version.load(); }
+
+    /**
+     * Block until a value newer than afterVersion is stored
+     * @param afterVersion version the caller has already seen, 0 to wait for the first value
+     * @param timeout maximum waiting time
+     * @return The value, nullptr on timeout or when the slot has been closed
+     */
+    [[nodiscard]] std::shared_ptr<const ValueType> waitForNext(const std::uint64_t afterVersion, const std::chrono::milliseconds timeout) const {
+        m_waiters.fetch_add(1);
+        std::unique_lock lk(m_waitLocker);
+        const bool updated = m_waitCV.wait_for(lk, timeout, [&] { return m_version.load() > afterVersion || m_closed.load(); });
+        lk.unlock();
+        m_waiters.fetch_sub(1);
+
+        if (!updated || m_closed.load()) {
+            return {};
+        }
+
+        return m_value.load();
+    }
+
+    /**
+     * Wake up all waiting readers, no reader waits from now on
+     */
+    void close() {
+        m_closed.store(true);
+        notify();
+    }
+};
+
+/**
+ * Map of LatestValue slots. The map itself is copied on insertion and published the same way as the values, so
+ * looking a slot up never blocks. Slots are never removed, a stream which is subscribed again continues in its slot.
+ */
+template<typename KeyType, typename ValueType>
+class LatestValueMap {
+    using Slots = std::map<KeyType, std::shared_ptr<LatestValue<ValueType> >, std::less<> >;
+
+    std::atomic<std::shared_ptr<const Slots> > m_slots{std::make_shared<const Slots>()};
+    std::mutex m_insertLocker;
+    bool m_closed = false;
+
+public:
+    /**
+     * @return Slot of the key, nullptr if it does not exist
+     */
+    template<typename LookupType>
+    [[nodiscard]] std::shared_ptr<LatestValue<ValueType> > find(const LookupType &key) const {
+        const auto slots = m_slots.load();
+
+        if (const auto it = slots->find(key); it != slots->end()) {
+            return it->second;
+        }
+
+        return {};
+    }
+
+    /**
+     * @return Slot of the key, created if it does not exist
+     */
+    std::shared_ptr<LatestValue<ValueType> > slot(const KeyType &key) {
+        if (auto retVal = find(key)) {
+            return retVal;
+        }
+
+        std::lock_guard lk(m_insertLocker);
+        auto slots = std::make_shared<Slots>(*m_slots.load());
+        auto [it, inserted] = slots->try_emplace(key, std::make_shared<LatestValue<ValueType> >());
+
+        if (inserted) {
+            if (m_closed) {
+                it->second->close();
+            }
+
+            m_slots.store(std::move(slots));
+        }
+
+        return it->second;
+    }
+
+    /**
+     * Close all slots, present and future ones
+     */
+    void close() {
+        std::lock_guard lk(m_insertLocker);
+        m_closed = true;
+        const auto slots = m_slots.load();
+
+        for (const auto &slot: *slots | std::views::values) {
+            slot->close();
+        }
+    }
+};
+} // namespace stonky::okx
+#endif // INCLUDE_STONKY_OKX_LATEST_VALUE_H
@@ -0,0 +1,108 @@
+/**
+OKX Market Data Cache
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
+*/
+
+#ifndef INCLUDE_STONKY_OKX_MARKET_DATA_CACHE_H
+#define INCLUDE_STONKY_OKX_MARKET_DATA_CACHE_H
+
+#include "okx_models.h"
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace stonky::okx {
+struct MarketDataCacheOptions {
+    /// Directory of the cached files, created if it does not exist
+    std::filesystem::path directory{};
+
+    /// Total size of the cached files, the least recently used ones are removed above it
+    std::uint64_t maxBytes = 20ULL * 1024 * 1024 * 1024;
+
+    /// No downloads at all, a file missing in the cache is an error
+    bool offline = false;
+};
+
+struct MarketDataCacheStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+
+    /// Number of files written to the cache
+    std::uint64_t stores = 0;
+
+    /// Number of files removed to stay within maxBytes
+    std::uint64_t evictions = 0;
+
+    /// Number of cached files removed because their size or CRC did not match
+    std::uint64_t corrupted = 0;
+
+    /// Total size of the cached files
+    std::uint64_t bytes = 0;
+
+    std::size_t files = 0;
+};
+
+/**
+ * On-disk cache of the bulk market data ZIP files. Historical files never change, so a file is downloaded only once.
+ * Each file is stored under its name with the size and CRC32 of the content, e.g.
+ * "BTC-USDT-SWAP-candlesticks-2025-05-15.zip.184320.9f3a61c2", and verified against them when it is read. Files are
+ * written to a temporary file and renamed, so a crashed process never leaves a partial file behind. The last use of a
+ * file is its modification time, the cache survives restarts with its LRU order.
+ */
+class MarketDataCache {
+    struct P;
+    std::unique_ptr<P> m_p{};
+
+public:
+    /**
+     * Open the cache directory and index the files it contains
+     * @param options
+     * @throws std::runtime_error if the directory cannot be created
+     */
+    explicit MarketDataCache(const MarketDataCacheOptions &options);
+
+    ~MarketDataCache();
+
+    /**
+     * @param file file info from getMarketDataHistory, the key is the filename or the last segment of the URL
+     * @return Verified content of the file, nullopt if it is not cached or its content is corrupted
+     */
+    [[nodiscard]] std::optional<std::vector<std::uint8_t> > get(const MarketDataFileInfo &file) const;
+
+    /**
+     * Store a downloaded file, the least recently used files are removed if the cache exceeds maxBytes
+     * @param file file info from getMarketDataHistory
+     * @param data complete ZIP file
+     * @throws std::runtime_error if the data is not a complete ZIP file or cannot be written
+     */
+    void put(const MarketDataFileInfo &file, std::span<const std::uint8_t> data) const;
+
+    /**
+     * Get the file from the cache or download and store it
+     * @param file file info from getMarketDataHistory
+     * @param download called with the URL of a file which is not cached
+     * @return Content of the file
+     * @throws std::runtime_error if the file is not cached in offline mode or the download fails
+     */
+    [[nodiscard]] std::vector<std::uint8_t> fetch(const MarketDataFileInfo &file,
+                                                  const std::function<std::vector<std::uint8_t>(const std::string &)> &download) const;
+
+    [[nodiscard]] bool offline() const;
+
+    /**
+     * Remove all cached files
+     */
+    void clear() const;
+
+    [[nodiscard]] MarketDataCacheStats stats() const;
+};
+} // namespace stonky::okx
+#endif // INCLUDE_STONKY_OKX_MARKET_DATA_CACHE_H
@@ -10,13 +10,73 @@ Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
 #define INCLUDE_STONKY_OKX_MARKET_DATA_UTILS_H
 
 #include "okx_models.h"
-#include <vector>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <span>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace stonky::okx::utils {
+/// Size of the window the lines of a ZIP entry are read through, it grows only for a longer line
+inline constexpr std::size_t CSV_WINDOW_SIZE = 256 * 1024;
+
+/**
+ * Reader of the first entry of a ZIP archive, the entry is inflated chunk by chunk as it is read, so its size does not
+ * matter. Archives from memory are limited to 2 GB compressed by minizip, larger ones have to be read from a file.
+ */
+class ZipEntryReader {
+    struct P;
+    std::unique_ptr<P> m_p{};
+
+public:
+    /**
+     * @param zipData Raw ZIP file bytes, they must outlive the reader
+     * @throws std::runtime_error if the archive cannot be opened or is empty
+     */
+    explicit ZipEntryReader(std::span<const std::uint8_t> zipData);
+
+    /**
+     * @param zipFile path to the ZIP file
+     * @throws std::runtime_error if the archive cannot be opened or is empty
+     */
+    explicit ZipEntryReader(const std::filesystem::path &zipFile);
+
+    ~ZipEntryReader();
+
+    /**
+     * @return Uncompressed size of the entry as stored in the archive
+     */
+    [[nodiscard]] std::uint64_t uncompressedSize() const;
+
+    /**
+     * Inflate the next chunk of the entry
+     * @param data output buffer
+     * @param size size of the output buffer
+     * @return Number of bytes written, 0 at the end of the entry
+     * @throws std::runtime_error if the entry is corrupted
+     */
+    [[nodiscard]] std::size_t read(std::uint8_t *data, std::size_t size) const;
+};
+
+/// Called with every line without the line ending, returning false stops reading
+using onCsvLine = std::function<bool(std::string_view line)>;
+
+/**
+ * Read the ZIP entry through a fixed window and pass it line by line, the entry is never held in memory as a whole
+ * @param reader ZIP entry
+ * @param onCsvLineCB called with every line, the view is valid only during the call
+ * @param windowSize initial window size
+ * @return Number of uncompressed bytes read
+ * @throws std::runtime_error if the entry is corrupted
+ */
+std::uint64_t forEachCsvLine(const ZipEntryReader &reader, const onCsvLine &onCsvLineCB, std::size_t windowSize = CSV_WINDOW_SIZE);
 
 /**
- * Extract first file from ZIP archive stored in memory
+ * Extract first file from ZIP archive stored in memory. The whole entry is returned in one buffer, use
+ * parseCandlesZip or forEachCsvLine to process large entries in constant memory.
  * @param zipData Raw ZIP file bytes
  * @return Decompressed file content
  * @throws std::runtime_error if ZIP extraction fails
@@ -26,7 +86,7 @@ namespace stonky::okx::utils {
 /**
  * Parse 1-minute candlestick CSV data into Candle structures CSV format: ts,o,h,l,c,vol,volCcy,volCcyQuote,confirm
  * @param csvData Raw CSV bytes (UTF-8 encoded)
- * @return Vector of Candle structures
+ * @return Confirmed candles sorted by timestamp, rows repeating a timestamp are dropped
  * @throws std::runtime_error if CSV parsing fails
  */
 [[nodiscard]] std::vector<Candle> parseCandlesCsv(const std::vector<std::uint8_t> &csvData);
@@ -34,14 +94,41 @@ namespace stonky::okx::utils {
 /**
  * Parse 1-minute candlestick CSV data from string
  * @param csvContent CSV content as string
- * @return Vector of Candle structures
+ * @return Confirmed candles sorted by timestamp, rows repeating a timestamp are dropped
  */
 [[nodiscard]] std::vector<Candle> parseCandlesCsv(const std::string &csvContent);
 
+/**
+ * Parse 1-minute candlestick CSV of a ZIP archive while it is being inflated
+ * @param zipData Raw ZIP file bytes
+ * @param instId keep only rows of the instrument, files of an instrument family contain all its instruments, empty
+ * keeps all rows
+ * @return Confirmed candles sorted by timestamp, rows repeating a timestamp are dropped
+ * @throws std::runtime_error if ZIP extraction fails
+ */
+[[nodiscard]] std::vector<Candle> parseCandlesZip(const std::vector<std::uint8_t> &zipData, std::string_view instId = {});
+
+/**
+ * Parse 1-minute candlestick CSV of a ZIP file while it is being inflated
+ * @param zipFile path to the ZIP file
+ * @param instId keep only rows of the instrument, empty keeps all rows
+ * @return Confirmed candles sorted by timestamp, rows repeating a timestamp are dropped
+ * @throws std::runtime_error if ZIP extraction fails
+ */
+[[nodiscard]] std::vector<Candle> parseCandlesZip(const std::filesystem::path &zipFile, std::string_view instId = {});
+
+/**
+ * Merge runs of candles sorted by timestamp into one sorted vector (k-way merge), candles with the same timestamp
+ * keep the order of the runs
+ * @param runs e.g. parsed files of consecutive days
+ * @return All candles sorted by timestamp
+ */
+[[nodiscard]] std::vector<Candle> mergeSortedCandles(std::vector<std::vector<Candle> > runs);
+
 /**
  * Parse funding rate CSV data into FundingRate structures CSV format: instId,fundingRate,realizedRate,fundingTime
  * @param csvData Raw CSV bytes (UTF-8 encoded)
- * @return ector of FundingRate structures
+ * @return Funding rates sorted by funding time, rows repeating a funding time are dropped
  */
 [[nodiscard]] std::vector<FundingRate> parseFundingRateCsv(const std::vector<std::uint8_t> &csvData);
 
@@ -12,7 +12,7 @@ Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
 #include "stonky/interface/i_json.h"
 #include "stonky/okx/okx_enums.h"
 #include <nlohmann/json.hpp>
-#include <boost/multiprecision/cpp_dec_float.hpp>
+#include "stonky/okx/okx_decimal.h"
 
 namespace stonky::okx {
 struct Response : IJson {
@@ -32,45 +32,45 @@ struct Ticker final : IJson {
     std::string instId{};
 
     /// Last traded price
-    boost::multiprecision::cpp_dec_float_50 last{};
+    Decimal last{};
 
     /// Last traded size
-    boost::multiprecision::cpp_dec_float_50 lastSz{};
+    Decimal lastSz{};
 
     /// Best ask price
-    boost::multiprecision::cpp_dec_float_50 askPx{};
+    Decimal askPx{};
 
     /// Best ask size
-    boost::multiprecision::cpp_dec_float_50 askSz{};
+    Decimal askSz{};
 
     /// Best bid price
-    boost::multiprecision::cpp_dec_float_50 bidPx{};
+    Decimal bidPx{};
 
     /// Best bid size
-    boost::multiprecision::cpp_dec_float_50 bidSz{};
+    Decimal bidSz{};
 
     /// Open price in the past 24 hours
-    boost::multiprecision::cpp_dec_float_50 open24h{};
+    Decimal open24h{};
 
     /// Highest price in the past 24 hours
-    boost::multiprecision::cpp_dec_float_50 high24h{};
+    Decimal high24h{};
 
     /// Lowest price in the past 24 hours
-    boost::multiprecision::cpp_dec_float_50 low24h{};
+    Decimal low24h{};
 
     /// 24h trading volume, with a unit of currency. If it is a derivatives contract, the value is the number
     /// of base currency. If it is SPOT/MARGIN, the value is the quantity in quote currency.
-    boost::multiprecision::cpp_dec_float_50 volCcy24h{};
+    Decimal volCcy24h{};
 
     /// 24h trading volume, with a unit of contract. If it is a derivatives contract, the value is the number of
     /// contracts. If it is SPOT/MARGIN, the value is the quantity in base currency.
-    boost::multiprecision::cpp_dec_float_50 vol24h{};
+    Decimal vol24h{};
 
     /// Open price in the UTC 0
-    boost::multiprecision::cpp_dec_float_50 sodUtc0{};
+    Decimal sodUtc0{};
 
     /// Open price in the UTC 8
-    boost::multiprecision::cpp_dec_float_50 sodUtc8{};
+    Decimal sodUtc8{};
 
     /// Ticker data generation time, Unix timestamp format in milliseconds
     std::int64_t ts{};
@@ -91,19 +91,19 @@ struct Tickers final : Response {
 struct Candle final : IJson {
     /// Opening time of the candlestick
     std::int64_t ts{};
-    boost::multiprecision::cpp_dec_float_50 o{};
-    boost::multiprecision::cpp_dec_float_50 h{};
-    boost::multiprecision::cpp_dec_float_50 l{};
-    boost::multiprecision::cpp_dec_float_50 c{};
-    boost::multiprecision::cpp_dec_float_50 vol{};
+    Decimal o{};
+    Decimal h{};
+    Decimal l{};
+    Decimal c{};
+    Decimal vol{};
 
     /// Trading volume, with a unit of currency. If it is a derivatives contract, the value is the number of base
     /// currency. If it is SPOT/MARGIN, the value is the quantity in quote currency.
-    boost::multiprecision::cpp_dec_float_50 volCcy{};
+    Decimal volCcy{};
 
     /// Trading volume, the value is the quantity in quote currency, e.g. the unit is USDT for BTC-USDT and BTC-USDT-SWAP;
     /// The unit is USD for BTC-USD-SWAP
-    boost::multiprecision::cpp_dec_float_50 volCcyQuote{};
+    Decimal volCcyQuote{};
 
     /// The state of candlesticks. False represents that it is uncompleted, True represents that it is completed.
     bool confirm{};
@@ -124,17 +124,17 @@ struct Candles final : Response {
 struct FundingRate final : Response {
     InstrumentType instType{InstrumentType::SPOT};
     std::string instId{};
-    boost::multiprecision::cpp_dec_float_50 fundingRate{};
+    Decimal fundingRate{};
     std::int64_t fundingTime{};
     std::int64_t nextFundingTime{};
-    boost::multiprecision::cpp_dec_float_50 nextFundingRate{};
-    boost::multiprecision::cpp_dec_float_50 interestRate{};
-    boost::multiprecision::cpp_dec_float_50 premium{};
-    boost::multiprecision::cpp_dec_float_50 maxFundingRate{};
-    boost::multiprecision::cpp_dec_float_50 minFundingRate{};
+    Decimal nextFundingRate{};
+    Decimal interestRate{};
+    Decimal premium{};
+    Decimal maxFundingRate{};
+    Decimal minFundingRate{};
     std::int64_t ts{};
     SettState settState = SettState::processing;
-    boost::multiprecision::cpp_dec_float_50 settFundingRate{};
+    Decimal settFundingRate{};
 
     [[nodiscard]] nlohmann::json toJson() const override;
 
@@ -171,10 +171,10 @@ struct Instrument final : IJson {
     std::string settleCcy{};
 
     /// Contract value, only applicable to FUTURES/SWAP/OPTION
-    boost::multiprecision::cpp_dec_float_50 ctVal{};
+    Decimal ctVal{};
 
     /// Contract multiplier, only applicable to FUTURES/SWAP/OPTION
-    boost::multiprecision::cpp_dec_float_50 ctMult{};
+    Decimal ctMult{};
 
     /// Contract value currency, only applicable to FUTURES/SWAP/OPTIO
     std::string ctValCcy{};
@@ -183,7 +183,7 @@ struct Instrument final : IJson {
     OptionType optType{OptionType::C};
 
     /// Strike price, only applicable to OPTION
-    boost::multiprecision::cpp_dec_float_50 stk{};
+    Decimal stk{};
 
     /// Listing time, Unix timestamp format in milliseconds
     std::int64_t listTime{};
@@ -192,17 +192,17 @@ struct Instrument final : IJson {
     std::int64_t expTime{};
 
     /// Max Leverage, not applicable to SPOT, OPTION
-    boost::multiprecision::cpp_dec_float_50 lever{};
+    Decimal lever{};
 
     /// Tick size, e.g. 0.0001
-    boost::multiprecision::cpp_dec_float_50 tickSz{};
+    Decimal tickSz{};
 
     /// Lot size, e.g. BTC-USDT-SWAP: 1
-    boost::multiprecision::cpp_dec_float_50 lotSz{};
+    Decimal lotSz{};
 
     /// Minimum order size. If it is a derivatives contract, the value is the number of contracts. If it is SPOT/MARGIN,
     /// the value is the quantity in base currency
-    boost::multiprecision::cpp_dec_float_50 minSz{};
+    Decimal minSz{};
 
     /// Contract type, linear: linear contract, inverse: inverse contract, only applicable to FUTURES/SWAP
     ContractType ctType{ContractType::linear};
@@ -215,27 +215,27 @@ struct Instrument final : IJson {
 
     /// The maximum order quantity of the contract or spot limit order. If it is a derivatives contract, the value
     /// is the number of contracts. If it is SPOT/MARGIN, the value is the quantity in base currency
-    boost::multiprecision::cpp_dec_float_50 maxLmtSz{};
+    Decimal maxLmtSz{};
 
     /// The maximum order quantity of the contract or spot market order. If it is a derivatives contract, the value is
     /// the number of contracts. If it is SPOT/MARGIN, the value is the quantity in "USDT
-    boost::multiprecision::cpp_dec_float_50 maxMktSz{};
+    Decimal maxMktSz{};
 
     /// The maximum order quantity of the contract or spot twap order. If it is a derivatives contract, the value is
     /// the number of contracts. If it is SPOT/MARGIN, the value is the quantity in base currency.
-    boost::multiprecision::cpp_dec_float_50 maxTwapSz{};
+    Decimal maxTwapSz{};
 
     /// The maximum order quantity of the contract or spot iceBerg order. If it is a derivatives contract, the value
     /// is the number of contracts. If it is SPOT/MARGIN, the value is the quantity in base currency.
-    boost::multiprecision::cpp_dec_float_50 maxIcebergSz{};
+    Decimal maxIcebergSz{};
 
     /// The maximum order quantity of the contract or spot trigger order. If it is a derivatives contract, the value is
     /// the number of contracts. If it is SPOT/MARGIN, the value is the quantity in base currency.
-    boost::multiprecision::cpp_dec_float_50 maxTriggerSz{};
+    Decimal maxTriggerSz{};
 
     /// The maximum order quantity of the contract or spot stop market order. If it is a derivatives contract, the
     /// value is the number of contracts. If it is SPOT/MARGIN, the value is the quantity in "USDT".
-    boost::multiprecision::cpp_dec_float_50 maxStopSz{};
+    Decimal maxStopSz{};
 
     [[nodiscard]] nlohmann::json toJson() const override;
 
@@ -251,30 +251,30 @@ struct Instruments final : Response {
 };
 
 struct BalanceDetail final : IJson {
-    boost::multiprecision::cpp_dec_float_50 availBal{};
-    boost::multiprecision::cpp_dec_float_50 availEq{};
-    boost::multiprecision::cpp_dec_float_50 cashBal{};
+    Decimal availBal{};
+    Decimal availEq{};
+    Decimal cashBal{};
     std::string ccy{};
-    boost::multiprecision::cpp_dec_float_50 crossLiab{};
-    boost::multiprecision::cpp_dec_float_50 disEq{};
-    boost::multiprecision::cpp_dec_float_50 eq{};
-    boost::multiprecision::cpp_dec_float_50 eqUsd{};
-    boost::multiprecision::cpp_dec_float_50 frozenBal{};
-    boost::multiprecision::cpp_dec_float_50 interest{};
-    boost::multiprecision::cpp_dec_float_50 isoEq{};
-    boost::multiprecision::cpp_dec_float_50 isoLiab{};
-    boost::multiprecision::cpp_dec_float_50 isoUpl{};
-    boost::multiprecision::cpp_dec_float_50 liab{};
-    boost::multiprecision::cpp_dec_float_50 maxLoan{};
-    boost::multiprecision::cpp_dec_float_50 mgnRatio{};
-    boost::multiprecision::cpp_dec_float_50 notionalLever{};
-    boost::multiprecision::cpp_dec_float_50 ordFrozen{};
-    boost::multiprecision::cpp_dec_float_50 twap{};
-    boost::multiprecision::cpp_dec_float_50 upl{};
+    Decimal crossLiab{};
+    Decimal disEq{};
+    Decimal eq{};
+    Decimal eqUsd{};
+    Decimal frozenBal{};
+    Decimal interest{};
+    Decimal isoEq{};
+    Decimal isoLiab{};
+    Decimal isoUpl{};
+    Decimal liab{};
+    Decimal maxLoan{};
+    Decimal mgnRatio{};
+    Decimal notionalLever{};
+    Decimal ordFrozen{};
+    Decimal twap{};
+    Decimal upl{};
     std::int64_t uTime{};
-    boost::multiprecision::cpp_dec_float_50 uplLiab{};
-    boost::multiprecision::cpp_dec_float_50 stgyEq{};
-    boost::multiprecision::cpp_dec_float_50 spotInUseAmt{};
+    Decimal uplLiab{};
+    Decimal stgyEq{};
+    Decimal spotInUseAmt{};
 
     [[nodiscard]] nlohmann::json toJson() const override;
 
@@ -282,14 +282,14 @@ struct BalanceDetail final : IJson {
 };
 
 struct Balance final : Response {
-    boost::multiprecision::cpp_dec_float_50 adjEq{};
-    boost::multiprecision::cpp_dec_float_50 imr{};
-    boost::multiprecision::cpp_dec_float_50 isoEq{};
-    boost::multiprecision::cpp_dec_float_50 mgnRatio{};
-    boost::multiprecision::cpp_dec_float_50 mmr{};
-    boost::multiprecision::cpp_dec_float_50 notionalUsd{};
-    boost::multiprecision::cpp_dec_float_50 ordFroz{};
-    boost::multiprecision::cpp_dec_float_50 totalEq{};
+    Decimal adjEq{};
+    Decimal imr{};
+    Decimal isoEq{};
+    Decimal mgnRatio{};
+    Decimal mmr{};
+    Decimal notionalUsd{};
+    Decimal ordFroz{};
+    Decimal totalEq{};
     std::int64_t uTime{};
 
     std::vector<BalanceDetail> balanceDetails{};
@@ -309,33 +309,33 @@ struct SystemTime final : Response {
 
 struct Position final : IJson {
     std::int32_t adl{};
-    boost::multiprecision::cpp_dec_float_50 availPos{};
-    boost::multiprecision::cpp_dec_float_50 avgPx{};
+    Decimal availPos{};
+    Decimal avgPx{};
     std::int64_t cTime{};
     std::string ccy{};
-    boost::multiprecision::cpp_dec_float_50 imr{};
+    Decimal imr{};
     std::string instId{};
     InstrumentType instType{InstrumentType::MARGIN};
-    boost::multiprecision::cpp_dec_float_50 interest{};
-    boost::multiprecision::cpp_dec_float_50 last{};
-    boost::multiprecision::cpp_dec_float_50 lever{};
-    boost::multiprecision::cpp_dec_float_50 liab{};
+    Decimal interest{};
+    Decimal last{};
+    Decimal lever{};
+    Decimal liab{};
     std::string liabCcy{};
-    boost::multiprecision::cpp_dec_float_50 liqPx{};
-    boost::multiprecision::cpp_dec_float_50 margin{};
-    boost::multiprecision::cpp_dec_float_50 markPx{};
+    Decimal liqPx{};
+    Decimal margin{};
+    Decimal markPx{};
     MarginMode mgnMode{MarginMode::cross};
-    boost::multiprecision::cpp_dec_float_50 mgnRatio{};
-    boost::multiprecision::cpp_dec_float_50 mmr{};
-    boost::multiprecision::cpp_dec_float_50 notionalUsd{};
-    boost::multiprecision::cpp_dec_float_50 pos{};
+    Decimal mgnRatio{};
+    Decimal mmr{};
+    Decimal notionalUsd{};
+    Decimal pos{};
     std::string posCcy{};
     std::string posId{};
     PositionSide posSide{PositionSide::_net};
     std::string tradeId{};
     std::int64_t uTime{};
-    boost::multiprecision::cpp_dec_float_50 upl{};
-    boost::multiprecision::cpp_dec_float_50 uplRatio{};
+    Decimal upl{};
+    Decimal uplRatio{};
 
     [[nodiscard]] nlohmann::json toJson() const override;
 
@@ -358,8 +358,8 @@ struct Order final : IJson {
     std::string ccy{};
     PositionSide posSide{PositionSide::_net};
     OrderType ordType{OrderType::market};
-    boost::multiprecision::cpp_dec_float_50 sz{};
-    boost::multiprecision::cpp_dec_float_50 px{};
+    Decimal sz{};
+    Decimal px{};
 
     [[nodiscard]] nlohmann::json toJson() const override;
 
@@ -392,21 +392,21 @@ struct OrderDetail final : IJson {
     std::string ccy{};
     std::string ordId{};
     std::string clOrdId{};
-    boost::multiprecision::cpp_dec_float_50 px{};
-    boost::multiprecision::cpp_dec_float_50 sz{};
-    boost::multiprecision::cpp_dec_float_50 pnl{};
+    Decimal px{};
+    Decimal sz{};
+    Decimal pnl{};
     OrderType ordType{OrderType::market};
     Side side{Side::buy};
     PositionSide posSide{PositionSide::_long};
     MarginMode tdMode = MarginMode::isolated;
-    boost::multiprecision::cpp_dec_float_50 accFillSz{};
-    boost::multiprecision::cpp_dec_float_50 fillPx{};
+    Decimal accFillSz{};
+    Decimal fillPx{};
     std::string tradeId{};
-    boost::multiprecision::cpp_dec_float_50 fillSz{};
+    Decimal fillSz{};
     std::int64_t fillTime{};
     OrderState state{OrderState::live};
-    boost::multiprecision::cpp_dec_float_50 avgPx{};
-    boost::multiprecision::cpp_dec_float_50 lever{};
+    Decimal avgPx{};
+    Decimal lever{};
     std::int64_t uTime{};
     std::int64_t cTime{};
 
@@ -0,0 +1,104 @@
+/**
+OKX Order Book
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
+*/
+
+#ifndef INCLUDE_STONKY_OKX_ORDER_BOOK_H
+#define INCLUDE_STONKY_OKX_ORDER_BOOK_H
+
+#include "okx_event_models.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace stonky::okx {
+enum class OrderBookUpdate : std::int32_t {
+    applied,
+    /// Update received before the first snapshot, ignored
+    noSnapshot,
+    /// prevSeqId does not match the seqId of the previous message, the book is cleared
+    sequenceGap,
+    /// Book does not match the checksum of the message, the book is cleared
+    checksumMismatch
+};
+
+/**
+ * Local L2 order book maintained from snapshot and update messages. Each side is a flat ladder of levels indexed by
+ * the price in ticks, so a level update is an array write and the best price is tracked incrementally.
+ */
+class OrderBook {
+    struct P;
+    std::unique_ptr<P> m_p{};
+
+public:
+    /**
+     * @param channel books, books5, bbo-tbt, books-l2-tbt or books50-l2-tbt, decides whether the messages carry
+     * sequence ids and a checksum
+     */
+    explicit OrderBook(std::string_view channel = "books");
+
+    OrderBook(OrderBook &&) noexcept;
+
+    OrderBook &operator=(OrderBook &&) noexcept;
+
+    ~OrderBook();
+
+    /**
+     * Apply snapshot or update message
+     * @param event message of the book's channel and instrument
+     * @return applied or the reason why the message was rejected, a rejected book waits for a new snapshot
+     */
+    OrderBookUpdate apply(const DataEventOrderBook &event) const;
+
+    /**
+     * Enable or disable checksum verification of updates, enabled by default
+     */
+    void setVerifyChecksum(bool verify) const;
+
+    /**
+     * Remove all levels, the book then waits for a snapshot
+     */
+    void clear() const;
+
+    /**
+     * @return True after a snapshot has been applied and no update has been rejected since
+     */
+    [[nodiscard]] bool isValid() const;
+
+    [[nodiscard]] std::optional<BookLevel> bestBid() const;
+
+    [[nodiscard]] std::optional<BookLevel> bestAsk() const;
+
+    /**
+     * @param depth maximum number of levels
+     * @return Bid levels, best first
+     */
+    [[nodiscard]] std::vector<BookLevel> bids(std::size_t depth) const;
+
+    /**
+     * @param depth maximum number of levels
+     * @return Ask levels, best first
+     */
+    [[nodiscard]] std::vector<BookLevel> asks(std::size_t depth) const;
+
+    [[nodiscard]] std::size_t bidLevels() const;
+
+    [[nodiscard]] std::size_t askLevels() const;
+
+    [[nodiscard]] std::int64_t seqId() const;
+
+    [[nodiscard]] std::int64_t ts() const;
+
+    /**
+     * OKX checksum of the current book, CRC32 of "bid1Px:bid1Sz:ask1Px:ask1Sz:..." over the best 25 levels
+     */
+    [[nodiscard]] std::int32_t checksum() const;
+};
+} // namespace stonky::okx
+#endif // INCLUDE_STONKY_OKX_ORDER_BOOK_H
@@ -0,0 +1,140 @@
+/**
+OKX Rate Limiter
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
+*/
+
+#ifndef INCLUDE_STONKY_OKX_RATE_LIMITER_H
+#define INCLUDE_STONKY_OKX_RATE_LIMITER_H
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace stonky::okx {
+struct RateLimitRule {
+    /// Maximum number of requests in the window as documented by OKX
+    std::size_t limit = 10;
+
+    /// Length of the window
+    std::chrono::milliseconds window{2000};
+
+    /// Number of requests which can be sent at once, the bucket is refilled with (limit - burst) tokens per window
+    /// so that no window can ever contain more than limit requests
+    std::size_t burst = 1;
+
+    /// Name of the request parameter the limit is applied to separately (e.g. "instId"), empty if the limit is
+    /// shared by all requests to the endpoint
+    std::string keyParameter{};
+};
+
+struct RateLimiterStats {
+    /// Endpoint (and key parameter value) of the bucket, e.g. "GET /api/v5/public/funding-rate|BTC-USDT-SWAP"
+    std::string key{};
+
+    std::uint64_t requests = 0;
+
+    /// Number of requests which had to wait for a token
+    std::uint64_t delayedRequests = 0;
+
+    std::chrono::microseconds totalWait{};
+    std::chrono::microseconds maxWait{};
+
+    /// Number of requests rejected by the server because of rate limit (HTTP 429 or OKX code 50011)
+    std::uint64_t throttledResponses = 0;
+
+    /// Currently learned sustainable rate in requests per second
+    double currentRate = 0.0;
+};
+
+/**
+ * Lock-free token bucket implemented as GCRA (generic cell rate algorithm), the whole bucket state is one atomic
+ * theoretical arrival time. Callers reserve a token and wait for the returned time outside of any lock.
+ *
+ * The emission interval adapts to server feedback (AIMD): a rate limit rejection doubles the interval, drops the
+ * burst and pushes all callers back, every successful response shortens the interval a little until the configured
+ * rate is restored. The rate never exceeds the configured one, the burst on top of it already uses the whole limit.
+ */
+class RateLimiter {
+    std::atomic<std::int64_t> m_theoreticalArrivalNs{0};
+    std::atomic<std::int64_t> m_intervalNs{0};
+    std::int64_t m_baseIntervalNs;
+    std::int64_t m_maxIntervalNs;
+    std::int64_t m_toleranceNs;
+
+    std::atomic<std::uint64_t> m_requests{0};
+    std::atomic<std::uint64_t> m_delayedRequests{0};
+    std::atomic<std::int64_t> m_totalWaitNs{0};
+    std::atomic<std::int64_t> m_maxWaitNs{0};
+    std::atomic<std::uint64_t> m_throttledResponses{0};
+
+public:
+    explicit RateLimiter(const RateLimitRule &rule);
+
+    /**
+     * Reserve a token for one request
+     * @param headroom fraction of the burst which has to stay available for other callers, 0 uses the whole bucket
+     * @return how long the caller has to wait before sending the request
+     */
+    [[nodiscard]] std::chrono::nanoseconds reserve(double headroom = 0.0);
+
+    /**
+     * Report request accepted by the server, a throttled rate recovers towards the configured one
+     */
+    void onSuccess();
+
+    /**
+     * Report request rejected by the server because of rate limit, the rate is halved and the burst dropped
+     * @return time for which all callers of the bucket are pushed back
+     */
+    std::chrono::nanoseconds onThrottled();
+
+    [[nodiscard]] RateLimiterStats stats() const;
+};
+
+/**
+ * Rate limiters of all REST endpoints, preloaded with limits documented by OKX. Buckets are created lazily for
+ * every endpoint (and key parameter value, e.g. instrument id, where OKX applies the limit per instrument).
+ */
+class RateLimiterRegistry {
+    mutable std::mutex m_locker;
+    std::map<std::string, RateLimitRule, std::less<> > m_rules;
+    std::map<std::string, std::unique_ptr<RateLimiter>, std::less<> > m_limiters;
+    RateLimitRule m_defaultRule;
+
+public:
+    RateLimiterRegistry();
+
+    /**
+     * Set or replace rule for an endpoint, already existing buckets of the endpoint are not affected
+     * @param method e.g. "GET"
+     * @param path e.g. "/api/v5/market/tickers"
+     * @param rule
+     */
+    void setRule(std::string_view method, std::string_view path, const RateLimitRule &rule);
+
+    /**
+     * Get rule for an endpoint, default rule if the endpoint is not known
+     */
+    [[nodiscard]] RateLimitRule rule(std::string_view method, std::string_view path) const;
+
+    /**
+     * Get bucket for a request, the returned reference stays valid for the whole life of the registry
+     * @param method e.g. "GET"
+     * @param path e.g. "/api/v5/market/tickers"
+     * @param parameters request parameters, value of the rule's key parameter selects the bucket
+     * @return
+     */
+    [[nodiscard]] RateLimiter &limiter(std::string_view method, std::string_view path, const std::map<std::string, std::string> &parameters);
+
+    [[nodiscard]] std::vector<RateLimiterStats> stats() const;
+};
+} // namespace stonky::okx
+#endif // INCLUDE_STONKY_OKX_RATE_LIMITER_H
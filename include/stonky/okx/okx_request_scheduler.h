@@ -0,0 +1,119 @@
+/**
+OKX Request Scheduler
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
+*/
+
+#ifndef INCLUDE_STONKY_OKX_REQUEST_SCHEDULER_H
+#define INCLUDE_STONKY_OKX_REQUEST_SCHEDULER_H
+
+#include <boost/asio/awaitable.hpp>
+#include <array>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace stonky::okx {
+enum class RequestLane : std::size_t {
+    /// Order placement, cancellation and account queries, always served first
+    Trading = 0,
+    /// Market data and history backfill, uses only what trading leaves
+    History = 1
+};
+
+struct RequestSchedulerOptions {
+    /// Maximum number of requests in flight across all lanes
+    std::size_t maxConcurrentRequests = 8;
+
+    /// Number of in-flight slots the history lane can never take
+    std::size_t reservedTradingSlots = 2;
+
+    /// Fraction of every rate limiter's burst the history lane leaves unused for trading requests
+    double historyRateHeadroom = 0.25;
+};
+
+struct RequestLaneStats {
+    std::size_t queueDepth = 0;
+    std::size_t maxQueueDepth = 0;
+    std::size_t inFlight = 0;
+    std::uint64_t requests = 0;
+
+    /// Number of requests which had to wait for a slot
+    std::uint64_t queuedRequests = 0;
+
+    std::chrono::microseconds totalWait{};
+    std::chrono::microseconds maxWait{};
+};
+
+/**
+ * Admission control of REST requests with priority lanes. Queued trading requests are always admitted before
+ * queued history requests and the history lane never occupies the slots reserved for trading.
+ */
+class RequestScheduler {
+public:
+    /**
+     * Admitted request, the slot is released when the permit is destroyed
+     */
+    class Permit {
+        RequestScheduler *m_scheduler = nullptr;
+        RequestLane m_lane = RequestLane::Trading;
+
+    public:
+        Permit() = default;
+
+        Permit(RequestScheduler *scheduler, RequestLane lane);
+
+        Permit(Permit &&other) noexcept;
+
+        Permit &operator=(Permit &&other) noexcept;
+
+        Permit(const Permit &) = delete;
+
+        Permit &operator=(const Permit &) = delete;
+
+        ~Permit();
+    };
+
+private:
+    struct Waiter {
+        std::function<void()> resume;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    struct Lane {
+        std::deque<Waiter> waiters;
+        RequestLaneStats stats;
+    };
+
+    mutable std::mutex m_locker;
+    RequestSchedulerOptions m_options;
+    std::array<Lane, 2> m_lanes;
+    std::size_t m_inFlight = 0;
+
+    [[nodiscard]] bool canAdmit(RequestLane lane) const;
+
+    void admit(RequestLane lane, std::chrono::steady_clock::duration wait);
+
+    void release(RequestLane lane);
+
+public:
+    explicit RequestScheduler(const RequestSchedulerOptions &options = {});
+
+    void setOptions(const RequestSchedulerOptions &options);
+
+    [[nodiscard]] RequestSchedulerOptions options() const;
+
+    /**
+     * Wait for a free slot in the lane
+     * @param lane
+     * @return permit which holds the slot until destroyed
+     */
+    boost::asio::awaitable<Permit> acquire(RequestLane lane);
+
+    [[nodiscard]] RequestLaneStats stats(RequestLane lane) const;
+};
+} // namespace stonky::okx
+#endif // INCLUDE_STONKY_OKX_REQUEST_SCHEDULER_H
@@ -0,0 +1,72 @@
+/**
+OKX Request Signer
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
+*/
+
+#ifndef INCLUDE_STONKY_OKX_REQUEST_SIGNER_H
+#define INCLUDE_STONKY_OKX_REQUEST_SIGNER_H
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace stonky::okx {
+/**
+ * Computes OK-ACCESS-SIGN and OK-ACCESS-TIMESTAMP values. The HMAC-SHA256 key schedule is computed only once per
+ * credential set and signing itself does not allocate, the results are written into fixed size buffers.
+ * @see https://www.okx.com/docs-v5/en/#overview-rest-authentication-making-requests
+ */
+class RequestSigner {
+    struct P;
+    std::unique_ptr<P> m_p{};
+
+public:
+    /// ISO 8601 timestamp with milliseconds, e.g. 2020-12-08T09:08:57.715Z
+    static constexpr std::size_t TIMESTAMP_LENGTH = 24;
+
+    /// Base64 encoded HMAC-SHA256 digest
+    static constexpr std::size_t SIGNATURE_LENGTH = 44;
+
+    struct Signature {
+        std::array<char, TIMESTAMP_LENGTH> timestampBuffer{};
+        std::array<char, SIGNATURE_LENGTH + 1> signBuffer{};
+
+        [[nodiscard]] std::string_view timestamp() const { return {timestampBuffer.data(), TIMESTAMP_LENGTH}; }
+
+        [[nodiscard]] std::string_view sign() const { return {signBuffer.data(), SIGNATURE_LENGTH}; }
+    };
+
+    explicit RequestSigner(const std::string &apiSecret);
+
+    ~RequestSigner();
+
+    RequestSigner(const RequestSigner &) = delete;
+
+    RequestSigner &operator=(const RequestSigner &) = delete;
+
+    /**
+     * Sign request, the signed message is timestamp + method + requestPath + body
+     * @param method "GET" or "POST"
+     * @param requestPath path including the query string, e.g. /api/v5/account/balance?ccy=BTC
+     * @param body request body, empty for GET requests
+     * @param now time of the request
+     * @param signature out: timestamp and signature
+     * @throws std::runtime_error if OpenSSL fails
+     */
+    void sign(std::string_view method, std::string_view requestPath, std::string_view body, std::chrono::system_clock::time_point now,
+              Signature &signature) const;
+
+    /**
+     * Format time as ISO 8601 UTC timestamp with milliseconds
+     * @param time
+     * @param buffer out: exactly TIMESTAMP_LENGTH characters, not null terminated
+     */
+    static void formatTimestamp(std::chrono::system_clock::time_point time, std::array<char, TIMESTAMP_LENGTH> &buffer);
+};
+} // namespace stonky::okx
+#endif // INCLUDE_STONKY_OKX_REQUEST_SIGNER_H
@@ -10,6 +10,11 @@ Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
 #define OKX_REST_CLIENT_H
 
 #include "okx_models.h"
+#include "okx_market_data_cache.h"
+#include "okx_rate_limiter.h"
+#include "okx_request_scheduler.h"
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
 #include <string>
 #include <memory>
 
@@ -17,15 +22,151 @@ namespace stonky::okx {
 
 using onCandlesDownloaded = std::function<void(const std::vector<Candle>&)>;
 
+/// Budgets of the download / inflate / parse pipeline of bulk market data files
+struct MarketDataPipelineOptions {
+    /// Files downloaded at the same time, each download also waits for a History lane slot of the scheduler
+    std::size_t maxDownloads = 4;
+
+    /// Threads inflating and parsing the downloaded files
+    std::size_t maxParsers = 2;
+
+    /// Downloaded ZIP bytes not parsed yet. It is checked before a download starts, so it can be exceeded by the
+    /// downloads in progress. A file larger than the budget is let through alone.
+    std::size_t maxBufferedBytes = 256 * 1024 * 1024;
+
+    /// Keep only candles of this instrument, files of an instrument family contain all its instruments. Empty keeps
+    /// all candles.
+    std::string instId{};
+};
+
+enum class BackfillSource : std::int32_t {
+    /// Daily 1m candle files of the market data history module
+    zip,
+    /// Paged history-candles endpoint
+    rest
+};
+
+struct BackfillOptions {
+    /// Cost of one daily ZIP file (download and parsing) in REST page requests. A day is taken from its ZIP file only
+    /// if the file is cheaper than the pages of the day (15 pages of 1m candles).
+    double zipFileCost = 4.0;
+
+    /// REST shards downloaded at the same time
+    std::size_t maxRestConcurrency = 8;
+
+    /// Download missing candles found by the continuity check from REST once more
+    bool repairGaps = true;
+
+    MarketDataPipelineOptions pipeline{};
+};
+
+/// Sub-range of a backfill served by one source
+struct BackfillStep {
+    BackfillSource source{BackfillSource::rest};
+
+    /// Open time of the first candle, inclusive
+    std::int64_t from{};
+
+    /// Open time of the last candle, inclusive
+    std::int64_t to{};
+
+    /// Files of a zip step, one per day
+    std::vector<MarketDataFileInfo> files{};
+
+    /// Estimated cost in REST page requests
+    double cost{};
+};
+
+struct BackfillPlan {
+    /// Consecutive sub-ranges covering the whole range in chronological order
+    std::vector<BackfillStep> steps{};
+
+    /// Requests spent on listing the ZIP files while planning
+    std::size_t listingRequests{};
+
+    /// Estimated cost of all steps in REST page requests
+    double cost{};
+};
+
+struct CandleGap {
+    /// Open time of the first missing candle
+    std::int64_t from{};
+
+    /// Open time of the last missing candle
+    std::int64_t to{};
+};
+
+struct BackfillResult {
+    /// Candles in chronological order, empty if a writer is given
+    std::vector<Candle> candles{};
+    std::size_t zipCandles{};
+    std::size_t restCandles{};
+
+    /// Candles delivered by both sources at a seam, the first one is kept
+    std::size_t duplicates{};
+
+    /// Missing candles left after the repair, OKX has no candles e.g. for some maintenance windows
+    std::vector<CandleGap> gaps{};
+};
+
 class RESTClient {
     struct P;
     std::unique_ptr<P> m_p{};
 
 public:
+    /**
+     * Create client with its own I/O thread
+     * @param apiKey
+     * @param apiSecret
+     * @param passphrase
+     */
     RESTClient(const std::string &apiKey, const std::string &apiSecret, const std::string &passphrase);
 
+    /**
+     * Create client performing all I/O on the caller supplied executor. The synchronous methods then must not be
+     * called from the executor's threads, use the asynchronous (awaitable) versions there.
+     * @param executor
+     * @param apiKey
+     * @param apiSecret
+     * @param passphrase
+     */
+    RESTClient(const boost::asio::any_io_executor &executor, const std::string &apiKey, const std::string &apiSecret, const std::string &passphrase);
+
     ~RESTClient();
 
+    /**
+     * Get the executor used for all network I/O of the client
+     * @return
+     */
+    [[nodiscard]] boost::asio::any_io_executor executor() const;
+
+    /**
+     * Get request and wait statistics of all endpoint rate limiters used so far
+     * @return
+     */
+    [[nodiscard]] std::vector<RateLimiterStats> rateLimiterStats() const;
+
+    /**
+     * Override the preloaded rate limit of an endpoint, it has to be called before the first request to the endpoint
+     * @param method e.g. "GET"
+     * @param path e.g. "/api/v5/market/tickers"
+     * @param rule
+     */
+    void setRateLimitRule(const std::string &method, const std::string &path, const RateLimitRule &rule) const;
+
+    /**
+     * Set admission options of the trading and history request lanes
+     * @param options
+     */
+    void setRequestSchedulerOptions(const RequestSchedulerOptions &options) const;
+
+    /**
+     * Get queue depth and wait-time statistics of a request lane
+     * @param lane
+     * @return
+     */
+    [[nodiscard]] RequestLaneStats requestLaneStats(RequestLane lane) const;
+
     /**
      * Set credentials to the RESTClient instance, it will reset the underlying HTTP Session
      * @param apiKey
@@ -42,6 +183,11 @@ public:
      */
     [[nodiscard]] std::vector<Ticker> getTickers(InstrumentType instrumentType) const;
 
+    /**
+     * Asynchronous version of getTickers()
+     */
+    [[nodiscard]] boost::asio::awaitable<std::vector<Ticker> > asyncGetTickers(InstrumentType instrumentType) const;
+
     /**
      * Retrieve a list of instruments with open contracts.
      * @param instrumentType
@@ -51,6 +197,11 @@ public:
      */
     [[nodiscard]] std::vector<Instrument> getInstruments(InstrumentType instrumentType, bool force = false) const;
 
+    /**
+     * Asynchronous version of getInstruments()
+     */
+    [[nodiscard]] boost::asio::awaitable<std::vector<Instrument> > asyncGetInstruments(InstrumentType instrumentType, bool force = false) const;
+
     /**
      * Set Instruments from the outside
      * @param instruments
@@ -64,8 +215,9 @@ public:
      * @param from timestamp in ms, must be smaller than "to"
      * @param to timestamp in ms, must be bigger than "from"
      * @param limit maximum number of returned candles, maximum and also the default value is 100
-     * @param writer
-     * @return vector of Candle structures
+     * @param writer called on the calling thread with every downloaded page (newest page first), pages passed to the
+     * writer are not accumulated in the returned vector
+     * @return vector of Candle structures, empty if writer is given
      * @throws nlohmann::json::exception, std::exception
      * @see https://www.okx.com/docs-v5/en/#rest-api-market-data-get-candlesticks-history
      */
@@ -73,6 +225,72 @@ public:
     getHistoricalPrices(const std::string &instId, BarSize barSize, std::int64_t from, std::int64_t to,
                         std::int32_t limit = -1, const onCandlesDownloaded &writer = {}) const;
 
+    /**
+     * Asynchronous version of getHistoricalPrices(), the writer is called on the client's executor. It must not block
+     * and must not call the synchronous methods of the client, the executor would deadlock.
+     */
+    [[nodiscard]] boost::asio::awaitable<std::vector<Candle> >
+    asyncGetHistoricalPrices(std::string instId, BarSize barSize, std::int64_t from, std::int64_t to, std::int32_t limit = -1,
+                             onCandlesDownloaded writer = {}) const;
+
+    /**
+     * Download historical candles in parallel. The [from, to] range is split up front into shards of one full page
+     * each, up to maxConcurrency shards are downloaded at the same time (paced by the rate limiter) and stitched
+     * together in order.
+     * @param instId instrument Id, e.g. "ETH-USDT-SWAP"
+     * @param barSize
+     * @param from timestamp in ms, must be smaller than "to"
+     * @param to timestamp in ms, must be bigger than "from"
+     * @param maxConcurrency maximum number of shards being downloaded at the same time
+     * @param writer called on the calling thread with every shard in chronological order (oldest candle first) as
+     * soon as all older shards are downloaded
+     * @return vector of Candle structures in chronological order
+     * @throws nlohmann::json::exception, std::exception
+     */
+    [[nodiscard]] std::vector<Candle>
+    getHistoricalPricesParallel(const std::string &instId, BarSize barSize, std::int64_t from, std::int64_t to,
+                                std::size_t maxConcurrency = 8, const onCandlesDownloaded &writer = {}) const;
+
+    /**
+     * Asynchronous version of getHistoricalPricesParallel(), the writer is called on the client's executor. It must
+     * not block and must not call the synchronous methods of the client, the executor would deadlock.
+     */
+    [[nodiscard]] boost::asio::awaitable<std::vector<Candle> >
+    asyncGetHistoricalPricesParallel(std::string instId, BarSize barSize, std::int64_t from, std::int64_t to, std::size_t maxConcurrency = 8,
+                                     onCandlesDownloaded writer = {}) const;
+
+    /**
+     * Plan a backfill of the range. Whole days of 1m candles are taken from the ZIP files of the market data history
+     * module where a file is cheaper than the REST pages of the day, the rest of the range (partial days, days without a
+     * file, other bar sizes) from the history-candles endpoint.
+     * @param instId instrument Id, e.g. "ETH-USDT-SWAP", the instrument type and family of the ZIP files are derived
+     * from it
+     * @param barSize
+     * @param from timestamp in ms, inclusive
+     * @param to timestamp in ms, inclusive
+     * @param options
+     * @return Steps covering the range, a failed listing of the ZIP files leaves the whole range to REST
+     */
+    [[nodiscard]] BackfillPlan planBackfill(const std::string &instId, BarSize barSize, std::int64_t from, std::int64_t to,
+                                            const BackfillOptions &options = {}) const;
+
+    /**
+     * Download the range by planBackfill. ZIP steps run through the download pipeline while the REST steps are
+     * downloaded in the background, the candles are delivered in chronological order with the seams deduplicated.
+     * Continuity is verified for bars up to 1W, missing candles are downloaded from REST once more if repairGaps is set.
+     * @param instId instrument Id, e.g. "ETH-USDT-SWAP"
+     * @param barSize
+     * @param from timestamp in ms, inclusive
+     * @param to timestamp in ms, inclusive
+     * @param options
+     * @param writer called with chronological pages (oldest first), e.g. CandleStore::writer(). Candles passed to
+     * the writer are not accumulated in the result.
+     * @return Candles, statistics and remaining gaps
+     * @throws nlohmann::json::exception, std::exception
+     */
+    [[nodiscard]] BackfillResult backfill(const std::string &instId, BarSize barSize, std::int64_t from, std::int64_t to,
+                                          const BackfillOptions &options = {}, const onCandlesDownloaded &writer = {}) const;
+
     /**
      * Retrieve funding rate.
      * @param instId instrument Id, e.g. "ETH-USDT-SWAP"
@@ -81,6 +299,11 @@ public:
      */
     [[nodiscard]] FundingRate getLastFundingRate(const std::string &instId) const;
 
+    /**
+     * Asynchronous version of getLastFundingRate()
+     */
+    [[nodiscard]] boost::asio::awaitable<FundingRate> asyncGetLastFundingRate(std::string instId) const;
+
     /**
      * Retrieve funding rate history. This endpoint can retrieve data from the last 3 months.
      * @param instId instrument Id, e.g. "ETH-USDT-SWAP"
@@ -92,6 +315,12 @@ public:
     [[nodiscard]] std::vector<FundingRate>
     getFundingRates(const std::string &instId, int64_t from, int64_t to, int limit = -1) const;
 
+    /**
+     * Asynchronous version of getFundingRates()
+     */
+    [[nodiscard]] boost::asio::awaitable<std::vector<FundingRate> >
+    asyncGetFundingRates(std::string instId, int64_t from, int64_t to, int limit = -1) const;
+
     /**
      * Retrieve a list of assets (with non-zero balance), remaining balance, and available amount in the trading account.
      * @param ccy Single currency or multiple currencies (no more than 20) separated with comma, e.g. BTC or BTC,ETH.
@@ -99,12 +328,22 @@ public:
      */
     [[nodiscard]] Balance getBalance(const std::string &ccy) const;
 
+    /**
+     * Asynchronous version of getBalance()
+     */
+    [[nodiscard]] boost::asio::awaitable<Balance> asyncGetBalance(std::string ccy) const;
+
     /**
      * Retrieve API server time.
      * @return
      */
     [[nodiscard]] std::int64_t getSystemTime() const;
 
+    /**
+     * Asynchronous version of getSystemTime()
+     */
+    [[nodiscard]] boost::asio::awaitable<std::int64_t> asyncGetSystemTime() const;
+
     /**
      * Retrieve information on your positions. When the account is in net mode, net positions will be displayed,
      * and when the account is in long/short mode, long or short positions will be displayed. Return in reverse
@@ -115,6 +354,11 @@ public:
      */
     [[nodiscard]] std::vector<Position> getPositions(InstrumentType instrumentType, const std::string &instId) const;
 
+    /**
+     * Asynchronous version of getPositions()
+     */
+    [[nodiscard]] boost::asio::awaitable<std::vector<Position> > asyncGetPositions(InstrumentType instrumentType, std::string instId) const;
+
     /**
      * Cancel an incomplete order.
      * @param instId instrument Id, e.g. "ETH-USDT-SWAP"
@@ -126,6 +370,12 @@ public:
     [[nodiscard]] std::vector<OrderResponse>
     cancelOrder(const std::string &instId, const std::string &clientOrderId, const std::string &orderId = "") const;
 
+    /**
+     * Asynchronous version of cancelOrder()
+     */
+    [[nodiscard]] boost::asio::awaitable<std::vector<OrderResponse> >
+    asyncCancelOrder(std::string instId, std::string clientOrderId, std::string orderId = "") const;
+
     /**
      * Place order
      * @param order
@@ -134,6 +384,11 @@ public:
      */
     [[nodiscard]] std::vector<OrderResponse> placeOrder(const Order &order) const;
 
+    /**
+     * Asynchronous version of placeOrder()
+     */
+    [[nodiscard]] boost::asio::awaitable<std::vector<OrderResponse> > asyncPlaceOrder(Order order) const;
+
     /**
      * Retrieve order details.
      * @param instId instrument Id, e.g. "ETH-USDT-SWAP"
@@ -145,6 +400,12 @@ public:
     [[nodiscard]] std::vector<OrderDetail>
     getOrderDetail(const std::string &instId, const std::string &clientOrderId, const std::string &orderId = "") const;
 
+    /**
+     * Asynchronous version of getOrderDetail()
+     */
+    [[nodiscard]] boost::asio::awaitable<std::vector<OrderDetail> >
+    asyncGetOrderDetail(std::string instId, std::string clientOrderId, std::string orderId = "") const;
+
     /**
      * Get download URLs for historical market data.
      * @param module Data module type (Trades, Candles1m, FundingRate, etc.)
@@ -165,6 +426,17 @@ public:
         std::int64_t begin,
         std::int64_t end) const;
 
+    /**
+     * Asynchronous version of getMarketDataHistory()
+     */
+    [[nodiscard]] boost::asio::awaitable<MarketDataHistory> asyncGetMarketDataHistory(
+        MarketDataModule module,
+        InstrumentType instType,
+        std::string instFamilyOrIdList,
+        DateAggrType dateAggrType,
+        std::int64_t begin,
+        std::int64_t end) const;
+
     /**
      * Download ZIP file from URL and return raw bytes.
      * @param url Full URL to the ZIP file (from MarketDataHistory response)
@@ -173,6 +445,22 @@ public:
      */
     [[nodiscard]] static std::vector<std::uint8_t> downloadMarketDataFile(const std::string &url);
 
+    /**
+     * Set the on-disk cache of the bulk market data files, nullptr disables it. It has to be called before the first
+     * download.
+     * @param cache
+     */
+    void setMarketDataCache(std::shared_ptr<MarketDataCache> cache) const;
+
+    /**
+     * Get a market data file from the cache, a file which is not cached is downloaded in the History request lane and
+     * stored
+     * @param file file info from getMarketDataHistory
+     * @return Raw ZIP file bytes
+     * @throws std::runtime_error if the download fails or the file is not cached in offline mode
+     */
+    [[nodiscard]] std::vector<std::uint8_t> fetchMarketDataFile(const MarketDataFileInfo &file) const;
+
     /**
      * Download, extract and parse historical candlestick data.
      * This is a high-level convenience method that combines getMarketDataHistory,
@@ -182,7 +470,10 @@ public:
      * @param dateAggrType Date aggregation type (daily or monthly)
      * @param begin Begin timestamp in ms
      * @param end End timestamp in ms
-     * @return Vector of Candle structures from all downloaded files
+     * @param options concurrency and memory budgets of the pipeline
+     * @param writer called with the candles of every file in chronological order (oldest file first) as soon as all
+     * older files are parsed, candles passed to the writer are not accumulated in the returned vector
+     * @return Vector of Candle structures from all downloaded files, empty if writer is given
      * @throws std::runtime_error if any step fails
      */
     [[nodiscard]] std::vector<Candle> downloadAndParseHistoricalCandles(
@@ -190,7 +481,24 @@ public:
         const std::string &instFamily,
         DateAggrType dateAggrType,
         std::int64_t begin,
-        std::int64_t end) const;
+        std::int64_t end,
+        const MarketDataPipelineOptions &options = {},
+        const onCandlesDownloaded &writer = {}) const;
+
+    /**
+     * Download and parse candlestick ZIP files in a staged pipeline. Downloads run concurrently, a pool of parsers
+     * inflates and parses the files as they arrive and the sorted per-file results are merged at the end.
+     * @param files e.g. from getMarketDataHistory, the URL may contain a port ("https://127.0.0.1:8443/...")
+     * @param options concurrency and memory budgets of the pipeline
+     * @param writer called from the pipeline threads with the candles of every file in order of the file dates, one
+     * file at a time, as soon as all older files are parsed. Candles passed to the writer are not accumulated in the
+     * returned vector.
+     * @return Candles of all files sorted by timestamp, empty if writer is given
+     * @throws std::runtime_error if any download, file or the writer fails, the rest of the pipeline is stopped
+     */
+    [[nodiscard]] std::vector<Candle> downloadAndParseCandleFiles(const std::vector<MarketDataFileInfo> &files,
+                                                                  const MarketDataPipelineOptions &options = {},
+                                                                  const onCandlesDownloaded &writer = {}) const;
 };
 }
 
@@ -0,0 +1,69 @@
+/**
+OKX TLS Context
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
+*/
+
+#ifndef INCLUDE_STONKY_OKX_TLS_CONTEXT_H
+#define INCLUDE_STONKY_OKX_TLS_CONTEXT_H
+
+#include <boost/asio/ssl/context.hpp>
+#include <cstdint>
+#include <string>
+
+namespace stonky::okx {
+struct TLSSessionStats {
+    /// Number of handshakes where a cached session was offered to the server
+    std::uint64_t resumptionAttempts = 0;
+
+    /// Number of handshakes where the server accepted the cached session
+    std::uint64_t resumedHandshakes = 0;
+
+    /// Number of full handshakes
+    std::uint64_t fullHandshakes = 0;
+};
+
+/**
+ * Process-wide TLS client context shared by HTTPSession and WebSocketClient. The CA store is loaded only once and
+ * TLS sessions (tickets) are cached per host, so every connection after the first one can use an abbreviated
+ * handshake.
+ */
+class TLSContext {
+public:
+    TLSContext() = delete;
+
+    /**
+     * Get the shared client context, it is created on first use
+     * @return
+     */
+    static boost::asio::ssl::context &instance();
+
+    /**
+     * Prepare SSL connection before handshake, sets the SNI host name and the cached session for the host if any
+     * @param ssl native handle of the SSL stream
+     * @param host server host name
+     * @throws boost::system::system_error if SNI host name cannot be set
+     */
+    static void prepareConnection(SSL *ssl, const std::string &host);
+
+    /**
+     * Update resumption counters, call after successful handshake
+     * @param ssl native handle of the SSL stream
+     */
+    static void handshakeCompleted(SSL *ssl);
+
+    /**
+     * Get session resumption counters
+     * @return
+     */
+    [[nodiscard]] static TLSSessionStats stats();
+
+    /**
+     * Drop all cached sessions
+     */
+    static void clearSessionCache();
+};
+} // namespace stonky::okx
+#endif // INCLUDE_STONKY_OKX_TLS_CONTEXT_H
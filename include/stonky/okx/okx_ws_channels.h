@@ -0,0 +1,197 @@
+/**
+OKX WebSocket Channels
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
+*/
+
+#ifndef INCLUDE_STONKY_OKX_WS_CHANNELS_H
+#define INCLUDE_STONKY_OKX_WS_CHANNELS_H
+
+#include "okx_event_models.h"
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+namespace stonky::okx {
+enum class ChannelType : std::int32_t {
+    tickers,
+    candle,
+    trades,
+    books,
+    fundingRate
+};
+
+struct ChannelInfo {
+    std::string_view name;
+    ChannelType type;
+
+    /// Bar size of the candle channels
+    BarSize barSize = BarSize::_1m;
+};
+
+/// All public channels with a typed handler
+inline constexpr std::array<ChannelInfo, 24> CHANNELS{{
+    {"tickers", ChannelType::tickers},
+    {"trades", ChannelType::trades},
+    {"funding-rate", ChannelType::fundingRate},
+    {"books", ChannelType::books},
+    {"books5", ChannelType::books},
+    {"bbo-tbt", ChannelType::books},
+    {"books-l2-tbt", ChannelType::books},
+    {"books50-l2-tbt", ChannelType::books},
+    {"candle1m", ChannelType::candle, BarSize::_1m},
+    {"candle3m", ChannelType::candle, BarSize::_3m},
+    {"candle5m", ChannelType::candle, BarSize::_5m},
+    {"candle15m", ChannelType::candle, BarSize::_15m},
+    {"candle30m", ChannelType::candle, BarSize::_30m},
+    {"candle1H", ChannelType::candle, BarSize::_1H},
+    {"candle2H", ChannelType::candle, BarSize::_2H},
+    {"candle4H", ChannelType::candle, BarSize::_4H},
+    {"candle6H", ChannelType::candle, BarSize::_6H},
+    {"candle12H", ChannelType::candle, BarSize::_12H},
+    {"candle1D", ChannelType::candle, BarSize::_1D},
+    {"candle2D", ChannelType::candle, BarSize::_2D},
+    {"candle3D", ChannelType::candle, BarSize::_3D},
+    {"candle1W", ChannelType::candle, BarSize::_1W},
+    {"candle1M", ChannelType::candle, BarSize::_1M},
+    {"candle3M", ChannelType::candle, BarSize::_3M},
+}};
+
+/// Order book channels, see OrderBook for how each of them is maintained
+enum class OrderBookChannel : std::int32_t {
+    books,
+    books5,
+    bbo_tbt,
+    books_l2_tbt,
+    books50_l2_tbt
+};
+
+constexpr std::string_view orderBookChannelName(const OrderBookChannel channel) noexcept {
+    switch (channel) {
+        case OrderBookChannel::books5:
+            return "books5";
+        case OrderBookChannel::bbo_tbt:
+            return "bbo-tbt";
+        case OrderBookChannel::books_l2_tbt:
+            return "books-l2-tbt";
+        case OrderBookChannel::books50_l2_tbt:
+            return "books50-l2-tbt";
+        default:
+            return "books";
+    }
+}
+
+/**
+ * @param name e.g. "books-l2-tbt"
+ * @return nothing if the name is not an order book channel
+ */
+constexpr std::optional<OrderBookChannel> findOrderBookChannel(const std::string_view name) noexcept {
+    for (const auto channel: {OrderBookChannel::books, OrderBookChannel::books5, OrderBookChannel::bbo_tbt, OrderBookChannel::books_l2_tbt,
+                              OrderBookChannel::books50_l2_tbt}) {
+        if (orderBookChannelName(channel) == name) {
+            return channel;
+        }
+    }
+
+    return std::nullopt;
+}
+
+namespace detail {
+inline constexpr std::size_t CHANNEL_TABLE_SIZE = 64;
+
+constexpr std::uint32_t channelHash(const std::string_view name) noexcept {
+    std::uint32_t hash = 2166136261u;
+
+    for (const auto ch: name) {
+        hash = (hash ^ static_cast<std::uint8_t>(ch)) * 16777619u;
+    }
+
+    return hash;
+}
+
+/// Open addressing table of indices into CHANNELS, built at compile time
+constexpr std::array<std::int8_t, CHANNEL_TABLE_SIZE> makeChannelTable() {
+    std::array<std::int8_t, CHANNEL_TABLE_SIZE> table{};
+    table.fill(-1);
+
+    for (std::size_t i = 0; i < CHANNELS.size(); ++i) {
+        auto slot = channelHash(CHANNELS[i].name) % CHANNEL_TABLE_SIZE;
+
+        while (table[slot] != -1) {
+            slot = (slot + 1) % CHANNEL_TABLE_SIZE;
+        }
+
+        table[slot] = static_cast<std::int8_t>(i);
+    }
+
+    return table;
+}
+
+inline constexpr auto CHANNEL_TABLE = makeChannelTable();
+} // namespace detail
+
+/**
+ * Look up a channel by its name, one hash and usually one string comparison
+ * @param name e.g. "candle1H"
+ * @return nullptr if the channel has no typed handler
+ */
+constexpr const ChannelInfo *findChannel(const std::string_view name) noexcept {
+    for (auto slot = detail::channelHash(name) % detail::CHANNEL_TABLE_SIZE; detail::CHANNEL_TABLE[slot] != -1;
+         slot = (slot + 1) % detail::CHANNEL_TABLE_SIZE) {
+        if (const auto &info = CHANNELS[detail::CHANNEL_TABLE[slot]]; info.name == name) {
+            return &info;
+        }
+    }
+
+    return nullptr;
+}
+
+static_assert(findChannel("candle1H") != nullptr && findChannel("candle1H")->barSize == BarSize::_1H);
+static_assert(findChannel("books-l2-tbt") != nullptr && findChannel("books-l2-tbt")->type == ChannelType::books);
+static_assert(findChannel("candle") == nullptr);
+static_assert(findOrderBookChannel("bbo-tbt") == OrderBookChannel::bbo_tbt);
+
+using onTickerEvent = std::function<void(const DataEventTicker &event)>;
+using onCandlestickEvent = std::function<void(const DataEventCandlestick &event)>;
+using onTradeEvent = std::function<void(const DataEventTrade &event)>;
+using onOrderBookEvent = std::function<void(const DataEventOrderBook &event)>;
+using onFundingRateEvent = std::function<void(const DataEventFundingRate &event)>;
+
+/**
+ * Routes raw data events to typed callbacks. The channel is resolved through the compile-time registry and only
+ * channels with a callback set are decoded.
+ */
+class WSChannelDispatcher {
+    struct P;
+    std::unique_ptr<P> m_p{};
+
+public:
+    WSChannelDispatcher();
+
+    ~WSChannelDispatcher();
+
+    void setTickerCallback(const onTickerEvent &onTickerEventCB) const;
+
+    void setCandlestickCallback(const onCandlestickEvent &onCandlestickEventCB) const;
+
+    void setTradeCallback(const onTradeEvent &onTradeEventCB) const;
+
+    void setOrderBookCallback(const onOrderBookEvent &onOrderBookEventCB) const;
+
+    void setFundingRateCallback(const onFundingRateEvent &onFundingRateEventCB) const;
+
+    /**
+     * Decode the event and call the callback of its channel
+     * @param event raw data event from WebSocketSession
+     * @return false if the channel is not in the registry
+     * @throws std::runtime_error if the data are not valid JSON
+     */
+    bool dispatch(const DataEvent &event) const;
+};
+} // namespace stonky::okx
+#endif // INCLUDE_STONKY_OKX_WS_CHANNELS_H
@@ -11,9 +11,49 @@ Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
 
 #include <stonky/utils/log_utils.h>
 #include "okx_ws_session.h"
+#include <chrono>
 #include <string>
+#include <vector>
 
 namespace stonky::okx {
+using onReconnect = std::function<void(const std::vector<std::string> &subscriptionRequests)>;
+
+struct WebSocketClientOptions {
+    /// Number of WebSocket connections the subscriptions are spread over
+    std::size_t numSessions = 1;
+
+    /// Number of I/O threads, each runs its own io_context serving every numThreads-th session
+    std::size_t numThreads = 1;
+
+    /// Subscriptions per session before the client warns that all sessions are full, new subscriptions go to the
+    /// least loaded session
+    std::size_t maxSubscriptionsPerSession = 256;
+
+    /// CPU core of every I/O thread, thread i is pinned to cpuAffinity[i % size], empty means no pinning
+    std::vector<int> cpuAffinity{};
+};
+
+struct WSShardStats {
+    std::size_t subscriptions = 0;
+    std::size_t pendingSubscriptions = 0;
+    bool connected = false;
+    std::uint64_t messages = 0;
+
+    /// Messages per second over the last full second
+    double messageRate = 0;
+
+    /// Local receive time minus the exchange "ts" of a sampled message
+    std::chrono::milliseconds lag{};
+    std::chrono::milliseconds maxLag{};
+
+    std::uint64_t reconnects = 0;
+    WSWriteQueueStats writeQueue{};
+};
+
+/**
+ * WebSocket client spreading subscriptions over several sessions. Every session is supervised, a dropped one is
+ * reconnected with backoff and its subscriptions are replayed.
+ */
 class WebSocketClient {
     struct P;
     std::unique_ptr<P> m_p{};
@@ -29,10 +69,13 @@ public:
 
     WebSocketClient();
 
+    explicit WebSocketClient(const WebSocketClientOptions &options);
+
     ~WebSocketClient();
 
     /**
-     * Run the WebSocket IO Context asynchronously and returns immediately without blocking the thread execution
+     * Start the I/O threads and return immediately without blocking the thread execution. The threads run until
+     * the client is destroyed.
      */
     void run() const;
 
@@ -44,22 +87,48 @@ public:
 
     /**
      * Set Data Message callback
-     * @param onDataEventCB
+     * @param onDataEventCB called on the I/O thread of the session, from several threads at once if numThreads > 1
      */
     void setDataEventCallback(const onDataEvent &onDataEventCB) const;
 
     /**
-     * Subscribe WebSocket according to the subscriptionRequest
+     * Set callback called after a dropped session has been replaced by a new one, the subscriptions are being
+     * replayed at that time. Data pushed while disconnected is lost and has to be recovered by the caller.
+     * @param onReconnectCB called with the subscriptions of the reconnected session
+     */
+    void setReconnectCallback(const onReconnect &onReconnectCB) const;
+
+    /**
+     * Subscribe WebSocket according to the subscriptionRequest. The subscription is kept across reconnects until
+     * unsubscribed.
      * @param subscriptionRequest
      */
     void subscribe(const std::string &subscriptionRequest) const;
 
+    /**
+     * Unsubscribe WebSocket stream according to the subscriptionRequest
+     * @param subscriptionRequest
+     */
+    void unsubscribe(const std::string &subscriptionRequest) const;
+
+    /**
+     * Unsubscribe and subscribe the stream again to get a new snapshot, e.g. after an order book gap. Nothing is
+     * done while the session is reconnecting, the replayed subscription brings the snapshot.
+     * @param subscriptionRequest subscription request
+     */
+    void resubscribe(const std::string &subscriptionRequest) const;
+
     /**
      * Check if a stream is already subscribed
      * @param subscriptionRequest subscription request
      * @return True if subscribed
      */
     [[nodiscard]] bool isSubscribed(const std::string &subscriptionRequest) const;
+
+    /**
+     * @return Load, message rate and lag of every session
+     */
+    [[nodiscard]] std::vector<WSShardStats> shardStats() const;
 };
 }
 
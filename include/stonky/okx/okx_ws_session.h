@@ -13,10 +13,26 @@ Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
 #include "okx_event_models.h"
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/ssl/context.hpp>
+#include <cstdint>
 #include <memory>
 
 namespace stonky::okx {
 using onDataEvent = std::function<void(const DataEvent &event)>;
+using onSessionClosed = std::function<void()>;
+
+struct WSWriteQueueStats {
+    /// Frames written, including pings and subscription requests
+    std::uint64_t writtenMessages = 0;
+
+    /// Pings and subscription flushes merged into one already waiting in the queue
+    std::uint64_t coalescedMessages = 0;
+
+    /// Text messages rejected because the queue was full
+    std::uint64_t droppedMessages = 0;
+
+    std::size_t depth = 0;
+    std::size_t maxDepth = 0;
+};
 
 class WebSocketSession final : public std::enable_shared_from_this<WebSocketSession> {
     struct P;
@@ -36,23 +52,63 @@ public:
      */
     void run(const std::string &host, const std::string &port, const std::string &subscriptionRequest, const onDataEvent &dataEventCB);
 
+    /**
+     * Set callback called once when the session ends, either by an error or by closing. It is called on the
+     * session's strand. Must be set before run().
+     * @param sessionClosedCB
+     */
+    void setClosedCallback(const onSessionClosed &sessionClosedCB) const;
+
     /**
      * Close the session asynchronously
      */
     void close() const;
 
     /**
-     * Subscribe WebSocket according to the subscriptionFilter
-     * @param subscriptionRequest
+     * Queue a subscription. All operations queued until the next write are packed into as few requests as the
+     * request size limit allows.
+     * @param subscriptionRequest {"channel": ..., "instId": ...}
      */
     void subscribe(const std::string &subscriptionRequest) const;
 
+    /**
+     * Queue an unsubscription, a subscription which has not been sent yet is just dropped
+     * @param subscriptionRequest {"channel": ..., "instId": ...}
+     */
+    void unsubscribe(const std::string &subscriptionRequest) const;
+
+    /**
+     * Unsubscribe and subscribe an acknowledged stream again, the server then starts it with a new snapshot
+     * @param subscriptionRequest {"channel": ..., "instId": ...}
+     */
+    void resubscribe(const std::string &subscriptionRequest) const;
+
     /**
      * Check if a stream is already subscribed
      * @param subscriptionRequest
-     * @return True if subscribed
+     * @return True if the subscription has been acknowledged by the server
      */
     [[nodiscard]] bool isSubscribed(const std::string &subscriptionRequest) const;
+
+    /**
+     * @return Number of subscribe and unsubscribe args not acknowledged yet, queued or sent
+     */
+    [[nodiscard]] std::size_t pendingSubscriptions() const;
+
+    /**
+     * Queue a text message. All outgoing frames, including subscriptions and pings, go through one queue with a
+     * single write in flight.
+     * @param message e.g. a WebSocket trading request
+     */
+    void send(std::string message) const;
+
+    /**
+     * @return Counters of the outgoing message queue
+     */
+    [[nodiscard]] WSWriteQueueStats writeQueueStats() const;
+
+private:
+    void flush() const;
 };
 } // namespace stonky::okx
 #endif // INCLUDE_STONKY_OKX_WS_SESSION_H
@@ -11,10 +11,15 @@ Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
 
 #include "stonky/utils/log_utils.h"
 #include "okx_event_models.h"
+#include "okx_ws_channels.h"
+#include "okx_ws_client.h"
 #include "okx_models.h"
+#include "okx_order_book.h"
 #include <optional>
 
 namespace stonky::okx {
+using onOrderBook = std::function<void(const std::string &instId, OrderBookChannel channel, const OrderBook &orderBook)>;
+
 class WSStreamManager {
     struct P;
     std::unique_ptr<P> m_p{};
@@ -22,6 +27,11 @@ class WSStreamManager {
 public:
     explicit WSStreamManager();
 
+    /**
+     * @param options sharding of the subscriptions over WebSocket sessions and I/O threads
+     */
+    explicit WSStreamManager(const WebSocketClientOptions &options);
+
     ~ WSStreamManager();
 
     /**
@@ -39,6 +49,54 @@ public:
      */
     void subscribeCandlestickStream(const std::string &instId, BarSize barSize) const;
 
+    /**
+     * Unsubscribe the Tickers Stream of the instrument, the last received value stays readable
+     * @param instId instrument Id, e.g. "ETH-USDT-SWAP"
+     */
+    void unsubscribeTickersStream(const std::string &instId) const;
+
+    /**
+     * Unsubscribe the Candlestick Stream of the instrument, the last received value stays readable
+     * @param instId instrument Id, e.g. "ETH-USDT-SWAP"
+     * @param barSize
+     */
+    void unsubscribeCandlestickStream(const std::string &instId, BarSize barSize) const;
+
+    /**
+     * Subscribe the order book channel of the instrument and maintain a local book from its messages. A book which
+     * misses an update or fails the checksum is re-subscribed to get a new snapshot.
+     * @param instId instrument Id, e.g. "ETH-USDT-SWAP"
+     * @param channel e.g. OrderBookChannel::books
+     */
+    void subscribeOrderBookStream(const std::string &instId, OrderBookChannel channel) const;
+
+    /**
+     * Unsubscribe the order book channel of the instrument and drop its local book
+     * @param instId instrument Id, e.g. "ETH-USDT-SWAP"
+     * @param channel e.g. OrderBookChannel::books
+     */
+    void unsubscribeOrderBookStream(const std::string &instId, OrderBookChannel channel) const;
+
+    /**
+     * Set callback called after every message applied to a local order book
+     * @param onOrderBookCB called on the WebSocket thread with the book locked, it must not block
+     */
+    void setOrderBookCallback(const onOrderBook &onOrderBookCB) const;
+
+    /**
+     * Set callback called with every candlestick message. After a reconnect the bars missed while disconnected are
+     * downloaded through the REST API and passed to the callback before the first live message, so the series has
+     * no holes. The download runs on a background thread, the live messages of the stream are held back meanwhile.
+     * @param onCandlestickEventCB called on the WebSocket thread, or on the backfill thread for the missed bars and
+     * the messages held back during their download
+     */
+    void setCandlestickCallback(const onCandlestickEvent &onCandlestickEventCB) const;
+
+    /**
+     * @return Load, message rate and lag of every WebSocket session
+     */
+    [[nodiscard]] std::vector<WSShardStats> shardStats() const;
+
     /**
      * Set time of all reading operations
      * @param seconds
@@ -58,20 +116,63 @@ public:
     void setLoggerCallback(const onLogMessage &onLogMessageCB) const;
 
     /**
-     * Try to read DataEventTicker structure. It will block at most Timeout time.
+     * Read the latest DataEventTicker structure. It blocks at most Timeout time if nothing has been received yet.
      * @param instId instrument Id, e.g. "ETH-USDT-SWAP"
      * @return EventInstrumentInfo structure if successful
      */
     [[nodiscard]] std::optional<DataEventTicker> readEventInstrumentInfo(const std::string &instId) const;
 
     /**
-     * Try to read DataEventCandlestick structure. It will block at most Timeout time.
+     * Read the latest DataEventCandlestick structure. It blocks at most Timeout time if nothing has been received yet.
      * @param instId instrument Id, e.g. "ETH-USDT-SWAP"
      * @param barSize e.g BarSize::_1m
      * @return DataEventCandlestick structure if successful
      */
     [[nodiscard]] std::optional<DataEventCandlestick>
     readEventCandlestick(const std::string &instId, BarSize barSize) const;
+
+    /**
+     * Latest ticker without copying or blocking, the returned value is immutable and stays valid while it is held
+     * @param instId instrument Id, e.g. "ETH-USDT-SWAP"
+     * @return nullptr if nothing has been received yet
+     */
+    [[nodiscard]] std::shared_ptr<const DataEventTicker> latestTicker(const std::string &instId) const;
+
+    /**
+     * Latest candlestick message without copying or blocking
+     * @param instId instrument Id, e.g. "ETH-USDT-SWAP"
+     * @param barSize e.g BarSize::_1m
+     * @return nullptr if nothing has been received yet
+     */
+    [[nodiscard]] std::shared_ptr<const DataEventCandlestick> latestCandlestick(const std::string &instId, BarSize barSize) const;
+
+    /**
+     * Wait for the next ticker message of the instrument, the value current at the time of the call is skipped
+     * @param instId instrument Id, e.g. "ETH-USDT-SWAP"
+     * @param timeout maximum waiting time
+     * @return nullptr on timeout or when the manager is being destroyed
+     */
+    [[nodiscard]] std::shared_ptr<const DataEventTicker> waitForNextTicker(const std::string &instId, std::chrono::milliseconds timeout) const;
+
+    /**
+     * Wait for the next candlestick message of the stream, the value current at the time of the call is skipped
+     * @param instId instrument Id, e.g. "ETH-USDT-SWAP"
+     * @param barSize e.g BarSize::_1m
+     * @param timeout maximum waiting time
+     * @return nullptr on timeout or when the manager is being destroyed
+     */
+    [[nodiscard]] std::shared_ptr<const DataEventCandlestick>
+    waitForNextCandlestick(const std::string &instId, BarSize barSize, std::chrono::milliseconds timeout) const;
+
+    /**
+     * Try to read the top of a local order book. It will block at most Timeout time.
+     * @param instId instrument Id, e.g. "ETH-USDT-SWAP"
+     * @param channel e.g. OrderBookChannel::books
+     * @param depth maximum number of levels of each side
+     * @return Copy of the book as a snapshot event if the book is valid
+     */
+    [[nodiscard]] std::optional<DataEventOrderBook>
+    readOrderBook(const std::string &instId, OrderBookChannel channel, std::size_t depth = 25) const;
 };
 }
 
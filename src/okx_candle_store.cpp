@@ -0,0 +1,459 @@
+/**
+OKX Candle Store
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
+*/
+
+#include "stonky/okx/okx_candle_store.h"
+#include "stonky/utils/magic_enum_wrapper.hpp"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <spdlog/spdlog.h>
+#include <fmt/format.h>
+
+namespace stonky::okx {
+namespace fs = std::filesystem;
+namespace bip = boost::interprocess;
+
+namespace {
+constexpr std::array<char, 8> MAGIC = {'O', 'K', 'X', 'C', 'N', 'D', 'L', 'S'};
+constexpr std::uint32_t FORMAT_VERSION = 1;
+constexpr std::size_t MAX_INST_ID_LENGTH = 63;
+
+/// The header takes one page, blocks start page aligned
+constexpr std::size_t HEADER_SIZE = 4096;
+
+/// ts + 7 mantissas + 7 scales + confirm
+constexpr std::size_t ROW_SIZE = sizeof(std::int64_t) * (1 + CANDLE_DECIMAL_COLUMNS) + CANDLE_DECIMAL_COLUMNS + 1;
+constexpr std::size_t BLOCK_SIZE = ROW_SIZE * CandleStore::BLOCK_ROWS;
+
+struct FileHeader {
+    std::array<char, 8> magic;
+    std::uint32_t version;
+    std::uint32_t blockRows;
+
+    /// Committed rows, it is updated after the rows are written
+    std::atomic<std::uint64_t> rowCount;
+    std::int32_t barSize;
+    std::array<char, MAX_INST_ID_LENGTH + 1> instId;
+};
+
+static_assert(sizeof(FileHeader) <= HEADER_SIZE);
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+/// Column offsets within a block
+constexpr std::size_t tsOffset() { return 0; }
+
+constexpr std::size_t mantissaOffset(const std::size_t column) {
+    return sizeof(std::int64_t) * CandleStore::BLOCK_ROWS * (1 + column);
+}
+
+constexpr std::size_t scaleOffset(const std::size_t column) {
+    return sizeof(std::int64_t) * CandleStore::BLOCK_ROWS * (1 + CANDLE_DECIMAL_COLUMNS) + CandleStore::BLOCK_ROWS * column;
+}
+
+constexpr std::size_t confirmOffset() {
+    return scaleOffset(CANDLE_DECIMAL_COLUMNS);
+}
+
+static_assert(confirmOffset() + CandleStore::BLOCK_ROWS == BLOCK_SIZE);
+
+Decimal64 toStored(const Decimal &value) {
+#ifdef OKX_USE_CPP_DEC_FLOAT
+    Decimal64 retVal;
+
+    if (!Decimal64::tryParse(value.str(Decimal64::MAX_DIGITS, std::ios_base::fixed), retVal)) {
+        throw std::runtime_error(fmt::format("Candle value {} does not fit the candle store", value.str()));
+    }
+
+    return retVal;
+#else
+    return value;
+#endif
+}
+
+Decimal fromStored(const std::int64_t mantissa, const std::int32_t scale) {
+#ifdef OKX_USE_CPP_DEC_FLOAT
+    return Decimal(Decimal64::fromMantissa(mantissa, scale).str());
+#else
+    return Decimal::fromMantissa(mantissa, scale);
+#endif
+}
+
+const Decimal Candle::*const DECIMAL_MEMBERS[CANDLE_DECIMAL_COLUMNS] = {
+    &Candle::o, &Candle::h, &Candle::l, &Candle::c, &Candle::vol, &Candle::volCcy, &Candle::volCcyQuote
+};
+
+bool candleOlder(const Candle &a, const Candle &b) {
+    return a.ts < b.ts;
+}
+}
+
+Decimal CandleSegment::value(const CandleColumn column, const std::size_t row) const {
+    const auto index = static_cast<std::size_t>(column);
+    return fromStored(mantissas[index][row], scales[index][row]);
+}
+
+Candle CandleSegment::candle(const std::size_t row) const {
+    Candle retVal;
+    retVal.ts = ts[row];
+    retVal.o = value(CandleColumn::o, row);
+    retVal.h = value(CandleColumn::h, row);
+    retVal.l = value(CandleColumn::l, row);
+    retVal.c = value(CandleColumn::c, row);
+    retVal.vol = value(CandleColumn::vol, row);
+    retVal.volCcy = value(CandleColumn::volCcy, row);
+    retVal.volCcyQuote = value(CandleColumn::volCcyQuote, row);
+    retVal.confirm = confirm[row] != 0;
+    return retVal;
+}
+
+CandleRange::CandleRange(std::shared_ptr<const void> mapping, std::vector<CandleSegment> segments) : m_mapping(std::move(mapping)),
+    m_segments(std::move(segments)) {
+}
+
+std::size_t CandleRange::size() const {
+    std::size_t retVal = 0;
+
+    for (const auto &segment: m_segments) {
+        retVal += segment.size();
+    }
+
+    return retVal;
+}
+
+std::vector<Candle> CandleRange::toCandles() const {
+    std::vector<Candle> retVal;
+    retVal.reserve(size());
+
+    for (const auto &segment: m_segments) {
+        for (std::size_t row = 0; row < segment.size(); ++row) {
+            retVal.push_back(segment.candle(row));
+        }
+    }
+
+    return retVal;
+}
+
+struct CandleStore::P {
+    fs::path path;
+    std::string instId;
+    BarSize barSize;
+    mutable std::mutex locker;
+
+    /// Current mapping of the whole file, ranges keep the mapping they were created from
+    std::shared_ptr<bip::mapped_region> region;
+    std::size_t allocatedBlocks = 0;
+
+    /// Sparse index, ts of the first row of every block
+    std::vector<std::int64_t> blockFirstTs;
+
+    /// Pages of the writer which could not be appended yet
+    std::vector<Candle> staged;
+
+    P(const fs::path &directory, std::string instId, const BarSize barSize) : path(filePath(directory, instId, barSize)),
+                                                                            instId(std::move(instId)), barSize(barSize) {
+        if (this->instId.size() > MAX_INST_ID_LENGTH) {
+            throw std::runtime_error(fmt::format("Instrument id {} is too long for the candle store", this->instId));
+        }
+
+        std::error_code ec;
+        fs::create_directories(directory, ec);
+
+        if (ec) {
+            throw std::runtime_error(fmt::format("Unable to create candle store directory {}: {}", directory.string(), ec.message()));
+        }
+
+        if (!fs::exists(path)) {
+            create();
+        }
+
+        const auto fileSize = fs::file_size(path);
+
+        if (fileSize < HEADER_SIZE || (fileSize - HEADER_SIZE) % BLOCK_SIZE != 0) {
+            throw std::runtime_error(fmt::format("Candle store file {} has invalid size {}", path.string(), fileSize));
+        }
+
+        allocatedBlocks = (fileSize - HEADER_SIZE) / BLOCK_SIZE;
+        map();
+        validate();
+
+        for (std::size_t block = 0; block * BLOCK_ROWS < rowCount(); ++block) {
+            blockFirstTs.push_back(column<std::int64_t>(block, tsOffset())[0]);
+        }
+    }
+
+    /// Write the header through a temporary file, a crash never leaves a file without a valid header
+    void create() const {
+        const auto tmpPath = fs::path(path).concat(".tmp");
+
+        {
+            std::vector<char> header(HEADER_SIZE, 0);
+            auto *fileHeader = new(header.data()) FileHeader{};
+            fileHeader->magic = MAGIC;
+            fileHeader->version = FORMAT_VERSION;
+            fileHeader->blockRows = BLOCK_ROWS;
+            fileHeader->rowCount.store(0);
+            fileHeader->barSize = static_cast<std::int32_t>(barSize);
+            std::ranges::copy(instId, fileHeader->instId.begin());
+
+            std::ofstream stream(tmpPath, std::ios::binary | std::ios::trunc);
+            stream.write(header.data(), static_cast<std::streamsize>(header.size()));
+            stream.close();
+
+            if (!stream) {
+                throw std::runtime_error(fmt::format("Unable to create candle store file {}", tmpPath.string()));
+            }
+        }
+
+        fs::rename(tmpPath, path);
+    }
+
+    void map() {
+        const bip::file_mapping mapping(path.string().c_str(), bip::read_write);
+        region = std::make_shared<bip::mapped_region>(mapping, bip::read_write, 0, HEADER_SIZE + allocatedBlocks * BLOCK_SIZE);
+    }
+
+    void validate() const {
+        const auto &fileHeader = header();
+
+        if (fileHeader.magic != MAGIC || fileHeader.version != FORMAT_VERSION || fileHeader.blockRows != BLOCK_ROWS) {
+            throw std::runtime_error(fmt::format("{} is not a candle store file of version {}", path.string(), FORMAT_VERSION));
+        }
+
+        if (fileHeader.barSize != static_cast<std::int32_t>(barSize) || std::string_view(fileHeader.instId.data()) != instId) {
+            throw std::runtime_error(fmt::format("Candle store file {} belongs to another series", path.string()));
+        }
+
+        if (fileHeader.rowCount.load() > allocatedBlocks * BLOCK_ROWS) {
+            throw std::runtime_error(fmt::format("Candle store file {} is truncated", path.string()));
+        }
+    }
+
+    [[nodiscard]] FileHeader &header() const {
+        return *static_cast<FileHeader *>(region->get_address());
+    }
+
+    [[nodiscard]] std::size_t rowCount() const {
+        return header().rowCount.load(std::memory_order_acquire);
+    }
+
+    template<typename ValueType>
+    [[nodiscard]] ValueType *column(const std::size_t block, const std::size_t offset) const {
+        auto *data = static_cast<char *>(region->get_address()) + HEADER_SIZE + block * BLOCK_SIZE + offset;
+        return reinterpret_cast<ValueType *>(data);
+    }
+
+    [[nodiscard]] std::optional<std::int64_t> lastTs() const {
+        const auto rows = rowCount();
+
+        if (rows == 0) {
+            return std::nullopt;
+        }
+
+        return column<std::int64_t>((rows - 1) / BLOCK_ROWS, tsOffset())[(rows - 1) % BLOCK_ROWS];
+    }
+
+    /// Grow the file to at least the number of blocks, the file at least doubles so that remapping stays rare
+    void reserve(const std::size_t blocks) {
+        if (blocks <= allocatedBlocks) {
+            return;
+        }
+
+        allocatedBlocks = std::max(blocks, allocatedBlocks * 2);
+        fs::resize_file(path, HEADER_SIZE + allocatedBlocks * BLOCK_SIZE);
+        map();
+    }
+
+    /// Append sorted candles, the caller holds the lock
+    std::size_t append(const std::span<const Candle> candles) {
+        const auto last = lastTs();
+        auto begin = candles.begin();
+
+        if (last) {
+            begin = std::ranges::upper_bound(candles, *last, {}, &Candle::ts);
+        }
+
+        auto rows = rowCount();
+        reserve((rows + static_cast<std::size_t>(candles.end() - begin) + BLOCK_ROWS - 1) / BLOCK_ROWS);
+        std::size_t retVal = 0;
+        std::int64_t previousTs = last.value_or(std::numeric_limits<std::int64_t>::min());
+
+        for (auto it = begin; it != candles.end(); ++it) {
+            if (!it->confirm || it->ts == previousTs) {
+                continue;
+            }
+
+            const auto block = rows / BLOCK_ROWS;
+            const auto row = rows % BLOCK_ROWS;
+            column<std::int64_t>(block, tsOffset())[row] = it->ts;
+
+            for (std::size_t i = 0; i < CANDLE_DECIMAL_COLUMNS; ++i) {
+                const auto value = toStored((*it).*DECIMAL_MEMBERS[i]);
+                column<std::int64_t>(block, mantissaOffset(i))[row] = value.mantissa();
+                column<std::int8_t>(block, scaleOffset(i))[row] = static_cast<std::int8_t>(value.scale());
+            }
+
+            column<std::uint8_t>(block, confirmOffset())[row] = 1;
+
+            if (row == 0) {
+                blockFirstTs.push_back(it->ts);
+            }
+
+            previousTs = it->ts;
+            ++rows;
+            ++retVal;
+        }
+
+        // Readers see the rows only after they are complete
+        header().rowCount.store(rows, std::memory_order_release);
+        return retVal;
+    }
+
+    [[nodiscard]] CandleSegment segment(const std::size_t block, const std::size_t first, const std::size_t last) const {
+        CandleSegment retVal;
+        const auto count = last - first;
+        retVal.ts = {column<const std::int64_t>(block, tsOffset()) + first, count};
+
+        for (std::size_t i = 0; i < CANDLE_DECIMAL_COLUMNS; ++i) {
+            retVal.mantissas[i] = {column<const std::int64_t>(block, mantissaOffset(i)) + first, count};
+            retVal.scales[i] = {column<const std::int8_t>(block, scaleOffset(i)) + first, count};
+        }
+
+        retVal.confirm = {column<const std::uint8_t>(block, confirmOffset()) + first, count};
+        return retVal;
+    }
+
+    /// Position of the first row with ts not less than (or greater than if upper) the value
+    [[nodiscard]] std::size_t position(const std::int64_t ts, const bool upper) const {
+        const auto rows = rowCount();
+        const auto blockIt = upper ? std::ranges::upper_bound(blockFirstTs, ts) : std::ranges::lower_bound(blockFirstTs, ts);
+
+        if (blockIt == blockFirstTs.begin()) {
+            return 0;
+        }
+
+        const auto block = static_cast<std::size_t>(blockIt - blockFirstTs.begin()) - 1;
+        const auto blockRows = std::min(BLOCK_ROWS, rows - block * BLOCK_ROWS);
+        const auto *tsColumn = column<const std::int64_t>(block, tsOffset());
+        const auto *it = upper ? std::upper_bound(tsColumn, tsColumn + blockRows, ts) : std::lower_bound(tsColumn, tsColumn + blockRows, ts);
+        return block * BLOCK_ROWS + static_cast<std::size_t>(it - tsColumn);
+    }
+};
+
+CandleStore::CandleStore(const fs::path &directory, const std::string &instId, const BarSize barSize) : m_p(
+    std::make_unique<P>(directory, instId, barSize)) {
+}
+
+CandleStore::~CandleStore() {
+    try {
+        flush();
+    } catch (const std::exception &e) {
+        spdlog::error("Unable to flush candle store {}: {}", m_p->path.string(), e.what());
+    }
+}
+
+fs::path CandleStore::filePath(const fs::path &directory, const std::string &instId, const BarSize barSize) {
+    return directory / fmt::format("{}-{}.candles", instId, magic_enum::enum_name(barSize));
+}
+
+std::size_t CandleStore::append(const std::span<const Candle> candles) const {
+    if (std::ranges::is_sorted(candles, candleOlder)) {
+        std::lock_guard lk(m_p->locker);
+        return m_p->append(candles);
+    }
+
+    std::vector sorted(candles.begin(), candles.end());
+    std::ranges::stable_sort(sorted, candleOlder);
+
+    std::lock_guard lk(m_p->locker);
+    return m_p->append(sorted);
+}
+
+std::function<void(const std::vector<Candle> &)> CandleStore::writer() const {
+    return [this](const std::vector<Candle> &candles) {
+        if (candles.empty()) {
+            return;
+        }
+
+        /// Pages of getHistoricalPrices are newest first, the older pages come later
+        const auto chronological = std::ranges::is_sorted(candles, candleOlder);
+
+        std::lock_guard lk(m_p->locker);
+        const auto last = m_p->lastTs();
+
+        if (chronological && m_p->staged.empty() && (!last || candles.front().ts > *last)) {
+            m_p->append(candles);
+        } else {
+            m_p->staged.insert(m_p->staged.end(), candles.begin(), candles.end());
+        }
+    };
+}
+
+std::size_t CandleStore::flush() const {
+    std::lock_guard lk(m_p->locker);
+
+    if (m_p->staged.empty()) {
+        return 0;
+    }
+
+    auto staged = std::move(m_p->staged);
+    m_p->staged.clear();
+    std::ranges::stable_sort(staged, candleOlder);
+    return m_p->append(staged);
+}
+
+void CandleStore::sync() const {
+    std::lock_guard lk(m_p->locker);
+    m_p->region->flush();
+}
+
+std::size_t CandleStore::size() const {
+    std::lock_guard lk(m_p->locker);
+    return m_p->rowCount();
+}
+
+std::optional<std::int64_t> CandleStore::firstTs() const {
+    std::lock_guard lk(m_p->locker);
+
+    if (m_p->blockFirstTs.empty()) {
+        return std::nullopt;
+    }
+
+    return m_p->blockFirstTs.front();
+}
+
+std::optional<std::int64_t> CandleStore::lastTs() const {
+    std::lock_guard lk(m_p->locker);
+    return m_p->lastTs();
+}
+
+CandleRange CandleStore::range(const std::int64_t from, const std::int64_t to) const {
+    std::lock_guard lk(m_p->locker);
+
+    if (from > to) {
+        return {m_p->region, {}};
+    }
+
+    const auto first = m_p->position(from, false);
+    const auto last = m_p->position(to, true);
+    std::vector<CandleSegment> segments;
+
+    for (auto row = first; row < last;) {
+        const auto block = row / BLOCK_ROWS;
+        const auto end = std::min(last, (block + 1) * BLOCK_ROWS);
+        segments.push_back(m_p->segment(block, row % BLOCK_ROWS, row % BLOCK_ROWS + (end - row)));
+        row = end;
+    }
+
+    return {m_p->region, std::move(segments)};
+}
+} // namespace stonky::okx
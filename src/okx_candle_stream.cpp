@@ -0,0 +1,146 @@
+/**
+OKX Candle Stream
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
+*/
+
+#include "stonky/okx/okx_candle_stream.h"
+#include "stonky/okx/okx_rest_client.h"
+#include "stonky/okx/okx_market_data_utils.h"
+#include "stonky/okx/okx.h"
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/use_future.hpp>
+#include <algorithm>
+#include <future>
+#include <optional>
+
+namespace stonky::okx {
+/// One window is one full history-candles page
+constexpr std::int64_t CANDLES_PER_WINDOW = 100;
+
+struct RESTCandleStream::P {
+    const RESTClient &client;
+    std::string instId;
+    BarSize barSize;
+    std::int64_t to;
+    std::int64_t windowSpan;
+    std::int64_t nextWindowFrom;
+    std::future<std::vector<Candle> > prefetch;
+
+    P(const RESTClient &client, std::string instId, const BarSize barSize, const std::int64_t from, const std::int64_t to) : client(client),
+        instId(std::move(instId)), barSize(barSize), to(to), windowSpan(OKX::numberOfMsForBarSize(barSize) * CANDLES_PER_WINDOW), nextWindowFrom(from) {
+    }
+
+    ~P() {
+        /// The pending download refers to the client and this stream
+        if (prefetch.valid()) {
+            prefetch.wait();
+        }
+    }
+
+    void startNextWindow() {
+        if (nextWindowFrom >= to) {
+            return;
+        }
+
+        const auto windowFrom = nextWindowFrom;
+        const auto windowTo = std::min(windowFrom + windowSpan, to);
+        nextWindowFrom = windowTo - 1;
+
+        /// Exclusive lower bound, one window of one page downloaded in one shard
+        prefetch = boost::asio::co_spawn(client.executor(), client.asyncGetHistoricalPricesParallel(instId, barSize, windowFrom, windowTo, 1),
+                                         boost::asio::use_future);
+    }
+};
+
+RESTCandleStream::RESTCandleStream(const RESTClient &client, std::string instId, const BarSize barSize, const std::int64_t from, const std::int64_t to) :
+    m_p(std::make_unique<P>(client, std::move(instId), barSize, from, to)) {
+    m_p->startNextWindow();
+}
+
+RESTCandleStream::~RESTCandleStream() = default;
+
+bool RESTCandleStream::next(std::vector<Candle> &page) {
+    page.clear();
+
+    /// Windows without data (e.g. before listing) are skipped
+    while (page.empty() && m_p->prefetch.valid()) {
+        page = m_p->prefetch.get();
+        m_p->startNextWindow();
+    }
+
+    return !page.empty();
+}
+
+struct ZipCandleStream::P {
+    const RESTClient &client;
+    InstrumentType instType;
+    std::string instFamily;
+    std::string instId;
+    DateAggrType dateAggrType;
+    std::int64_t begin;
+    std::int64_t end;
+    std::optional<std::vector<MarketDataFileInfo> > files;
+    std::size_t nextFile = 0;
+    std::future<std::vector<std::uint8_t> > prefetch;
+
+    P(const RESTClient &client, const InstrumentType instType, std::string instFamily, std::string instId, const DateAggrType dateAggrType,
+      const std::int64_t begin, const std::int64_t end) : client(client), instType(instType), instFamily(std::move(instFamily)),
+                                                          instId(std::move(instId)), dateAggrType(dateAggrType), begin(begin), end(end) {
+    }
+
+    ~P() {
+        if (prefetch.valid()) {
+            prefetch.wait();
+        }
+    }
+
+    void listFiles() {
+        const auto history = client.getMarketDataHistory(MarketDataModule::Candles1m, instType, instFamily, dateAggrType, begin, end);
+        files.emplace();
+
+        for (const auto &detail: history.details) {
+            files->insert(files->end(), detail.groupDetails.begin(), detail.groupDetails.end());
+        }
+
+        std::ranges::sort(*files, [](const MarketDataFileInfo &a, const MarketDataFileInfo &b) {
+            return a.dateTs < b.dateTs || (a.dateTs == b.dateTs && a.filename < b.filename);
+        });
+    }
+
+    void startNextFile() {
+        if (nextFile < files->size()) {
+            prefetch = std::async(std::launch::async, [this, file = (*files)[nextFile++]] { return client.fetchMarketDataFile(file); });
+        }
+    }
+};
+
+ZipCandleStream::ZipCandleStream(const RESTClient &client, const InstrumentType instType, std::string instFamily, std::string instId,
+                                 const DateAggrType dateAggrType, const std::int64_t begin, const std::int64_t end) :
+    m_p(std::make_unique<P>(client, instType, std::move(instFamily), std::move(instId), dateAggrType, begin, end)) {
+}
+
+ZipCandleStream::~ZipCandleStream() = default;
+
+bool ZipCandleStream::next(std::vector<Candle> &page) {
+    page.clear();
+
+    if (!m_p->files) {
+        m_p->listFiles();
+        m_p->startNextFile();
+    }
+
+    while (page.empty() && m_p->prefetch.valid()) {
+        const auto zipData = m_p->prefetch.get();
+        m_p->startNextFile();
+
+        page = utils::parseCandlesZip(zipData, m_p->instId);
+        std::erase_if(page, [this](const Candle &candle) { return candle.ts < m_p->begin || candle.ts > m_p->end; });
+        std::ranges::sort(page, [](const Candle &a, const Candle &b) { return a.ts < b.ts; });
+    }
+
+    return !page.empty();
+}
+} // namespace stonky::okx
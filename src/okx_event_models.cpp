@@ -58,17 +58,6 @@ void WSResponse::fromJson(const nlohmann::json &json) {
     }
 }
 
-nlohmann::json DataEvent::toJson() const {
-    throw std::runtime_error("Unimplemented: DataEvent::toJson()");
-}
-
-void DataEvent::fromJson(const nlohmann::json &json) {
-    const auto &arg = json["arg"];
-    readValue<std::string>(arg, "channel", channel);
-    readValue<std::string>(arg, "instId", instId);
-    data = json["data"];
-}
-
 nlohmann::json DataEventCandlestick::toJson() const {
     throw std::runtime_error("Unimplemented: DataEventCandlestick::toJson()");
 }
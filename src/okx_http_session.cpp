@@ -7,32 +7,216 @@ Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
 */
 
 #include "stonky/okx/okx_http_session.h"
+#include "stonky/okx/okx_tls_context.h"
+#include "stonky/okx/okx_request_signer.h"
 #include "stonky/utils/utils.h"
 #include "nlohmann/json.hpp"
 #include <boost/asio/ssl.hpp>
 #include <boost/beast/version.hpp>
-#include "base64.h"
-#include "date.h"
-#include <openssl/hmac.h>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/use_future.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/beast/ssl.hpp>
+#include <mutex>
+#include <deque>
+#include <optional>
+#include <thread>
 
 namespace stonky::okx {
 namespace ssl = boost::asio::ssl;
 using tcp = net::ip::tcp;
 
 constexpr auto API_MAINNET_URI = "www.okx.com";
+constexpr auto API_MAINNET_PORT = "443";
+constexpr auto CONNECT_TIMEOUT = std::chrono::seconds(30);
+constexpr auto REQUEST_TIMEOUT = std::chrono::seconds(30);
+
+/**
+ * Keep-alive TLS connection, the stream and its read buffer must live together because the buffer can hold bytes
+ * already read from the socket
+ */
+struct PooledConnection {
+    beast::ssl_stream<beast::tcp_stream> stream;
+    beast::flat_buffer buffer;
+    std::chrono::steady_clock::time_point lastUsed{};
+
+    PooledConnection(const net::any_io_executor &executor, ssl::context &ctx) : stream(executor, ctx) {
+    }
+
+    /**
+     * Check that the peer has not closed the connection in the meantime. Idle connection must have nothing to read,
+     * EOF or any pending data (e.g. TLS close_notify) means the connection cannot be reused.
+     */
+    bool isAlive() {
+        auto &socket = beast::get_lowest_layer(stream).socket();
+
+        if (!socket.is_open()) {
+            return false;
+        }
+
+        boost::system::error_code ec;
+        socket.non_blocking(true, ec);
+
+        if (ec) {
+            return false;
+        }
+
+        char byte;
+        socket.receive(net::buffer(&byte, 1), tcp::socket::message_peek, ec);
+
+        boost::system::error_code ignored;
+        socket.non_blocking(false, ignored);
+
+        return ec == net::error::would_block;
+    }
+
+    void close() {
+        boost::system::error_code ec;
+        [[maybe_unused]] auto rc = beast::get_lowest_layer(stream).socket().close(ec);
+    }
+};
 
 struct HTTPSession::P {
-    net::io_context ioc;
+    /// Used only when no executor is supplied by the caller
+    std::unique_ptr<net::io_context> ioc;
+    std::optional<net::executor_work_guard<net::io_context::executor_type> > workGuard;
+    std::thread ioThread;
+    net::any_io_executor executor;
+
     std::string apiKey;
-    std::string apiSecret;
     std::string passphrase;
+    std::unique_ptr<RequestSigner> signer;
     std::string uri;
-    const EVP_MD *evpMd;
+    std::string port;
+
+    mutable std::mutex poolLocker;
+    std::map<std::string, std::deque<std::unique_ptr<PooledConnection> > > idleConnections;
+    ConnectionPoolOptions poolOptions;
+    ConnectionPoolStats poolStats;
+
+    explicit P(const net::any_io_executor &ex) {
+        if (ex) {
+            executor = ex;
+        } else {
+            ioc = std::make_unique<net::io_context>(1);
+            workGuard.emplace(net::make_work_guard(*ioc));
+            executor = ioc->get_executor();
+            ioThread = std::thread([this] { ioc->run(); });
+        }
+    }
+
+    ~P() {
+        {
+            std::lock_guard lk(poolLocker);
+            idleConnections.clear();
+        }
+
+        if (ioc) {
+            workGuard.reset();
+            ioc->stop();
+
+            if (ioThread.joinable()) {
+                ioThread.join();
+            }
+        }
+    }
+
+    net::awaitable<http::response<http::string_body> > request(http::request<http::string_body> req);
+
+    net::awaitable<std::unique_ptr<PooledConnection> > connect(const std::string &host, const std::string &hostPort) {
+        auto connection = std::make_unique<PooledConnection>(executor, TLSContext::instance());
 
-    P() : evpMd(EVP_sha256()) {
+        // Set SNI Hostname (many hosts need this to handshake successfully) and the cached TLS session
+        TLSContext::prepareConnection(connection->stream.native_handle(), host);
+
+        tcp::resolver resolver{executor};
+        auto const results = co_await resolver.async_resolve(host, hostPort, net::use_awaitable);
+
+        auto &tcpStream = beast::get_lowest_layer(connection->stream);
+        tcpStream.expires_after(CONNECT_TIMEOUT);
+        co_await tcpStream.async_connect(results, net::use_awaitable);
+        tcpStream.socket().set_option(tcp::no_delay(true));
+
+        tcpStream.expires_after(CONNECT_TIMEOUT);
+        co_await connection->stream.async_handshake(ssl::stream_base::client, net::use_awaitable);
+        TLSContext::handshakeCompleted(connection->stream.native_handle());
+
+        std::lock_guard lk(poolLocker);
+        poolStats.connectionsOpened++;
+        co_return connection;
+    }
+
+    /**
+     * Take a healthy idle connection for the host from the pool, expired or dead connections are closed on the way
+     * @return nullptr if there is no usable connection
+     */
+    std::unique_ptr<PooledConnection> acquire(const std::string &key) {
+        std::unique_lock lk(poolLocker);
+
+        const auto it = idleConnections.find(key);
+
+        if (it == idleConnections.end()) {
+            return nullptr;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+
+        /// Most recently used connections are at the back, they are the least likely to be closed by the server
+        while (!it->second.empty()) {
+            auto connection = std::move(it->second.back());
+            it->second.pop_back();
+
+            if (now - connection->lastUsed < poolOptions.idleTimeout && connection->isAlive()) {
+                poolStats.connectionsReused++;
+                return connection;
+            }
+
+            poolStats.connectionsEvicted++;
+            connection->close();
+        }
+
+        return nullptr;
     }
 
-    http::response<http::string_body> request(http::request<http::string_body> req);
+    void release(const std::string &key, std::unique_ptr<PooledConnection> connection) {
+        std::lock_guard lk(poolLocker);
+
+        connection->lastUsed = std::chrono::steady_clock::now();
+        auto &connections = idleConnections[key];
+
+        /// Evict connections which expired while idle, the oldest ones are at the front
+        while (!connections.empty() && (connection->lastUsed - connections.front()->lastUsed >= poolOptions.idleTimeout ||
+                                        connections.size() >= poolOptions.maxIdleConnections)) {
+            connections.front()->close();
+            connections.pop_front();
+            poolStats.connectionsEvicted++;
+        }
+
+        if (poolOptions.maxIdleConnections == 0) {
+            connection->close();
+            poolStats.connectionsEvicted++;
+            return;
+        }
+
+        connections.push_back(std::move(connection));
+    }
+
+    template<typename ValueType>
+    ValueType runSync(net::awaitable<ValueType> awaitable) const {
+        return net::co_spawn(executor, std::move(awaitable), net::use_future).get();
+    }
+
+    static http::request<http::string_body> makeGetRequest(const std::string &path, const std::map<std::string, std::string> &parameters) {
+        std::string finalPath = path;
+
+        if (const auto queryString = createQueryStr(parameters); !queryString.empty()) {
+            finalPath.append("?");
+            finalPath.append(queryString);
+        }
+
+        return {http::verb::get, finalPath, 11};
+    }
 
     static std::string createQueryStr(const std::map<std::string, std::string> &parameters) {
         std::string queryStr;
@@ -51,142 +235,158 @@ struct HTTPSession::P {
     }
 
     void authenticatePost(http::request<http::string_body> &req, const nlohmann::json &json) const {
-        const auto bodyString = json.dump();
-
-        std::string parameterString;
-
-        const auto now = time_point_cast<std::chrono::milliseconds>(std::chrono::system_clock::now());
-        const auto ts = date::format("%FT%T", date::sys_time{now}).append("Z");
-
-        parameterString.append(ts);
-        parameterString.append("POST");
-        parameterString.append(req.target());
-        parameterString.append(bodyString);
-
-        unsigned char digest[SHA256_DIGEST_LENGTH];
-        unsigned int digestLength = SHA256_DIGEST_LENGTH;
-
-        HMAC(evpMd, apiSecret.data(), static_cast<int>(apiSecret.size()),
-             reinterpret_cast<const unsigned char *>(parameterString.data()),
-             parameterString.length(), digest, &digestLength);
-
-        const std::string signature = base64_encode(digest, sizeof(digest));
-
-        req.body() = bodyString;
+        req.body() = json.dump();
         req.prepare_payload();
 
+        RequestSigner::Signature signature;
+        signer->sign("POST", req.target(), req.body(), std::chrono::system_clock::now(), signature);
+
         req.set("OK-ACCESS-KEY", apiKey);
-        req.set("OK-ACCESS-SIGN", signature);
-        req.set("OK-ACCESS-TIMESTAMP", ts);
+        req.set("OK-ACCESS-SIGN", signature.sign());
+        req.set("OK-ACCESS-TIMESTAMP", signature.timestamp());
         req.set("OK-ACCESS-PASSPHRASE", passphrase);
         req.set(http::field::content_type, "application/json");
     }
 
     void authenticateGet(http::request<http::string_body> &req) const {
-        std::string parameterString;
-
-        const auto now = time_point_cast<std::chrono::milliseconds>(std::chrono::system_clock::now());
-        const auto ts = date::format("%FT%T", date::sys_time{now}).append("Z");
-
-        parameterString.append(ts);
-        parameterString.append("GET");
-        parameterString.append(req.target());
-
-        unsigned char digest[SHA256_DIGEST_LENGTH];
-        unsigned int digestLength = SHA256_DIGEST_LENGTH;
-
-        HMAC(evpMd, apiSecret.data(), static_cast<int>(apiSecret.size()),
-             reinterpret_cast<const unsigned char *>(parameterString.data()),
-             parameterString.length(), digest, &digestLength);
-
-        const std::string signature = base64_encode(digest, sizeof(digest));
+        RequestSigner::Signature signature;
+        signer->sign("GET", req.target(), {}, std::chrono::system_clock::now(), signature);
 
         req.set("OK-ACCESS-KEY", apiKey);
-        req.set("OK-ACCESS-SIGN", signature);
-        req.set("OK-ACCESS-TIMESTAMP", ts);
+        req.set("OK-ACCESS-SIGN", signature.sign());
+        req.set("OK-ACCESS-TIMESTAMP", signature.timestamp());
         req.set("OK-ACCESS-PASSPHRASE", passphrase);
     }
 };
 
-HTTPSession::HTTPSession(const std::string &apiKey, const std::string &apiSecret, const std::string &passphrase) : m_p(
-    std::make_unique<P>()) {
+HTTPSession::HTTPSession(const std::string &apiKey, const std::string &apiSecret, const std::string &passphrase) :
+    HTTPSession(net::any_io_executor{}, apiKey, apiSecret, passphrase) {
+}
+
+HTTPSession::HTTPSession(const net::any_io_executor &executor, const std::string &apiKey, const std::string &apiSecret,
+                         const std::string &passphrase) : m_p(std::make_unique<P>(executor)) {
     m_p->uri = API_MAINNET_URI;
+    m_p->port = API_MAINNET_PORT;
     m_p->apiKey = apiKey;
-    m_p->apiSecret = apiSecret;
+    m_p->signer = std::make_unique<RequestSigner>(apiSecret);
     m_p->passphrase = passphrase;
 }
 
+net::any_io_executor HTTPSession::executor() const {
+    return m_p->executor;
+}
+
 http::response<http::string_body>
 HTTPSession::get(const std::string &path, const std::map<std::string, std::string> &parameters,
                  const bool isPublic) const {
-    std::string finalPath = path;
+    return m_p->runSync(asyncGet(path, parameters, isPublic));
+}
 
-    if (const auto queryString = P::createQueryStr(parameters); !queryString.empty()) {
-        finalPath.append("?");
-        finalPath.append(queryString);
-    }
+http::response<http::string_body>
+HTTPSession::post(const std::string &path, const nlohmann::json &json, const bool isPublic) const {
+    return m_p->runSync(asyncPost(path, json, isPublic));
+}
 
-    http::request<http::string_body> req{http::verb::get, finalPath, 11};
+net::awaitable<http::response<http::string_body> >
+HTTPSession::asyncGet(const std::string path, const std::map<std::string, std::string> parameters, const bool isPublic) const {
+    auto req = P::makeGetRequest(path, parameters);
 
     if (!isPublic) {
         m_p->authenticateGet(req);
     }
 
-    return m_p->request(req);
+    co_return co_await m_p->request(std::move(req));
 }
 
-http::response<http::string_body>
-HTTPSession::post(const std::string &path, const nlohmann::json &json, const bool isPublic) const {
+net::awaitable<http::response<http::string_body> >
+HTTPSession::asyncPost(const std::string path, const nlohmann::json json, const bool isPublic) const {
     http::request<http::string_body> req{http::verb::post, path, 11};
 
     if (!isPublic) {
         m_p->authenticatePost(req, json);
     }
 
-    return m_p->request(req);
+    co_return co_await m_p->request(std::move(req));
 }
 
 HTTPSession::~HTTPSession() = default;
 
-http::response<http::string_body> HTTPSession::P::request(
+void HTTPSession::setHost(const std::string &host, const std::string &port) const {
+    std::lock_guard lk(m_p->poolLocker);
+    m_p->uri = host;
+    m_p->port = port;
+}
+
+void HTTPSession::setConnectionPoolOptions(const ConnectionPoolOptions &options) const {
+    std::lock_guard lk(m_p->poolLocker);
+    m_p->poolOptions = options;
+}
+
+ConnectionPoolStats HTTPSession::connectionPoolStats() const {
+    std::lock_guard lk(m_p->poolLocker);
+    return m_p->poolStats;
+}
+
+net::awaitable<http::response<http::string_body> > HTTPSession::P::request(
     http::request<http::string_body> req) {
-    req.set(http::field::host, uri);
+    std::string host;
+    std::string hostPort;
+    {
+        std::lock_guard lk(poolLocker);
+        host = uri;
+        hostPort = port;
+    }
+
+    const auto key = host + ":" + hostPort;
+
+    req.set(http::field::host, hostPort == "443" ? host : key);
     req.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+    req.keep_alive(true);
 
-    ssl::context ctx{ssl::context::sslv23_client};
-    ctx.set_default_verify_paths();
+    /// A pooled connection may have been closed by the server just before it was used, in that case the request is
+    /// repeated once on a new connection. Non-idempotent requests are repeated only if they were not sent at all.
+    for (int attempt = 0;; attempt++) {
+        auto connection = attempt == 0 ? acquire(key) : nullptr;
+        const bool isReused = connection != nullptr;
 
-    tcp::resolver resolver{ioc};
-    ssl::stream<tcp::socket> stream{ioc, ctx};
-
-    // Set SNI Hostname (many hosts need this to handshake successfully)
-    if (!SSL_set_tlsext_host_name(stream.native_handle(), uri.c_str())) {
-        boost::system::error_code ec{
-            static_cast<int>(ERR_get_error()),
-            net::error::get_ssl_category()
-        };
-        throw boost::system::system_error{ec};
-    }
+        if (!connection) {
+            connection = co_await connect(host, hostPort);
+        }
 
-    auto const results = resolver.resolve(uri, "443");
-    net::connect(stream.next_layer(), results.begin(), results.end());
-    stream.handshake(ssl::stream_base::client);
+        bool requestWritten = false;
+        boost::system::error_code ec;
+        http::response<http::string_body> response;
 
-    http::write(stream, req);
-    beast::flat_buffer buffer;
-    http::response<http::string_body> response;
-    http::read(stream, buffer, response);
+        beast::get_lowest_layer(connection->stream).expires_after(REQUEST_TIMEOUT);
+        co_await http::async_write(connection->stream, req, net::redirect_error(net::use_awaitable, ec));
 
-    boost::system::error_code ec;
+        if (!ec) {
+            requestWritten = true;
+            co_await http::async_read(connection->stream, connection->buffer, response, net::redirect_error(net::use_awaitable, ec));
+        }
 
-    [[maybe_unused]] auto rc = stream.shutdown(ec);
-    if (ec == boost::asio::error::eof) {
-        // Rationale:
-        // http://stackoverflow.com/questions/25587403/boost-asio-ssl-async-shutdown-always-finishes-with-an-error
-        ec.assign(0, ec.category());
-    }
+        if (!ec) {
+            beast::get_lowest_layer(connection->stream).expires_never();
+
+            if (response.keep_alive()) {
+                release(key, std::move(connection));
+            } else {
+                connection->close();
+            }
+
+            co_return response;
+        }
+
+        connection->close();
+
+        if (isReused && (!requestWritten || req.method() == http::verb::get)) {
+            std::lock_guard lk(poolLocker);
+            poolStats.reconnects++;
+            continue;
+        }
 
-    return response;
+        throw boost::system::system_error{ec};
+    }
 }
 
 std::vector<std::uint8_t> HTTPSession::downloadBinary(const std::string &url) {
@@ -210,30 +410,30 @@ std::vector<std::uint8_t> HTTPSession::downloadBinary(const std::string &url) {
         path = urlWithoutProtocol.substr(pathStart);
     }
 
-    // Create SSL context and connection
-    ssl::context ctx{ssl::context::sslv23_client};
-    ctx.set_default_verify_paths();
+    // Optional port, e.g. a local mirror of the files
+    std::string port = "443";
+
+    if (const auto portStart = host.find(':'); portStart != std::string::npos) {
+        port = host.substr(portStart + 1);
+        host.resize(portStart);
+    }
 
+    // Create connection using the shared SSL context
     net::io_context ioc;
     tcp::resolver resolver{ioc};
-    ssl::stream<tcp::socket> stream{ioc, ctx};
-
-    // Set SNI Hostname
-    if (!SSL_set_tlsext_host_name(stream.native_handle(), host.c_str())) {
-        boost::system::error_code ec{
-            static_cast<int>(ERR_get_error()),
-            net::error::get_ssl_category()
-        };
-        throw boost::system::system_error{ec};
-    }
+    ssl::stream<tcp::socket> stream{ioc, TLSContext::instance()};
+
+    // Set SNI Hostname and the cached TLS session
+    TLSContext::prepareConnection(stream.native_handle(), host);
 
-    auto const results = resolver.resolve(host, "443");
+    auto const results = resolver.resolve(host, port);
     net::connect(stream.next_layer(), results.begin(), results.end());
     stream.handshake(ssl::stream_base::client);
+    TLSContext::handshakeCompleted(stream.native_handle());
 
     // Prepare GET request
     http::request<http::string_body> req{http::verb::get, path, 11};
-    req.set(http::field::host, host);
+    req.set(http::field::host, port == "443" ? host : host + ":" + port);
     req.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
 
     // Send request
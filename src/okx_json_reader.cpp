@@ -0,0 +1,746 @@
+/**
+OKX JSON Reader
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
+*/
+
+#include "stonky/okx/okx_json_reader.h"
+#include "stonky/utils/magic_enum_wrapper.hpp"
+#include <charconv>
+#include <stdexcept>
+#include <utility>
+#include <fmt/format.h>
+
+namespace stonky::okx {
+namespace {
+void appendUtf8(std::string &out, const std::uint32_t codePoint) {
+    if (codePoint < 0x80) {
+        out.push_back(static_cast<char>(codePoint));
+    } else if (codePoint < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else if (codePoint < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+template<typename EnumType>
+void readEnum(JsonCursor &cursor, EnumType &value) {
+    if (const auto enumValue = magic_enum::enum_cast<EnumType>(cursor.readStringOrNull())) {
+        value = *enumValue;
+    }
+}
+
+void readTicker(JsonCursor &cursor, Ticker &ticker) {
+    std::string_view key;
+    cursor.beginObject();
+
+    while (cursor.nextKey(key)) {
+        if (key == "instType") {
+            readEnum(cursor, ticker.instType);
+        } else if (key == "instId") {
+            ticker.instId = cursor.readStringOrNull();
+        } else if (key == "last") {
+            ticker.last = cursor.readDecimal();
+        } else if (key == "lastSz") {
+            ticker.lastSz = cursor.readDecimal();
+        } else if (key == "askPx") {
+            ticker.askPx = cursor.readDecimal();
+        } else if (key == "askSz") {
+            ticker.askSz = cursor.readDecimal();
+        } else if (key == "bidPx") {
+            ticker.bidPx = cursor.readDecimal();
+        } else if (key == "bidSz") {
+            ticker.bidSz = cursor.readDecimal();
+        } else if (key == "open24h") {
+            ticker.open24h = cursor.readDecimal();
+        } else if (key == "high24h") {
+            ticker.high24h = cursor.readDecimal();
+        } else if (key == "low24h") {
+            ticker.low24h = cursor.readDecimal();
+        } else if (key == "volCcy24h") {
+            ticker.volCcy24h = cursor.readDecimal();
+        } else if (key == "vol24h") {
+            ticker.vol24h = cursor.readDecimal();
+        } else if (key == "sodUtc0") {
+            ticker.sodUtc0 = cursor.readDecimal();
+        } else if (key == "sodUtc8") {
+            ticker.sodUtc8 = cursor.readDecimal();
+        } else if (key == "ts") {
+            ticker.ts = cursor.readInt64();
+        } else {
+            cursor.skipValue();
+        }
+    }
+}
+
+void readCandle(JsonCursor &cursor, Candle &candle) {
+    cursor.beginArray();
+
+    /// [ts, o, h, l, c, vol, volCcy, volCcyQuote, confirm]
+    for (int index = 0; cursor.nextElement(); ++index) {
+        switch (index) {
+            case 0: candle.ts = cursor.readInt64();
+                break;
+            case 1: candle.o = cursor.readDecimal();
+                break;
+            case 2: candle.h = cursor.readDecimal();
+                break;
+            case 3: candle.l = cursor.readDecimal();
+                break;
+            case 4: candle.c = cursor.readDecimal();
+                break;
+            case 5: candle.vol = cursor.readDecimal();
+                break;
+            case 6: candle.volCcy = cursor.readDecimal();
+                break;
+            case 7: candle.volCcyQuote = cursor.readDecimal();
+                break;
+            case 8: candle.confirm = cursor.readStringOrNull() == "1";
+                break;
+            default: cursor.skipValue();
+        }
+    }
+}
+
+void readFundingRate(JsonCursor &cursor, FundingRate &rate) {
+    std::string_view key;
+    cursor.beginObject();
+
+    while (cursor.nextKey(key)) {
+        if (key == "instType") {
+            readEnum(cursor, rate.instType);
+        } else if (key == "instId") {
+            rate.instId = cursor.readStringOrNull();
+        } else if (key == "fundingRate") {
+            rate.fundingRate = cursor.readDecimal();
+        } else if (key == "fundingTime") {
+            rate.fundingTime = cursor.readInt64();
+        } else if (key == "nextFundingTime") {
+            rate.nextFundingTime = cursor.readInt64();
+        } else if (key == "nextFundingRate") {
+            rate.nextFundingRate = cursor.readDecimal();
+        } else if (key == "interestRate") {
+            rate.interestRate = cursor.readDecimal();
+        } else if (key == "premium") {
+            rate.premium = cursor.readDecimal();
+        } else if (key == "maxFundingRate") {
+            rate.maxFundingRate = cursor.readDecimal();
+        } else if (key == "minFundingRate") {
+            rate.minFundingRate = cursor.readDecimal();
+        } else if (key == "ts") {
+            rate.ts = cursor.readInt64();
+        } else if (key == "settState") {
+            readEnum(cursor, rate.settState);
+        } else if (key == "settFundingRate") {
+            rate.settFundingRate = cursor.readDecimal();
+        } else {
+            cursor.skipValue();
+        }
+    }
+}
+
+/// ["px", "sz", "0", "numOrders"]
+void readBookLevels(JsonCursor &cursor, std::vector<BookLevel> &levels) {
+    if (cursor.tryNull()) {
+        return;
+    }
+
+    cursor.beginArray();
+
+    while (cursor.nextElement()) {
+        auto &level = levels.emplace_back();
+        cursor.beginArray();
+
+        for (int index = 0; cursor.nextElement(); ++index) {
+            switch (index) {
+                case 0: level.px.assign(cursor.readString());
+                    break;
+                case 1: level.sz.assign(cursor.readString());
+                    break;
+                case 3: level.numOrders = static_cast<std::int32_t>(cursor.readInt64());
+                    break;
+                default: cursor.skipValue();
+            }
+        }
+    }
+}
+
+/**
+ * Read {"code": ..., "msg": ..., "data": [...]}, readElement is called for every element of the data array
+ */
+template<typename ReadElement>
+void readEnvelope(const std::string_view body, Response &response, ReadElement &&readElement) {
+    JsonCursor cursor(body);
+    std::string_view key;
+    cursor.beginObject();
+
+    while (cursor.nextKey(key)) {
+        if (key == "code") {
+            response.code = cursor.readStringOrNull();
+        } else if (key == "msg") {
+            response.msg = cursor.readStringOrNull();
+        } else if (key == "data") {
+            if (cursor.tryNull()) {
+                continue;
+            }
+
+            cursor.beginArray();
+
+            while (cursor.nextElement()) {
+                readElement(cursor);
+            }
+        } else {
+            cursor.skipValue();
+        }
+    }
+
+    cursor.end();
+}
+}
+
+JsonCursor::JsonCursor(const std::string_view json) : m_json(json) {
+}
+
+void JsonCursor::skipWhitespace() {
+    while (m_pos < m_json.size() && (m_json[m_pos] == ' ' || m_json[m_pos] == '\n' || m_json[m_pos] == '\r' || m_json[m_pos] == '\t')) {
+        ++m_pos;
+    }
+}
+
+char JsonCursor::peek() {
+    skipWhitespace();
+
+    if (m_pos >= m_json.size()) {
+        fail("unexpected end of input");
+    }
+
+    return m_json[m_pos];
+}
+
+void JsonCursor::expect(const char ch) {
+    if (peek() != ch) {
+        fail(fmt::format("expected '{}'", ch));
+    }
+
+    ++m_pos;
+}
+
+void JsonCursor::expectLiteral(const std::string_view literal) {
+    if (m_json.substr(m_pos, literal.size()) != literal) {
+        fail(fmt::format("expected {}", literal));
+    }
+
+    m_pos += literal.size();
+}
+
+void JsonCursor::skipNumber() {
+    auto skipDigits = [this] {
+        const auto start = m_pos;
+
+        while (m_pos < m_json.size() && m_json[m_pos] >= '0' && m_json[m_pos] <= '9') {
+            ++m_pos;
+        }
+
+        if (m_pos == start) {
+            fail("invalid number");
+        }
+    };
+
+    if (m_json[m_pos] == '-') {
+        ++m_pos;
+    }
+
+    /// No leading zeros
+    if (m_pos < m_json.size() && m_json[m_pos] == '0') {
+        ++m_pos;
+    } else {
+        skipDigits();
+    }
+
+    if (m_pos < m_json.size() && m_json[m_pos] == '.') {
+        ++m_pos;
+        skipDigits();
+    }
+
+    if (m_pos < m_json.size() && (m_json[m_pos] == 'e' || m_json[m_pos] == 'E')) {
+        ++m_pos;
+
+        if (m_pos < m_json.size() && (m_json[m_pos] == '+' || m_json[m_pos] == '-')) {
+            ++m_pos;
+        }
+
+        skipDigits();
+    }
+}
+
+void JsonCursor::fail(const std::string_view what) const {
+    throw std::runtime_error(fmt::format("JSON parse error at offset {}: {}", m_pos, what));
+}
+
+void JsonCursor::beginObject() {
+    expect('{');
+    m_first = true;
+}
+
+bool JsonCursor::nextKey(std::string_view &key) {
+    const auto ch = peek();
+    const auto first = std::exchange(m_first, false);
+
+    if (ch == '}') {
+        ++m_pos;
+        return false;
+    }
+
+    if (!first) {
+        if (ch != ',') {
+            fail("expected ',' or '}'");
+        }
+
+        ++m_pos;
+    }
+
+    key = readString();
+    expect(':');
+    return true;
+}
+
+void JsonCursor::beginArray() {
+    expect('[');
+    m_first = true;
+}
+
+bool JsonCursor::nextElement() {
+    const auto ch = peek();
+    const auto first = std::exchange(m_first, false);
+
+    if (ch == ']') {
+        ++m_pos;
+        return false;
+    }
+
+    if (!first) {
+        if (ch != ',') {
+            fail("expected ',' or ']'");
+        }
+
+        ++m_pos;
+    }
+
+    return true;
+}
+
+bool JsonCursor::tryNull() {
+    if (peek() != 'n') {
+        return false;
+    }
+
+    expectLiteral("null");
+    return true;
+}
+
+std::string_view JsonCursor::readString() {
+    expect('"');
+    const auto start = m_pos;
+
+    for (; m_pos < m_json.size(); ++m_pos) {
+        if (m_json[m_pos] == '"') {
+            return m_json.substr(start, m_pos++ - start);
+        }
+
+        if (m_json[m_pos] == '\\') {
+            return decodeEscapedString(start);
+        }
+    }
+
+    fail("unterminated string");
+}
+
+std::string_view JsonCursor::decodeEscapedString(const std::size_t start) {
+    m_scratch.assign(m_json.substr(start, m_pos - start));
+
+    while (m_pos < m_json.size()) {
+        const auto ch = m_json[m_pos++];
+
+        if (ch == '"') {
+            return m_scratch;
+        }
+
+        if (ch != '\\') {
+            m_scratch.push_back(ch);
+            continue;
+        }
+
+        if (m_pos >= m_json.size()) {
+            break;
+        }
+
+        switch (const auto escaped = m_json[m_pos++]) {
+            case 'b': m_scratch.push_back('\b');
+                break;
+            case 'f': m_scratch.push_back('\f');
+                break;
+            case 'n': m_scratch.push_back('\n');
+                break;
+            case 'r': m_scratch.push_back('\r');
+                break;
+            case 't': m_scratch.push_back('\t');
+                break;
+            case 'u': {
+                auto readHex = [this](std::uint32_t &value) {
+                    if (m_pos + 4 > m_json.size()) {
+                        return false;
+                    }
+
+                    const auto [ptr, ec] = std::from_chars(m_json.data() + m_pos, m_json.data() + m_pos + 4, value, 16);
+                    m_pos += 4;
+                    return ec == std::errc() && ptr == m_json.data() + m_pos;
+                };
+
+                std::uint32_t codePoint = 0;
+
+                if (!readHex(codePoint)) {
+                    fail("invalid unicode escape");
+                }
+
+                /// Surrogate pair
+                if (codePoint >= 0xD800 && codePoint <= 0xDBFF && m_json.substr(m_pos, 2) == "\\u") {
+                    m_pos += 2;
+                    std::uint32_t low = 0;
+
+                    if (!readHex(low)) {
+                        fail("invalid unicode escape");
+                    }
+
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                }
+
+                appendUtf8(m_scratch, codePoint);
+                break;
+            }
+            default:
+                m_scratch.push_back(escaped);
+        }
+    }
+
+    fail("unterminated string");
+}
+
+std::string_view JsonCursor::readStringOrNull() {
+    return tryNull() ? std::string_view{} : readString();
+}
+
+void JsonCursor::skipValue() {
+    switch (peek()) {
+        case '"':
+            static_cast<void>(readString());
+            break;
+        case '{': {
+            beginObject();
+            std::string_view key;
+
+            while (nextKey(key)) {
+                skipValue();
+            }
+
+            break;
+        }
+        case '[':
+            beginArray();
+
+            while (nextElement()) {
+                skipValue();
+            }
+
+            break;
+        case 't':
+            expectLiteral("true");
+            break;
+        case 'f':
+            expectLiteral("false");
+            break;
+        case 'n':
+            expectLiteral("null");
+            break;
+        case '-':
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+            skipNumber();
+            break;
+        default:
+            fail(fmt::format("unexpected character '{}'", m_json[m_pos]));
+    }
+}
+
+std::string_view JsonCursor::readRaw() {
+    skipWhitespace();
+    const auto start = m_pos;
+    skipValue();
+    return m_json.substr(start, m_pos - start);
+}
+
+Decimal JsonCursor::readDecimal() {
+    const auto str = readStringOrNull();
+
+    if (str.empty()) {
+        return Decimal{};
+    }
+
+#ifdef OKX_USE_CPP_DEC_FLOAT
+    return Decimal(std::string(str));
+#else
+    return Decimal(str);
+#endif
+}
+
+std::int64_t JsonCursor::readInt64() {
+    std::string_view str;
+    std::int64_t retVal = 0;
+
+    if (peek() == '"') {
+        str = readString();
+    } else if (!tryNull()) {
+        str = readRaw();
+    }
+
+    if (!str.empty()) {
+        if (const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), retVal); ec != std::errc() || ptr != str.data() + str.size()) {
+            fail(fmt::format("invalid integer: {}", str));
+        }
+    }
+
+    return retVal;
+}
+
+void JsonCursor::end() {
+    skipWhitespace();
+
+    if (m_pos != m_json.size()) {
+        fail("unexpected data after the value");
+    }
+}
+
+void readResponse(const std::string_view body, Tickers &tickers) {
+    readEnvelope(body, tickers, [&tickers](JsonCursor &cursor) { readTicker(cursor, tickers.tickers.emplace_back()); });
+}
+
+void readResponse(const std::string_view body, Candles &candles) {
+    readEnvelope(body, candles, [&candles](JsonCursor &cursor) { readCandle(cursor, candles.candles.emplace_back()); });
+}
+
+void readResponse(const std::string_view body, Instruments &instruments) {
+    readEnvelope(body, instruments, [&instruments](JsonCursor &cursor) {
+        auto &instrument = instruments.instruments.emplace_back();
+        std::string_view key;
+        cursor.beginObject();
+
+        while (cursor.nextKey(key)) {
+            if (key == "instType") {
+                readEnum(cursor, instrument.instType);
+            } else if (key == "instId") {
+                instrument.instId = cursor.readStringOrNull();
+            } else if (key == "instFamily") {
+                instrument.instFamily = cursor.readStringOrNull();
+            } else if (key == "uly") {
+                instrument.uly = cursor.readStringOrNull();
+            } else if (key == "baseCcy") {
+                instrument.baseCcy = cursor.readStringOrNull();
+            } else if (key == "quoteCcy") {
+                instrument.quoteCcy = cursor.readStringOrNull();
+            } else if (key == "settleCcy") {
+                instrument.settleCcy = cursor.readStringOrNull();
+            } else if (key == "ctVal") {
+                instrument.ctVal = cursor.readDecimal();
+            } else if (key == "ctMult") {
+                instrument.ctMult = cursor.readDecimal();
+            } else if (key == "ctValCcy") {
+                instrument.ctValCcy = cursor.readStringOrNull();
+            } else if (key == "optType") {
+                readEnum(cursor, instrument.optType);
+            } else if (key == "stk") {
+                instrument.stk = cursor.readDecimal();
+            } else if (key == "listTime") {
+                instrument.listTime = cursor.readInt64();
+            } else if (key == "expTime") {
+                instrument.expTime = cursor.readInt64();
+            } else if (key == "lever") {
+                instrument.lever = cursor.readDecimal();
+            } else if (key == "tickSz") {
+                instrument.tickSz = cursor.readDecimal();
+            } else if (key == "lotSz") {
+                instrument.lotSz = cursor.readDecimal();
+            } else if (key == "minSz") {
+                instrument.minSz = cursor.readDecimal();
+            } else if (key == "ctType") {
+                readEnum(cursor, instrument.ctType);
+            } else if (key == "alias") {
+                readEnum(cursor, instrument.alias);
+            } else if (key == "state") {
+                readEnum(cursor, instrument.state);
+            } else if (key == "maxLmtSz") {
+                instrument.maxLmtSz = cursor.readDecimal();
+            } else if (key == "maxMktSz") {
+                instrument.maxMktSz = cursor.readDecimal();
+            } else if (key == "maxTwapSz") {
+                instrument.maxTwapSz = cursor.readDecimal();
+            } else if (key == "maxIcebergSz") {
+                instrument.maxIcebergSz = cursor.readDecimal();
+            } else if (key == "maxTriggerSz") {
+                instrument.maxTriggerSz = cursor.readDecimal();
+            } else if (key == "maxStopSz") {
+                instrument.maxStopSz = cursor.readDecimal();
+            } else {
+                cursor.skipValue();
+            }
+        }
+    });
+}
+
+bool readDataEvent(const std::string_view frame, DataEvent &event) {
+    JsonCursor cursor(frame);
+    std::string_view key;
+    cursor.beginObject();
+
+    while (cursor.nextKey(key)) {
+        if (key == "event") {
+            return false;
+        }
+
+        if (key == "arg") {
+            cursor.beginObject();
+
+            while (cursor.nextKey(key)) {
+                if (key == "channel") {
+                    event.channel = cursor.readStringOrNull();
+                } else if (key == "instId") {
+                    event.instId = cursor.readStringOrNull();
+                } else {
+                    cursor.skipValue();
+                }
+            }
+        } else if (key == "action") {
+            event.action = cursor.readStringOrNull();
+        } else if (key == "data") {
+            event.data = cursor.readRaw();
+        } else {
+            cursor.skipValue();
+        }
+    }
+
+    cursor.end();
+    return true;
+}
+
+void readEventData(const std::string_view data, DataEventTicker &event) {
+    JsonCursor cursor(data);
+    cursor.beginArray();
+
+    while (cursor.nextElement()) {
+        readTicker(cursor, event.tickers.emplace_back());
+    }
+
+    cursor.end();
+}
+
+void readEventData(const std::string_view data, DataEventCandlestick &event) {
+    JsonCursor cursor(data);
+    cursor.beginArray();
+
+    while (cursor.nextElement()) {
+        readCandle(cursor, event.candles.emplace_back());
+    }
+
+    cursor.end();
+}
+
+void readEventData(const std::string_view data, DataEventTrade &event) {
+    JsonCursor cursor(data);
+    std::string_view key;
+    cursor.beginArray();
+
+    while (cursor.nextElement()) {
+        auto &trade = event.trades.emplace_back();
+        cursor.beginObject();
+
+        while (cursor.nextKey(key)) {
+            if (key == "instId") {
+                trade.instId = cursor.readStringOrNull();
+            } else if (key == "tradeId") {
+                trade.tradeId = cursor.readStringOrNull();
+            } else if (key == "px") {
+                trade.px = cursor.readDecimal();
+            } else if (key == "sz") {
+                trade.sz = cursor.readDecimal();
+            } else if (key == "side") {
+                readEnum(cursor, trade.side);
+            } else if (key == "ts") {
+                trade.ts = cursor.readInt64();
+            } else if (key == "count") {
+                trade.count = static_cast<std::int32_t>(cursor.readInt64());
+            } else {
+                cursor.skipValue();
+            }
+        }
+    }
+
+    cursor.end();
+}
+
+void readEventData(const std::string_view data, DataEventFundingRate &event) {
+    JsonCursor cursor(data);
+    cursor.beginArray();
+
+    while (cursor.nextElement()) {
+        readFundingRate(cursor, event.rates.emplace_back());
+    }
+
+    cursor.end();
+}
+
+void readEventData(const std::string_view data, DataEventOrderBook &event) {
+    JsonCursor cursor(data);
+    std::string_view key;
+    cursor.beginArray();
+
+    while (cursor.nextElement()) {
+        cursor.beginObject();
+
+        while (cursor.nextKey(key)) {
+            if (key == "asks") {
+                readBookLevels(cursor, event.asks);
+            } else if (key == "bids") {
+                readBookLevels(cursor, event.bids);
+            } else if (key == "ts") {
+                event.ts = cursor.readInt64();
+            } else if (key == "checksum") {
+                event.checksum = static_cast<std::int32_t>(cursor.readInt64());
+            } else if (key == "seqId") {
+                event.seqId = cursor.readInt64();
+            } else if (key == "prevSeqId") {
+                event.prevSeqId = cursor.readInt64();
+            } else {
+                cursor.skipValue();
+            }
+        }
+    }
+
+    cursor.end();
+}
+} // namespace stonky::okx
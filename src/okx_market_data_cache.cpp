@@ -0,0 +1,389 @@
+/**
+OKX Market Data Cache
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
+*/
+
+#include "stonky/okx/okx_market_data_cache.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <fstream>
+#include <list>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <mz_crypt.h>
+#include <spdlog/spdlog.h>
+#include <fmt/format.h>
+
+namespace stonky::okx {
+namespace fs = std::filesystem;
+
+namespace {
+constexpr std::string_view TMP_SUFFIX = ".tmp";
+
+std::uint32_t crc32(const std::span<const std::uint8_t> data) {
+    constexpr std::size_t CHUNK_SIZE = 1 << 30;
+    std::uint32_t crc = 0;
+
+    for (std::size_t offset = 0; offset < data.size(); offset += CHUNK_SIZE) {
+        const auto length = std::min(CHUNK_SIZE, data.size() - offset);
+        crc = mz_crypt_crc32_update(crc, data.data() + offset, static_cast<std::int32_t>(length));
+    }
+
+    return crc;
+}
+
+/// A truncated download has no end of central directory record, it sits within the last 64 KB + 22 bytes
+bool isCompleteZip(const std::span<const std::uint8_t> data) {
+    constexpr std::size_t EOCD_SIZE = 22;
+    constexpr std::size_t MAX_COMMENT_SIZE = 0xFFFF;
+
+    if (data.size() < EOCD_SIZE) {
+        return false;
+    }
+
+    const auto first = data.size() - std::min(data.size(), EOCD_SIZE + MAX_COMMENT_SIZE);
+
+    for (auto i = data.size() - EOCD_SIZE + 1; i-- > first;) {
+        if (data[i] == 'P' && data[i + 1] == 'K' && data[i + 2] == 5 && data[i + 3] == 6) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::string fileKey(const MarketDataFileInfo &file) {
+    std::string_view name = file.filename;
+
+    if (name.empty()) {
+        name = file.url;
+        name = name.substr(0, name.find('?'));
+        name = name.substr(name.rfind('/') + 1);
+    }
+
+    std::string retVal(name);
+
+    for (auto &c: retVal) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_' && c != '.') {
+            c = '_';
+        }
+    }
+
+    if (retVal.empty() || retVal.front() == '.') {
+        // FNV-1a of the URL, names starting with a dot are reserved for temporary files
+        std::uint64_t hash = 0xcbf29ce484222325ULL;
+
+        for (const auto c: file.url) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+        }
+
+        retVal = fmt::format("file-{:016x}{}", hash, retVal);
+    }
+
+    return retVal;
+}
+
+std::string storedName(const std::string &key, const std::uint64_t size, const std::uint32_t crc) {
+    return fmt::format("{}.{}.{:08x}", key, size, crc);
+}
+
+/// Inverse of storedName
+bool parseStoredName(const std::string_view name, std::string &key, std::uint64_t &size, std::uint32_t &crc) {
+    const auto crcStart = name.rfind('.');
+
+    if (crcStart == std::string_view::npos || crcStart == 0) {
+        return false;
+    }
+
+    const auto sizeStart = name.rfind('.', crcStart - 1);
+
+    if (sizeStart == std::string_view::npos || sizeStart == 0) {
+        return false;
+    }
+
+    const auto sizeStr = name.substr(sizeStart + 1, crcStart - sizeStart - 1);
+    const auto crcStr = name.substr(crcStart + 1);
+
+    if (const auto [ptr, ec] = std::from_chars(sizeStr.data(), sizeStr.data() + sizeStr.size(), size);
+        ec != std::errc() || ptr != sizeStr.data() + sizeStr.size()) {
+        return false;
+    }
+
+    if (const auto [ptr, ec] = std::from_chars(crcStr.data(), crcStr.data() + crcStr.size(), crc, 16);
+        ec != std::errc() || ptr != crcStr.data() + crcStr.size() || crcStr.size() != 8) {
+        return false;
+    }
+
+    key = name.substr(0, sizeStart);
+    return true;
+}
+
+std::optional<std::vector<std::uint8_t> > readFile(const fs::path &path, const std::uint64_t size) {
+    std::ifstream stream(path, std::ios::binary);
+
+    if (!stream) {
+        return std::nullopt;
+    }
+
+    std::vector<std::uint8_t> retVal(size);
+    stream.read(reinterpret_cast<char *>(retVal.data()), static_cast<std::streamsize>(size));
+
+    // The file must be exactly of the recorded size
+    if (static_cast<std::uint64_t>(stream.gcount()) != size || stream.peek() != std::ifstream::traits_type::eof()) {
+        return std::nullopt;
+    }
+
+    return retVal;
+}
+}
+
+struct MarketDataCache::P {
+    struct Entry {
+        fs::path path;
+        std::uint64_t size = 0;
+        std::uint32_t crc = 0;
+
+        /// Position in the LRU list
+        std::list<std::string>::iterator lruPos;
+    };
+
+    MarketDataCacheOptions options;
+    mutable std::mutex locker;
+    std::map<std::string, Entry, std::less<> > entries;
+
+    /// Keys, most recently used first
+    std::list<std::string> lru;
+    MarketDataCacheStats stats;
+    std::atomic<std::uint64_t> tmpCounter{0};
+
+    explicit P(const MarketDataCacheOptions &options) : options(options) {
+        std::error_code ec;
+        fs::create_directories(options.directory, ec);
+
+        if (ec) {
+            throw std::runtime_error(fmt::format("Unable to create market data cache directory {}: {}", options.directory.string(), ec.message()));
+        }
+
+        scan();
+    }
+
+    /// Index the directory, the LRU order is restored from the modification times
+    void scan() {
+        struct Found {
+            std::string key;
+            Entry entry;
+            fs::file_time_type lastUse;
+        };
+
+        std::vector<Found> found;
+
+        for (const auto &dirEntry: fs::directory_iterator(options.directory)) {
+            if (!dirEntry.is_regular_file()) {
+                continue;
+            }
+
+            const auto name = dirEntry.path().filename().string();
+
+            // Leftover of an interrupted write
+            if (name.starts_with('.') && name.ends_with(TMP_SUFFIX)) {
+                std::error_code ec;
+                fs::remove(dirEntry.path(), ec);
+                continue;
+            }
+
+            Found file;
+
+            if (parseStoredName(name, file.key, file.entry.size, file.entry.crc)) {
+                file.entry.path = dirEntry.path();
+                file.lastUse = dirEntry.last_write_time();
+                found.push_back(std::move(file));
+            }
+        }
+
+        std::ranges::sort(found, [](const Found &a, const Found &b) { return a.lastUse > b.lastUse; });
+
+        for (auto &file: found) {
+            if (entries.contains(file.key)) {
+                // An older version of the same file
+                std::error_code ec;
+                fs::remove(file.entry.path, ec);
+                continue;
+            }
+
+            lru.push_back(file.key);
+            file.entry.lruPos = std::prev(lru.end());
+            stats.bytes += file.entry.size;
+            entries.emplace(std::move(file.key), std::move(file.entry));
+        }
+
+        evict();
+    }
+
+    void remove(const std::map<std::string, Entry, std::less<> >::iterator it) {
+        std::error_code ec;
+        fs::remove(it->second.path, ec);
+        stats.bytes -= it->second.size;
+        lru.erase(it->second.lruPos);
+        entries.erase(it);
+    }
+
+    /// Remove the least recently used files above maxBytes, the most recent file always stays
+    void evict() {
+        while (stats.bytes > options.maxBytes && lru.size() > 1) {
+            remove(entries.find(lru.back()));
+            ++stats.evictions;
+        }
+    }
+};
+
+MarketDataCache::MarketDataCache(const MarketDataCacheOptions &options) : m_p(std::make_unique<P>(options)) {
+}
+
+MarketDataCache::~MarketDataCache() = default;
+
+std::optional<std::vector<std::uint8_t> > MarketDataCache::get(const MarketDataFileInfo &file) const {
+    const auto key = fileKey(file);
+    P::Entry entry;
+
+    {
+        std::lock_guard lk(m_p->locker);
+        const auto it = m_p->entries.find(key);
+
+        if (it == m_p->entries.end()) {
+            ++m_p->stats.misses;
+            return std::nullopt;
+        }
+
+        entry = it->second;
+    }
+
+    // Read and verify without the lock, an evicted file stays readable while it is open
+    auto data = readFile(entry.path, entry.size);
+    const auto valid = data && crc32(*data) == entry.crc;
+
+    std::lock_guard lk(m_p->locker);
+    const auto it = m_p->entries.find(key);
+
+    if (!valid) {
+        ++m_p->stats.misses;
+
+        if (it != m_p->entries.end() && it->second.path == entry.path) {
+            spdlog::warn("Removing corrupted market data cache file {}", entry.path.string());
+            m_p->remove(it);
+            ++m_p->stats.corrupted;
+        }
+
+        return std::nullopt;
+    }
+
+    ++m_p->stats.hits;
+
+    if (it != m_p->entries.end()) {
+        m_p->lru.splice(m_p->lru.begin(), m_p->lru, it->second.lruPos);
+        std::error_code ec;
+        fs::last_write_time(entry.path, fs::file_time_type::clock::now(), ec);
+    }
+
+    return data;
+}
+
+void MarketDataCache::put(const MarketDataFileInfo &file, const std::span<const std::uint8_t> data) const {
+    const auto key = fileKey(file);
+
+    if (!isCompleteZip(data)) {
+        throw std::runtime_error(fmt::format("Market data file {} is not a complete ZIP file, size: {}", key, data.size()));
+    }
+
+    const auto crc = crc32(data);
+    const auto path = m_p->options.directory / storedName(key, data.size(), crc);
+    const auto tmpPath = m_p->options.directory / fmt::format(".{}.{}.{}{}", key, std::hash<std::thread::id>{}(std::this_thread::get_id()),
+                                                              m_p->tmpCounter.fetch_add(1), TMP_SUFFIX);
+
+    {
+        std::ofstream stream(tmpPath, std::ios::binary | std::ios::trunc);
+        stream.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+        stream.close();
+
+        if (!stream) {
+            std::error_code ec;
+            fs::remove(tmpPath, ec);
+            throw std::runtime_error(fmt::format("Unable to write market data cache file {}", tmpPath.string()));
+        }
+    }
+
+    std::lock_guard lk(m_p->locker);
+
+    if (const auto it = m_p->entries.find(key); it != m_p->entries.end()) {
+        if (it->second.path == path) {
+            // Same content stored by another thread meanwhile
+            std::error_code ec;
+            fs::remove(tmpPath, ec);
+            return;
+        }
+
+        m_p->remove(it);
+    }
+
+    std::error_code ec;
+    fs::rename(tmpPath, path, ec);
+
+    if (ec) {
+        fs::remove(tmpPath, ec);
+        throw std::runtime_error(fmt::format("Unable to store market data cache file {}: {}", path.string(), ec.message()));
+    }
+
+    m_p->lru.push_front(key);
+    m_p->entries.emplace(key, P::Entry{path, data.size(), crc, m_p->lru.begin()});
+    m_p->stats.bytes += data.size();
+    ++m_p->stats.stores;
+    m_p->evict();
+}
+
+std::vector<std::uint8_t> MarketDataCache::fetch(const MarketDataFileInfo &file,
+                                                 const std::function<std::vector<std::uint8_t>(const std::string &)> &download) const {
+    if (auto data = get(file)) {
+        return std::move(*data);
+    }
+
+    if (m_p->options.offline) {
+        throw std::runtime_error(fmt::format("Market data file {} is not in the cache and the cache is offline", fileKey(file)));
+    }
+
+    auto data = download(file.url);
+
+    // A file which cannot be cached is still usable, a truncated one fails in the parser
+    try {
+        put(file, data);
+    } catch (const std::exception &e) {
+        spdlog::warn("{}", e.what());
+    }
+
+    return data;
+}
+
+bool MarketDataCache::offline() const {
+    return m_p->options.offline;
+}
+
+void MarketDataCache::clear() const {
+    std::lock_guard lk(m_p->locker);
+
+    while (!m_p->entries.empty()) {
+        m_p->remove(m_p->entries.begin());
+    }
+}
+
+MarketDataCacheStats MarketDataCache::stats() const {
+    std::lock_guard lk(m_p->locker);
+    auto retVal = m_p->stats;
+    retVal.files = m_p->entries.size();
+    return retVal;
+}
+} // namespace stonky::okx
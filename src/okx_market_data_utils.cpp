@@ -7,286 +7,540 @@ Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
 */
 
 #include "stonky/okx/okx_market_data_utils.h"
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <stdexcept>
-#include <sstream>
 #include <charconv>
+#include <cstring>
+#include <limits>
+#include <queue>
 #include <mz.h>
 #include <mz_strm.h>
-#include <mz_strm_mem.h>
 #include <mz_zip.h>
 #include <mz_zip_rw.h>
-#include <set>
 #include <spdlog/spdlog.h>
+#include <fmt/format.h>
 
 namespace stonky::okx::utils {
+namespace {
+bool parseDecimal(const std::string_view str, Decimal &value) {
+#ifdef OKX_USE_CPP_DEC_FLOAT
+    try {
+        value = Decimal(std::string(str));
+        return true;
+    } catch (const std::exception &) {
+        return false;
+    }
+#else
+    /// Fast path for the plain "123.45" form of the CSV files, anything else goes through the full parser
+    std::int64_t mantissa = 0;
+    std::int32_t scale = -1;
+    std::size_t digits = 0;
+
+    for (const auto ch: str) {
+        if (ch >= '0' && ch <= '9') {
+            /// 19 digits may not fit into the mantissa
+            if (digits == 18) {
+                return Decimal::tryParse(str, value);
+            }
 
-std::vector<std::uint8_t> extractZip(const std::vector<std::uint8_t> &zipData) {
-    // Create memory stream from input data
-    void *memStream = mz_stream_mem_create();
+            mantissa = mantissa * 10 + (ch - '0');
+            ++digits;
+            scale += scale >= 0;
+        } else if (ch == '.' && scale < 0) {
+            scale = 0;
+        } else {
+            return Decimal::tryParse(str, value);
+        }
+    }
 
-    if (!memStream) {
-        throw std::runtime_error("Failed to create memory stream");
+    if (digits == 0) {
+        return Decimal::tryParse(str, value);
     }
 
-    mz_stream_mem_set_buffer(memStream, const_cast<void *>(static_cast<const void *>(zipData.data())), static_cast<int32_t>(zipData.size()));
-    mz_stream_open(memStream, nullptr, MZ_OPEN_MODE_READ);
+    value = Decimal::fromMantissa(mantissa, scale);
+    return true;
+#endif
+}
 
-    // Create zip reader
-    void *zipReader = mz_zip_reader_create();
+/// vol_ccy and vol_quote may be "None" or empty, both mean zero
+bool parseOptionalDecimal(const std::string_view str, Decimal &value) {
+    if (str.empty() || str == "None") {
+        value = Decimal{};
+        return true;
+    }
 
-    if (!zipReader) {
-        mz_stream_mem_delete(&memStream);
-        throw std::runtime_error("Failed to create ZIP reader");
+    return parseDecimal(str, value);
+}
+
+bool parseInt64(const std::string_view str, std::int64_t &value) {
+    const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+    return ec == std::errc() && ptr == str.data() + str.size();
+}
+
+/**
+ * Position of the first comma, 8 bytes are tested at once (SWAR). A byte equal to ',' becomes zero after the xor and
+ * the lowest zero byte of the word is found exactly, false positives can only follow it.
+ */
+const char *findComma(const char *it, const char *end) {
+    constexpr std::uint64_t ONES = 0x0101010101010101ull;
+    constexpr std::uint64_t HIGHS = 0x8080808080808080ull;
+    constexpr std::uint64_t COMMAS = ONES * static_cast<std::uint8_t>(',');
+
+    for (; end - it >= 8; it += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, it, sizeof(word));
+        word ^= COMMAS;
+
+        if (const auto found = (word - ONES) & ~word & HIGHS) {
+            if constexpr (std::endian::native == std::endian::little) {
+                return it + std::countr_zero(found) / 8;
+            } else {
+                return it + std::countl_zero(found) / 8;
+            }
+        }
     }
 
-    if (mz_zip_reader_open(zipReader, memStream) != MZ_OK) {
-        mz_zip_reader_delete(&zipReader);
-        mz_stream_mem_delete(&memStream);
-        throw std::runtime_error("Failed to open ZIP archive");
+    while (it != end && *it != ',') {
+        ++it;
     }
 
-    // Go to first entry
-    if (mz_zip_reader_goto_first_entry(zipReader) != MZ_OK) {
-        mz_zip_reader_close(zipReader);
-        mz_zip_reader_delete(&zipReader);
-        mz_stream_mem_delete(&memStream);
-        throw std::runtime_error("ZIP archive is empty");
+    return it;
+}
+
+/**
+ * Split the line into fields
+ * @return Number of fields found, at most fields.size(). The last field holds the rest of the line.
+ */
+template<std::size_t N>
+std::size_t splitFields(const std::string_view line, std::array<std::string_view, N> &fields) {
+    const char *it = line.data();
+    const char *end = it + line.size();
+    std::size_t retVal = 0;
+
+    while (retVal + 1 < N) {
+        const auto *comma = findComma(it, end);
+        fields[retVal++] = std::string_view(it, comma - it);
+
+        if (comma == end) {
+            return retVal;
+        }
+
+        it = comma + 1;
     }
 
-    // Get file info
-    mz_zip_file *fileInfo = nullptr;
+    fields[retVal++] = std::string_view(it, end - it);
+    return retVal;
+}
 
-    if (mz_zip_reader_entry_get_info(zipReader, &fileInfo) != MZ_OK) {
-        mz_zip_reader_close(zipReader);
-        mz_zip_reader_delete(&zipReader);
-        mz_stream_mem_delete(&memStream);
-        throw std::runtime_error("Failed to get file info from ZIP");
+/**
+ * Split the text into lines, a trailing \r is removed. The line ends are found by memchr, which is vectorized by the
+ * C library.
+ * @return false if the callback stopped reading
+ */
+template<typename Callback>
+bool splitLines(std::string_view text, Callback &&onLine) {
+    while (!text.empty()) {
+        const auto pos = text.find('\n');
+        auto line = text.substr(0, pos);
+
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+
+        if (!onLine(line)) {
+            return false;
+        }
+
+        if (pos == std::string_view::npos) {
+            break;
+        }
+
+        text.remove_prefix(pos + 1);
+    }
+
+    return true;
+}
+
+/**
+ * Drop rows with a timestamp seen before, the first one is kept. The rows are sorted by the timestamp first unless
+ * they already are, then the duplicates form runs next to each other.
+ */
+template<typename Row, typename Key>
+void dedupSortedRuns(std::vector<Row> &rows, Key key) {
+    const auto byKey = [&key](const Row &a, const Row &b) { return key(a) < key(b); };
+
+    if (!std::ranges::is_sorted(rows, byKey)) {
+        std::ranges::stable_sort(rows, byKey);
     }
 
-    // Allocate buffer for decompressed data
-    std::vector<std::uint8_t> result(static_cast<size_t>(fileInfo->uncompressed_size));
+    const auto duplicates = std::ranges::unique(rows, [&key](const Row &a, const Row &b) { return key(a) == key(b); });
+    rows.erase(duplicates.begin(), duplicates.end());
+}
 
-    // Open and read entry
-    if (mz_zip_reader_entry_open(zipReader) != MZ_OK) {
-        mz_zip_reader_close(zipReader);
-        mz_zip_reader_delete(&zipReader);
-        mz_stream_mem_delete(&memStream);
-        throw std::runtime_error("Failed to open ZIP entry");
+/// Candle rows of one CSV file, fed line by line
+class CandleCsvParser {
+    std::vector<Candle> &m_candles;
+    std::string_view m_instId;
+    bool m_isFirstLine = true;
+    int m_linesSkipped = 0;
+
+    void skip(const std::string_view line, const std::string_view reason) {
+        if (m_linesSkipped < 5) {
+            spdlog::warn("Failed to parse CSV line: {} - error: {}", line, reason);
+        }
+
+        m_linesSkipped++;
+    }
+
+public:
+    explicit CandleCsvParser(std::vector<Candle> &candles, const std::string_view instId = {}) : m_candles(candles), m_instId(instId) {
     }
 
-    const int32_t bytes_read = mz_zip_reader_entry_read(zipReader, result.data(), static_cast<int32_t>(result.size()));
-    if (bytes_read < 0) {
-        mz_zip_reader_entry_close(zipReader);
+    bool parseLine(const std::string_view line) {
+        // Skip empty lines
+        if (line.empty()) {
+            return true;
+        }
+
+        // Skip header line (may contain Chinese characters in legacy data)
+        if (m_isFirstLine) {
+            m_isFirstLine = false;
+
+            if (!std::isdigit(static_cast<unsigned char>(line[0]))) {
+                return true;
+            }
+        }
+
+        // OKX market data history CSV format (10 fields):
+        // instrument_name,open,high,low,close,vol,vol_ccy,vol_quote,open_time,confirm
+        std::array<std::string_view, 10> fields{};
+
+        if (const auto numFields = splitFields(line, fields); numFields < fields.size()) {
+            if (m_linesSkipped < 5) {
+                spdlog::warn("CSV line has {} fields (expected 10): {}", numFields, line);
+            }
+
+            m_linesSkipped++;
+            return true;
+        }
+
+        // Files of an instrument family contain all its instruments
+        if (!m_instId.empty() && fields[0] != m_instId) {
+            return true;
+        }
+
+        // Skip unconfirmed candles
+        if (fields[9] != "1" && fields[9] != "true" && fields[9] != "True") {
+            return true;
+        }
+
+        std::int64_t ts = 0;
+
+        if (!parseInt64(fields[8], ts)) {
+            skip(line, "invalid open_time");
+            return true;
+        }
+
+        // OKX ZIP files contain duplicate rows per candle, usually next to each other, the rest is removed in finish()
+        if (!m_candles.empty() && m_candles.back().ts == ts) {
+            return true;
+        }
+
+        auto &candle = m_candles.emplace_back();
+        candle.ts = ts;
+        candle.confirm = true;
+
+        if (!parseDecimal(fields[1], candle.o) || !parseDecimal(fields[2], candle.h) || !parseDecimal(fields[3], candle.l) ||
+            !parseDecimal(fields[4], candle.c) || !parseDecimal(fields[5], candle.vol) || !parseOptionalDecimal(fields[6], candle.volCcy) ||
+            !parseOptionalDecimal(fields[7], candle.volCcyQuote)) {
+            m_candles.pop_back();
+            skip(line, "invalid number");
+        }
+
+        return true;
+    }
+
+    void finish() const {
+        dedupSortedRuns(m_candles, [](const Candle &candle) { return candle.ts; });
+    }
+};
+
+std::vector<Candle> parseCandles(const std::string_view csvContent) {
+    std::vector<Candle> candles;
+    /// Rows of the OKX files have 80 - 120 bytes and every one is there twice
+    candles.reserve(csvContent.size() / 160);
+    CandleCsvParser parser(candles);
+
+    splitLines(csvContent, [&parser](const std::string_view line) { return parser.parseLine(line); });
+    parser.finish();
+    return candles;
+}
+
+std::vector<Candle> parseCandles(const ZipEntryReader &reader, const std::string_view instId) {
+    std::vector<Candle> candles;
+    CandleCsvParser parser(candles, instId);
+
+    forEachCsvLine(reader, [&parser](const std::string_view line) { return parser.parseLine(line); });
+    parser.finish();
+    return candles;
+}
+}
+
+struct ZipEntryReader::P {
+    void *zipReader = nullptr;
+    bool entryOpen = false;
+    std::uint64_t uncompressedSize = 0;
+
+    P() : zipReader(mz_zip_reader_create()) {
+        if (!zipReader) {
+            throw std::runtime_error("Failed to create ZIP reader");
+        }
+    }
+
+    ~P() {
+        if (entryOpen) {
+            mz_zip_reader_entry_close(zipReader);
+        }
+
         mz_zip_reader_close(zipReader);
         mz_zip_reader_delete(&zipReader);
-        mz_stream_mem_delete(&memStream);
-        throw std::runtime_error("Failed to extract file from ZIP");
     }
 
-    result.resize(static_cast<size_t>(bytes_read));
+    void openFirstEntry() {
+        if (mz_zip_reader_goto_first_entry(zipReader) != MZ_OK) {
+            throw std::runtime_error("ZIP archive is empty");
+        }
 
-    // Cleanup
-    mz_zip_reader_entry_close(zipReader);
-    mz_zip_reader_close(zipReader);
-    mz_zip_reader_delete(&zipReader);
-    mz_stream_mem_delete(&memStream);
+        mz_zip_file *fileInfo = nullptr;
 
-    return result;
+        if (mz_zip_reader_entry_get_info(zipReader, &fileInfo) != MZ_OK) {
+            throw std::runtime_error("Failed to get file info from ZIP");
+        }
+
+        uncompressedSize = static_cast<std::uint64_t>(fileInfo->uncompressed_size);
+
+        if (mz_zip_reader_entry_open(zipReader) != MZ_OK) {
+            throw std::runtime_error("Failed to open ZIP entry");
+        }
+
+        entryOpen = true;
+    }
+};
+
+ZipEntryReader::ZipEntryReader(const std::span<const std::uint8_t> zipData) : m_p(std::make_unique<P>()) {
+    if (zipData.size() > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max())) {
+        throw std::runtime_error(fmt::format("ZIP archive of {} bytes is too large for a memory buffer, read it from a file", zipData.size()));
+    }
+
+    if (mz_zip_reader_open_buffer(m_p->zipReader, const_cast<std::uint8_t *>(zipData.data()), static_cast<std::int32_t>(zipData.size()), 0) != MZ_OK) {
+        throw std::runtime_error("Failed to open ZIP archive");
+    }
+
+    m_p->openFirstEntry();
 }
 
-std::vector<Candle> parseCandlesCsv(const std::vector<std::uint8_t> &csvData) {
-    const std::string csvContent(reinterpret_cast<const char *>(csvData.data()), csvData.size());
-    return parseCandlesCsv(csvContent);
+ZipEntryReader::ZipEntryReader(const std::filesystem::path &zipFile) : m_p(std::make_unique<P>()) {
+    if (mz_zip_reader_open_file(m_p->zipReader, zipFile.string().c_str()) != MZ_OK) {
+        throw std::runtime_error(fmt::format("Failed to open ZIP archive: {}", zipFile.string()));
+    }
+
+    m_p->openFirstEntry();
 }
 
-std::vector<Candle> parseCandlesCsv(const std::string &csvContent) {
-    std::vector<Candle> candles;
-    std::set<std::int64_t> seenTimestamps;
-    std::istringstream stream(csvContent);
-    std::string line;
-    bool isFirstLine = true;
-    int linesProcessed = 0;
-    int linesSkipped = 0;
+ZipEntryReader::~ZipEntryReader() = default;
 
-    while (std::getline(stream, line)) {
-        // Handle Windows line endings (remove trailing \r)
-        if (!line.empty() && line.back() == '\r') {
-            line.pop_back();
+std::uint64_t ZipEntryReader::uncompressedSize() const {
+    return m_p->uncompressedSize;
+}
+
+std::size_t ZipEntryReader::read(std::uint8_t *data, const std::size_t size) const {
+    const auto chunkSize = static_cast<std::int32_t>(std::min(size, static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max())));
+    const auto bytesRead = mz_zip_reader_entry_read(m_p->zipReader, data, chunkSize);
+
+    if (bytesRead < 0) {
+        throw std::runtime_error(fmt::format("Failed to extract file from ZIP, error: {}", bytesRead));
+    }
+
+    return static_cast<std::size_t>(bytesRead);
+}
+
+std::uint64_t forEachCsvLine(const ZipEntryReader &reader, const onCsvLine &onCsvLineCB, const std::size_t windowSize) {
+    std::vector<char> window(std::max<std::size_t>(windowSize, 1));
+    std::size_t used = 0;
+    std::uint64_t retVal = 0;
+
+    while (true) {
+        if (used == window.size()) {
+            /// A line longer than the window
+            window.resize(window.size() * 2);
         }
 
-        // Skip empty lines
-        if (line.empty()) {
+        const auto bytesRead = reader.read(reinterpret_cast<std::uint8_t *>(window.data() + used), window.size() - used);
+
+        if (bytesRead == 0) {
+            /// Last line without a line ending
+            splitLines(std::string_view(window.data(), used), onCsvLineCB);
+            return retVal;
+        }
+
+        retVal += bytesRead;
+        used += bytesRead;
+
+        /// Complete lines are passed, the incomplete tail is moved to the front of the window
+        const std::string_view text(window.data(), used);
+        const auto lastLineEnd = text.rfind('\n');
+
+        if (lastLineEnd == std::string_view::npos) {
             continue;
         }
 
-        // Skip header line (may contain Chinese characters in legacy data)
-        if (isFirstLine) {
-            isFirstLine = false;
-            // Check if this looks like a header (contains non-digit first character or known headers)
-            if (!line.empty() && !std::isdigit(static_cast<unsigned char>(line[0]))) {
-                continue;
-            }
+        if (!splitLines(text.substr(0, lastLineEnd + 1), onCsvLineCB)) {
+            return retVal;
         }
 
-        // Parse CSV line: ts,o,h,l,c,vol,volCcy,volCcyQuote,confirm
-        std::istringstream lineStream(line);
-        std::string field;
-        std::vector<std::string> fields;
+        used -= lastLineEnd + 1;
+        std::memmove(window.data(), window.data() + lastLineEnd + 1, used);
+    }
+}
 
-        while (std::getline(lineStream, field, ',')) {
-            fields.push_back(field);
+std::vector<std::uint8_t> extractZip(const std::vector<std::uint8_t> &zipData) {
+    const ZipEntryReader reader(zipData);
+    std::vector<std::uint8_t> result(static_cast<std::size_t>(reader.uncompressedSize()));
+    std::size_t size = 0;
+
+    while (true) {
+        if (size == result.size()) {
+            /// The stored size is only a hint
+            result.resize(std::max(result.size() * 2, CSV_WINDOW_SIZE));
         }
 
-        // OKX market data history CSV format (10 fields):
-        // instrument_name,open,high,low,close,vol,vol_ccy,vol_quote,open_time,confirm
-        if (fields.size() < 10) {
-            if (linesSkipped < 5) {
-                spdlog::warn("CSV line has {} fields (expected 10): {}", fields.size(), line);
-            }
-            linesSkipped++;
-            continue; // Skip malformed lines
-        }
-
-        linesProcessed++;
-
-        try {
-            Candle candle;
-
-            // fields[0] = instrument_name (skip)
-            // fields[1] = open
-            // fields[2] = high
-            // fields[3] = low
-            // fields[4] = close
-            // fields[5] = vol
-            // fields[6] = vol_ccy (may be "None")
-            // fields[7] = vol_quote (may be "None")
-            // fields[8] = open_time (timestamp)
-            // fields[9] = confirm
-
-            // Parse timestamp from open_time field
-            std::int64_t ts = 0;
-            if (auto [ptr, ec] = std::from_chars(fields[8].data(), fields[8].data() + fields[8].size(), ts); ec == std::errc()) {
-                candle.ts = ts;
-            }
+        const auto bytesRead = reader.read(result.data() + size, result.size() - size);
+
+        if (bytesRead == 0) {
+            break;
+        }
 
-            // Parse OHLC values
-            candle.o = boost::multiprecision::cpp_dec_float_50(fields[1]);
-            candle.h = boost::multiprecision::cpp_dec_float_50(fields[2]);
-            candle.l = boost::multiprecision::cpp_dec_float_50(fields[3]);
-            candle.c = boost::multiprecision::cpp_dec_float_50(fields[4]);
+        size += bytesRead;
+    }
 
-            // Parse volume - always present
-            candle.vol = boost::multiprecision::cpp_dec_float_50(fields[5]);
+    result.resize(size);
+    return result;
+}
 
-            // Parse vol_ccy and vol_quote - may be "None"
-            if (fields[6] != "None" && !fields[6].empty()) {
-                candle.volCcy = boost::multiprecision::cpp_dec_float_50(fields[6]);
-            } else {
-                candle.volCcy = 0;
-            }
+std::vector<Candle> parseCandlesCsv(const std::vector<std::uint8_t> &csvData) {
+    return parseCandles(std::string_view(reinterpret_cast<const char *>(csvData.data()), csvData.size()));
+}
 
-            if (fields[7] != "None" && !fields[7].empty()) {
-                candle.volCcyQuote = boost::multiprecision::cpp_dec_float_50(fields[7]);
-            } else {
-                candle.volCcyQuote = 0;
-            }
+std::vector<Candle> parseCandlesCsv(const std::string &csvContent) {
+    return parseCandles(std::string_view(csvContent));
+}
 
-            // Parse confirm flag
-            candle.confirm = (fields[9] == "1" || fields[9] == "true" || fields[9] == "True");
+std::vector<Candle> parseCandlesZip(const std::vector<std::uint8_t> &zipData, const std::string_view instId) {
+    return parseCandles(ZipEntryReader(zipData), instId);
+}
 
-            // Skip unconfirmed candles
-            if (!candle.confirm) {
-                continue;
-            }
+std::vector<Candle> parseCandlesZip(const std::filesystem::path &zipFile, const std::string_view instId) {
+    return parseCandles(ZipEntryReader(zipFile), instId);
+}
 
-            // OKX ZIP files contain duplicate rows per candle - deduplicate by timestamp
-            if (seenTimestamps.contains(candle.ts)) {
-                continue;
-            }
-            seenTimestamps.insert(candle.ts);
+std::vector<Candle> mergeSortedCandles(std::vector<std::vector<Candle> > runs) {
+    std::erase_if(runs, [](const std::vector<Candle> &run) { return run.empty(); });
 
-            candles.push_back(candle);
-        } catch (const std::exception &e) {
-            // Log first few parse errors
-            if (linesSkipped < 5) {
-                spdlog::warn("Failed to parse CSV line: {} - error: {}", line, e.what());
-            }
-            linesSkipped++;
+    if (runs.size() == 1) {
+        return std::move(runs.front());
+    }
+
+    std::size_t total = 0;
+
+    for (const auto &run: runs) {
+        total += run.size();
+    }
+
+    std::vector<Candle> retVal;
+    retVal.reserve(total);
+
+    /// Min-heap of (run, position) ordered by the timestamp, ties by the run
+    using Cursor = std::pair<std::size_t, std::size_t>;
+    const auto later = [&runs](const Cursor &a, const Cursor &b) {
+        const auto tsA = runs[a.first][a.second].ts;
+        const auto tsB = runs[b.first][b.second].ts;
+        return tsA > tsB || (tsA == tsB && a.first > b.first);
+    };
+
+    std::priority_queue<Cursor, std::vector<Cursor>, decltype(later)> heap(later);
+
+    for (std::size_t run = 0; run < runs.size(); ++run) {
+        heap.emplace(run, 0);
+    }
+
+    while (!heap.empty()) {
+        auto [run, position] = heap.top();
+        heap.pop();
+
+        /// Copy the whole stretch of the run which comes before the next run's head
+        const auto limit = heap.empty() ? std::numeric_limits<std::int64_t>::max() : runs[heap.top().first][heap.top().second].ts;
+        const auto tieWins = heap.empty() || run < heap.top().first;
+        auto end = position + 1;
+
+        while (end < runs[run].size() && (runs[run][end].ts < limit || (runs[run][end].ts == limit && tieWins))) {
+            ++end;
+        }
+
+        retVal.insert(retVal.end(), std::make_move_iterator(runs[run].begin() + static_cast<std::ptrdiff_t>(position)),
+                      std::make_move_iterator(runs[run].begin() + static_cast<std::ptrdiff_t>(end)));
+
+        if (end < runs[run].size()) {
+            heap.emplace(run, end);
         }
     }
 
-    return candles;
+    return retVal;
 }
 
 std::vector<FundingRate> parseFundingRateCsv(const std::vector<std::uint8_t> &csvData) {
-    const std::string csvContent(reinterpret_cast<const char *>(csvData.data()), csvData.size());
-
     std::vector<FundingRate> rates;
-    std::set<std::int64_t> seenTimestamps;
-    std::istringstream stream(csvContent);
-    std::string line;
     bool isFirstLine = true;
 
-    while (std::getline(stream, line)) {
-        // Handle Windows line endings
-        if (!line.empty() && line.back() == '\r') {
-            line.pop_back();
-        }
-
+    splitLines(std::string_view(reinterpret_cast<const char *>(csvData.data()), csvData.size()), [&](const std::string_view line) {
         if (line.empty()) {
-            continue;
+            return true;
         }
 
         if (isFirstLine) {
             isFirstLine = false;
-            if (!line.empty() && !std::isdigit(static_cast<unsigned char>(line[0]))) {
-                continue;
+
+            if (!std::isdigit(static_cast<unsigned char>(line[0]))) {
+                return true;
             }
         }
 
         // Parse CSV line - two formats supported:
         // Bulk download (3 fields): instrument_name,funding_rate,funding_time
         // REST API     (4 fields): instId,fundingRate,realizedRate,fundingTime
-        std::istringstream lineStream(line);
-        std::string field;
-        std::vector<std::string> fields;
-
-        while (std::getline(lineStream, field, ',')) {
-            fields.push_back(field);
-        }
+        std::array<std::string_view, 5> fields{};
+        const auto numFields = splitFields(line, fields);
 
-        if (fields.size() < 3) {
-            continue;
+        if (numFields < 3 || fields[1] == "None" || fields[1].empty()) {
+            return true;
         }
 
-        try {
-            if (fields[1] == "None" || fields[1].empty()) {
-                continue;
-            }
-            FundingRate rate;
-            rate.instId = fields[0];
-            rate.fundingRate = boost::multiprecision::cpp_dec_float_50(fields[1]);
-
-            // Determine funding_time field position based on number of fields
-            const auto &timeField = (fields.size() >= 4) ? fields[3] : fields[2];
+        FundingRate rate;
 
-            std::int64_t fundingTime = 0;
-            if (auto [ptr, ec] = std::from_chars(timeField.data(), timeField.data() + timeField.size(), fundingTime); ec == std::errc()) {
-                rate.fundingTime = fundingTime;
-            }
-
-            // Deduplicate by funding_time
-            if (seenTimestamps.contains(rate.fundingTime)) {
-                continue;
-            }
-            seenTimestamps.insert(rate.fundingTime);
-
-            rates.push_back(rate);
-        } catch (const std::exception &e) {
-            spdlog::warn("Exception in parseFundingRateCsv: {}", e.what());
+        // Determine funding_time field position based on number of fields
+        if (!parseDecimal(fields[1], rate.fundingRate) || !parseInt64(numFields >= 4 ? fields[3] : fields[2], rate.fundingTime)) {
+            spdlog::warn("Failed to parse funding rate CSV line: {}", line);
+            return true;
         }
-    }
 
+        rate.instId = fields[0];
+        rates.push_back(std::move(rate));
+        return true;
+    });
+
+    // Deduplicate by funding_time
+    dedupSortedRuns(rates, [](const FundingRate &rate) { return rate.fundingTime; });
     return rates;
 }
 
@@ -9,13 +9,12 @@ Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
 #include "stonky/okx/okx_models.h"
 #include "stonky/utils/utils.h"
 #include "stonky/utils/json_utils.h"
-#include <boost/multiprecision/cpp_dec_float.hpp>
 #include <utility>
 
 namespace stonky::okx {
 bool
-readDecimalValue(const nlohmann::json &json, const std::string &key, boost::multiprecision::cpp_dec_float_50 &value,
-                 boost::multiprecision::cpp_dec_float_50 defaultVal = boost::multiprecision::cpp_dec_float_50("0")) {
+readDecimalValue(const nlohmann::json &json, const std::string &key, Decimal &value,
+                 Decimal defaultVal = Decimal("0")) {
     if (const auto it = json.find(key); it != json.end()) {
         if (!it.value().is_null() && it->is_string() && !it->get<std::string>().empty()) {
             value.assign(it->get<std::string>());
@@ -84,13 +83,13 @@ nlohmann::json Candle::toJson() const {
 
 void Candle::fromJson(const nlohmann::json &json) {
     ts = stoll(json[0].get<std::string>());
-    o = boost::multiprecision::cpp_dec_float_50(json[1].get<std::string>());
-    h = boost::multiprecision::cpp_dec_float_50(json[2].get<std::string>());
-    l = boost::multiprecision::cpp_dec_float_50(json[3].get<std::string>());
-    c = boost::multiprecision::cpp_dec_float_50(json[4].get<std::string>());
-    vol = boost::multiprecision::cpp_dec_float_50(json[5].get<std::string>());
-    volCcy = boost::multiprecision::cpp_dec_float_50(json[6].get<std::string>());
-    volCcyQuote = boost::multiprecision::cpp_dec_float_50(json[7].get<std::string>());
+    o = Decimal(json[1].get<std::string>());
+    h = Decimal(json[2].get<std::string>());
+    l = Decimal(json[3].get<std::string>());
+    c = Decimal(json[4].get<std::string>());
+    vol = Decimal(json[5].get<std::string>());
+    volCcy = Decimal(json[6].get<std::string>());
+    volCcyQuote = Decimal(json[7].get<std::string>());
     confirm = string2bool(json[8].get<std::string>());
 }
 
@@ -337,7 +336,7 @@ nlohmann::json Order::toJson() const {
     json["posSide"] = magic_enum::enum_name(posSide);
     json["ordType"] = ordType;
     json["sz"] = sz.str();
-    json["px"] = px.str(3);
+    json["px"] = px.str();
 
     return json;
 }
@@ -0,0 +1,465 @@
+/**
+OKX Order Book
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
+*/
+
+#include "stonky/okx/okx_order_book.h"
+#include <algorithm>
+#include <array>
+
+namespace stonky::okx {
+namespace {
+/// Number of levels of each side covered by the OKX checksum
+constexpr std::size_t CHECKSUM_DEPTH = 25;
+
+/// Maximum span of one side in ticks, a level further from the rest of the book is not stored
+constexpr std::int64_t MAX_LADDER_TICKS = 1 << 20;
+
+constexpr std::int64_t LADDER_MARGIN = 64;
+
+constexpr std::array<std::int64_t, 19> POWERS_OF_TEN = [] {
+    std::array<std::int64_t, 19> retVal{};
+    retVal[0] = 1;
+
+    for (std::size_t i = 1; i < retVal.size(); ++i) {
+        retVal[i] = retVal[i - 1] * 10;
+    }
+
+    return retVal;
+}();
+
+/// Slicing-by-8 tables of CRC32 (IEEE), the checksum covers up to 100 numbers per message
+constexpr std::array<std::array<std::uint32_t, 256>, 8> CRC32_TABLES = [] {
+    std::array<std::array<std::uint32_t, 256>, 8> retVal{};
+
+    for (std::uint32_t i = 0; i < 256; ++i) {
+        std::uint32_t crc = i;
+
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = crc & 1 ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+        }
+
+        retVal[0][i] = crc;
+    }
+
+    for (std::size_t slice = 1; slice < retVal.size(); ++slice) {
+        for (std::size_t i = 0; i < 256; ++i) {
+            retVal[slice][i] = retVal[0][retVal[slice - 1][i] & 0xFF] ^ (retVal[slice - 1][i] >> 8);
+        }
+    }
+
+    return retVal;
+}();
+
+std::uint32_t crc32(const std::string_view data) {
+    const auto &tables = CRC32_TABLES;
+    std::uint32_t crc = 0xFFFFFFFFu;
+    const auto *it = reinterpret_cast<const std::uint8_t *>(data.data());
+    const auto *end = it + data.size();
+
+    for (; end - it >= 8; it += 8) {
+        const std::uint32_t low = crc ^ (it[0] | it[1] << 8 | it[2] << 16 | static_cast<std::uint32_t>(it[3]) << 24);
+        crc = tables[7][low & 0xFF] ^ tables[6][low >> 8 & 0xFF] ^ tables[5][low >> 16 & 0xFF] ^ tables[4][low >> 24] ^
+              tables[3][it[4]] ^ tables[2][it[5]] ^ tables[1][it[6]] ^ tables[0][it[7]];
+    }
+
+    for (; it != end; ++it) {
+        crc = tables[0][(crc ^ *it) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc ^ 0xFFFFFFFFu;
+}
+
+/**
+ * Write mantissa * 10^-scale keeping the scale, the same form as Decimal64::str()
+ * @return end of the written text
+ */
+char *appendDecimal(char *out, std::int64_t mantissa, const std::int32_t scale) {
+    std::array<char, 24> digits{};
+    auto it = digits.end();
+    std::int32_t written = 0;
+
+    if (mantissa < 0) {
+        *out++ = '-';
+        mantissa = -mantissa;
+    }
+
+    do {
+        *--it = static_cast<char>('0' + mantissa % 10);
+        mantissa /= 10;
+
+        if (++written == scale) {
+            *--it = '.';
+        }
+    } while (mantissa != 0 || written < scale);
+
+    if (*it == '.') {
+        *--it = '0';
+    }
+
+    return std::copy(it, digits.end(), out);
+}
+
+/// Level of the ladder, the price is given by its index. Empty levels have sz == 0.
+struct Slot {
+    std::int64_t sz = 0;
+    std::int32_t numOrders = 0;
+    std::int8_t szScale = 0;
+
+    /// Scale of the price as received, it can be smaller than the book's price scale ("3366" next to "3366.1")
+    std::int8_t pxScale = 0;
+};
+
+static_assert(sizeof(Slot) == 16);
+
+/**
+ * One side of the book, a dense array of levels indexed by price tick relative to m_baseTick. The array only grows,
+ * so a steady book does not allocate.
+ */
+class Ladder {
+    bool m_bids;
+    std::vector<Slot> m_slots;
+    std::int64_t m_baseTick = 0;
+    std::int64_t m_best = -1;
+    std::size_t m_count = 0;
+
+    /// Index step from the best level towards worse ones
+    [[nodiscard]] std::int64_t worseStep() const { return m_bids ? -1 : 1; }
+
+    [[nodiscard]] bool isBetter(const std::int64_t index, const std::int64_t than) const { return m_bids ? index > than : index < than; }
+
+    [[nodiscard]] std::int64_t size() const { return static_cast<std::int64_t>(m_slots.size()); }
+
+    /**
+     * Extend the array to cover the tick
+     * @return false if the tick is too far from the stored levels
+     */
+    bool grow(const std::int64_t tick) {
+        const auto low = m_slots.empty() ? tick : std::min(m_baseTick, tick);
+        const auto high = m_slots.empty() ? tick + 1 : std::max(m_baseTick + size(), tick + 1);
+
+        if (high - low > MAX_LADDER_TICKS) {
+            return false;
+        }
+
+        const auto margin = std::min(std::max(LADDER_MARGIN, (high - low) / 2), (MAX_LADDER_TICKS - (high - low)) / 2);
+        const auto newBase = low - margin;
+        std::vector<Slot> slots(static_cast<std::size_t>(high - low + 2 * margin));
+
+        if (!m_slots.empty()) {
+            std::ranges::copy(m_slots, slots.begin() + (m_baseTick - newBase));
+
+            if (m_best >= 0) {
+                m_best += m_baseTick - newBase;
+            }
+        }
+
+        m_slots = std::move(slots);
+        m_baseTick = newBase;
+        return true;
+    }
+
+public:
+    explicit Ladder(const bool bids) : m_bids(bids) {
+    }
+
+    /**
+     * Store the level, a zero size removes it
+     * @return false if the level was too far from the book to be stored
+     */
+    bool set(const std::int64_t tick, const Slot &slot) {
+        auto index = tick - m_baseTick;
+
+        if (slot.sz == 0) {
+            if (index < 0 || index >= size() || m_slots[index].sz == 0) {
+                return true;
+            }
+
+            m_slots[index] = Slot{};
+            --m_count;
+
+            if (index == m_best) {
+                m_best = -1;
+
+                for (auto i = index; m_count > 0 && i >= 0 && i < size(); i += worseStep()) {
+                    if (m_slots[i].sz != 0) {
+                        m_best = i;
+                        break;
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        if (index < 0 || index >= size()) {
+            if (!grow(tick)) {
+                return false;
+            }
+
+            index = tick - m_baseTick;
+        }
+
+        if (m_slots[index].sz == 0) {
+            ++m_count;
+        }
+
+        m_slots[index] = slot;
+
+        if (m_best < 0 || isBetter(index, m_best)) {
+            m_best = index;
+        }
+
+        return true;
+    }
+
+    /**
+     * Remove all levels, only the occupied slots are touched
+     */
+    void clear() {
+        for (auto i = m_best; m_count > 0 && i >= 0 && i < size(); i += worseStep()) {
+            if (m_slots[i].sz != 0) {
+                m_slots[i] = Slot{};
+                --m_count;
+            }
+        }
+
+        m_best = -1;
+        m_count = 0;
+    }
+
+    /**
+     * Remove all levels and release the array, needed when the tick size changes
+     */
+    void reset() {
+        m_slots.clear();
+        m_baseTick = 0;
+        m_best = -1;
+        m_count = 0;
+    }
+
+    [[nodiscard]] std::size_t count() const { return m_count; }
+
+    /**
+     * Call f(tick, slot) for up to depth levels, best first
+     */
+    template<typename Function>
+    void forEach(const std::size_t depth, Function &&f) const {
+        std::size_t visited = 0;
+
+        for (auto i = m_best; visited < std::min(depth, m_count) && i >= 0 && i < size(); i += worseStep()) {
+            if (m_slots[i].sz != 0) {
+                f(m_baseTick + i, m_slots[i]);
+                ++visited;
+            }
+        }
+    }
+};
+}
+
+struct OrderBook::P {
+    /// books5 and bbo-tbt send only snapshots without sequence ids and checksum
+    bool sequenced = true;
+    bool verifyChecksum = true;
+    bool valid = false;
+    Ladder bidLadder{true};
+    Ladder askLadder{false};
+
+    /// Ticks are prices in units of 10^-priceScale
+    std::int32_t priceScale = 0;
+
+    std::int64_t seqId = -1;
+    std::int64_t ts = 0;
+
+    explicit P(const std::string_view channel) : sequenced(channel != "books5" && channel != "bbo-tbt") {
+    }
+
+    [[nodiscard]] std::int64_t toTick(const Decimal64 &px) const { return px.mantissa() * POWERS_OF_TEN[priceScale - px.scale()]; }
+
+    [[nodiscard]] BookLevel toLevel(const std::int64_t tick, const Slot &slot) const {
+        BookLevel retVal;
+        retVal.px = Decimal64::fromMantissa(tick / POWERS_OF_TEN[priceScale - slot.pxScale], slot.pxScale);
+        retVal.sz = Decimal64::fromMantissa(slot.sz, slot.szScale);
+        retVal.numOrders = slot.numOrders;
+        return retVal;
+    }
+
+    /**
+     * Switch to a finer price scale, all stored levels are re-indexed
+     */
+    void rescale(const std::int32_t scale) {
+        std::vector<std::pair<std::int64_t, Slot> > bidSlots;
+        std::vector<std::pair<std::int64_t, Slot> > askSlots;
+        const auto factor = POWERS_OF_TEN[scale - priceScale];
+
+        bidLadder.forEach(bidLadder.count(), [&](const std::int64_t tick, const Slot &slot) { bidSlots.emplace_back(tick * factor, slot); });
+        askLadder.forEach(askLadder.count(), [&](const std::int64_t tick, const Slot &slot) { askSlots.emplace_back(tick * factor, slot); });
+        bidLadder.reset();
+        askLadder.reset();
+        priceScale = scale;
+
+        for (const auto &[tick, slot]: bidSlots) {
+            bidLadder.set(tick, slot);
+        }
+
+        for (const auto &[tick, slot]: askSlots) {
+            askLadder.set(tick, slot);
+        }
+    }
+
+    void applyLevels(Ladder &ladder, const std::vector<BookLevel> &levels) const {
+        for (const auto &level: levels) {
+            ladder.set(toTick(level.px), Slot{level.sz.mantissa(), level.numOrders, static_cast<std::int8_t>(level.sz.scale()),
+                                              static_cast<std::int8_t>(level.px.scale())});
+        }
+    }
+
+    void clear() {
+        bidLadder.clear();
+        askLadder.clear();
+        valid = false;
+        seqId = -1;
+    }
+
+    [[nodiscard]] std::int32_t checksum() const {
+        std::array<std::pair<std::int64_t, Slot>, CHECKSUM_DEPTH> bids{};
+        std::array<std::pair<std::int64_t, Slot>, CHECKSUM_DEPTH> asks{};
+        std::size_t numBids = 0;
+        std::size_t numAsks = 0;
+
+        bidLadder.forEach(CHECKSUM_DEPTH, [&](const std::int64_t tick, const Slot &slot) { bids[numBids++] = {tick, slot}; });
+        askLadder.forEach(CHECKSUM_DEPTH, [&](const std::int64_t tick, const Slot &slot) { asks[numAsks++] = {tick, slot}; });
+
+        /// At most 4 numbers of 21 characters and 4 separators per level
+        std::array<char, CHECKSUM_DEPTH * 4 * 22> buffer{};
+        auto *out = buffer.data();
+
+        auto appendLevel = [&](const std::pair<std::int64_t, Slot> &level) {
+            const auto &[tick, slot] = level;
+            out = appendDecimal(out, tick / POWERS_OF_TEN[priceScale - slot.pxScale], slot.pxScale);
+            *out++ = ':';
+            out = appendDecimal(out, slot.sz, slot.szScale);
+            *out++ = ':';
+        };
+
+        for (std::size_t i = 0; i < std::max(numBids, numAsks); ++i) {
+            if (i < numBids) {
+                appendLevel(bids[i]);
+            }
+
+            if (i < numAsks) {
+                appendLevel(asks[i]);
+            }
+        }
+
+        const auto length = out == buffer.data() ? 0 : out - buffer.data() - 1;
+        return static_cast<std::int32_t>(crc32(std::string_view(buffer.data(), length)));
+    }
+};
+
+OrderBook::OrderBook(const std::string_view channel) : m_p(std::make_unique<P>(channel)) {
+}
+
+OrderBook::OrderBook(OrderBook &&) noexcept = default;
+
+OrderBook &OrderBook::operator=(OrderBook &&) noexcept = default;
+
+OrderBook::~OrderBook() = default;
+
+OrderBookUpdate OrderBook::apply(const DataEventOrderBook &event) const {
+    if (event.snapshot) {
+        m_p->clear();
+    } else if (!m_p->valid) {
+        return OrderBookUpdate::noSnapshot;
+    } else if (m_p->sequenced && event.prevSeqId != m_p->seqId) {
+        m_p->clear();
+        return OrderBookUpdate::sequenceGap;
+    }
+
+    std::int32_t scale = m_p->priceScale;
+
+    for (const auto *levels: {&event.bids, &event.asks}) {
+        for (const auto &level: *levels) {
+            scale = std::max(scale, level.px.scale());
+        }
+    }
+
+    if (scale > m_p->priceScale) {
+        m_p->rescale(scale);
+    }
+
+    m_p->applyLevels(m_p->bidLadder, event.bids);
+    m_p->applyLevels(m_p->askLadder, event.asks);
+    m_p->valid = true;
+    m_p->seqId = event.seqId;
+    m_p->ts = event.ts;
+
+    if (m_p->sequenced && m_p->verifyChecksum && m_p->checksum() != event.checksum) {
+        m_p->clear();
+        return OrderBookUpdate::checksumMismatch;
+    }
+
+    return OrderBookUpdate::applied;
+}
+
+void OrderBook::setVerifyChecksum(const bool verify) const {
+    m_p->verifyChecksum = verify;
+}
+
+void OrderBook::clear() const {
+    m_p->clear();
+}
+
+bool OrderBook::isValid() const {
+    return m_p->valid;
+}
+
+std::optional<BookLevel> OrderBook::bestBid() const {
+    std::optional<BookLevel> retVal;
+    m_p->bidLadder.forEach(1, [&](const std::int64_t tick, const Slot &slot) { retVal = m_p->toLevel(tick, slot); });
+    return retVal;
+}
+
+std::optional<BookLevel> OrderBook::bestAsk() const {
+    std::optional<BookLevel> retVal;
+    m_p->askLadder.forEach(1, [&](const std::int64_t tick, const Slot &slot) { retVal = m_p->toLevel(tick, slot); });
+    return retVal;
+}
+
+std::vector<BookLevel> OrderBook::bids(const std::size_t depth) const {
+    std::vector<BookLevel> retVal;
+    retVal.reserve(std::min(depth, m_p->bidLadder.count()));
+    m_p->bidLadder.forEach(depth, [&](const std::int64_t tick, const Slot &slot) { retVal.push_back(m_p->toLevel(tick, slot)); });
+    return retVal;
+}
+
+std::vector<BookLevel> OrderBook::asks(const std::size_t depth) const {
+    std::vector<BookLevel> retVal;
+    retVal.reserve(std::min(depth, m_p->askLadder.count()));
+    m_p->askLadder.forEach(depth, [&](const std::int64_t tick, const Slot &slot) { retVal.push_back(m_p->toLevel(tick, slot)); });
+    return retVal;
+}
+
+std::size_t OrderBook::bidLevels() const {
+    return m_p->bidLadder.count();
+}
+
+std::size_t OrderBook::askLevels() const {
+    return m_p->askLadder.count();
+}
+
+std::int64_t OrderBook::seqId() const {
+    return m_p->seqId;
+}
+
+std::int64_t OrderBook::ts() const {
+    return m_p->ts;
+}
+
+std::int32_t OrderBook::checksum() const {
+    return m_p->checksum();
+}
+} // namespace stonky::okx
@@ -0,0 +1,197 @@
+/**
+OKX Rate Limiter
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
+*/
+
+#include "stonky/okx/okx_rate_limiter.h"
+#include <algorithm>
+
+namespace stonky::okx {
+namespace {
+/// Slowest rate the bucket can fall to after repeated throttling, as a multiple of the configured interval
+constexpr std::int64_t MAX_BACKOFF_FACTOR = 32;
+
+/// Interval is shortened by 1/n per successful response while recovering from throttling
+constexpr std::int64_t RECOVERY_DIVISOR = 16;
+
+std::int64_t steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string endpointKey(const std::string_view method, const std::string_view path) {
+    std::string key;
+    key.reserve(method.size() + path.size() + 1);
+    key.append(method);
+    key.append(" ");
+    key.append(path);
+    return key;
+}
+
+RateLimitRule makeRule(const std::size_t limit, const std::int64_t windowMs, const std::size_t burst, std::string keyParameter = {}) {
+    return {limit, std::chrono::milliseconds(windowMs), burst, std::move(keyParameter)};
+}
+}
+
+RateLimiter::RateLimiter(const RateLimitRule &rule) {
+    const auto limit = std::max<std::size_t>(rule.limit, 1);
+    const auto burst = std::clamp<std::size_t>(rule.burst, 1, limit);
+    const auto windowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(rule.window).count();
+
+    /// burst + window / interval <= limit, one token is added for the request which starts the window
+    const auto tokensPerWindow = static_cast<std::int64_t>(limit - burst + 1);
+    m_baseIntervalNs = (windowNs + tokensPerWindow - 1) / tokensPerWindow;
+    m_maxIntervalNs = m_baseIntervalNs * MAX_BACKOFF_FACTOR;
+    m_toleranceNs = m_baseIntervalNs * static_cast<std::int64_t>(burst - 1);
+    m_intervalNs = m_baseIntervalNs;
+}
+
+std::chrono::nanoseconds RateLimiter::reserve(const double headroom) {
+    const auto interval = m_intervalNs.load(std::memory_order_relaxed);
+
+    /// No burst until the bucket recovers from server throttling
+    const auto burstTolerance = interval > m_baseIntervalNs ? 0 : m_toleranceNs;
+    const auto tolerance = static_cast<std::int64_t>(static_cast<double>(burstTolerance) * (1.0 - std::clamp(headroom, 0.0, 1.0)));
+    const auto now = steadyNowNs();
+    auto tat = m_theoreticalArrivalNs.load(std::memory_order_relaxed);
+    std::int64_t start;
+
+    do {
+        start = std::max(tat, now);
+    } while (!m_theoreticalArrivalNs.compare_exchange_weak(tat, start + interval, std::memory_order_relaxed));
+
+    const auto waitNs = std::max<std::int64_t>(start - tolerance - now, 0);
+
+    m_requests.fetch_add(1, std::memory_order_relaxed);
+
+    if (waitNs > 0) {
+        m_delayedRequests.fetch_add(1, std::memory_order_relaxed);
+        m_totalWaitNs.fetch_add(waitNs, std::memory_order_relaxed);
+
+        auto maxWait = m_maxWaitNs.load(std::memory_order_relaxed);
+        while (waitNs > maxWait && !m_maxWaitNs.compare_exchange_weak(maxWait, waitNs, std::memory_order_relaxed)) {
+        }
+    }
+
+    return std::chrono::nanoseconds(waitNs);
+}
+
+void RateLimiter::onSuccess() {
+    auto interval = m_intervalNs.load(std::memory_order_relaxed);
+    std::int64_t newInterval;
+
+    do {
+        /// A shorter interval would exceed the limit together with the burst
+        if (interval <= m_baseIntervalNs) {
+            return;
+        }
+
+        const auto step = std::max<std::int64_t>(interval / RECOVERY_DIVISOR, 1);
+        newInterval = std::max(interval - step, m_baseIntervalNs);
+    } while (!m_intervalNs.compare_exchange_weak(interval, newInterval, std::memory_order_relaxed));
+}
+
+std::chrono::nanoseconds RateLimiter::onThrottled() {
+    m_throttledResponses.fetch_add(1, std::memory_order_relaxed);
+
+    auto interval = m_intervalNs.load(std::memory_order_relaxed);
+    std::int64_t newInterval;
+
+    do {
+        newInterval = std::min(std::max(interval, m_baseIntervalNs) * 2, m_maxIntervalNs);
+    } while (!m_intervalNs.compare_exchange_weak(interval, newInterval, std::memory_order_relaxed));
+
+    /// Everybody waits at least one new interval from now
+    const auto pushedBack = steadyNowNs() + newInterval;
+    auto tat = m_theoreticalArrivalNs.load(std::memory_order_relaxed);
+
+    while (tat < pushedBack && !m_theoreticalArrivalNs.compare_exchange_weak(tat, pushedBack, std::memory_order_relaxed)) {
+    }
+
+    return std::chrono::nanoseconds(newInterval);
+}
+
+RateLimiterStats RateLimiter::stats() const {
+    RateLimiterStats retVal;
+    retVal.requests = m_requests.load(std::memory_order_relaxed);
+    retVal.delayedRequests = m_delayedRequests.load(std::memory_order_relaxed);
+    retVal.totalWait = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::nanoseconds(m_totalWaitNs.load(std::memory_order_relaxed)));
+    retVal.maxWait = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::nanoseconds(m_maxWaitNs.load(std::memory_order_relaxed)));
+    retVal.throttledResponses = m_throttledResponses.load(std::memory_order_relaxed);
+    retVal.currentRate = 1e9 / static_cast<double>(m_intervalNs.load(std::memory_order_relaxed));
+    return retVal;
+}
+
+RateLimiterRegistry::RateLimiterRegistry() : m_defaultRule(makeRule(10, 2000, 2)) {
+    /// @see https://www.okx.com/docs-v5/en/#overview-rate-limits
+    setRule("GET", "/api/v5/market/tickers", makeRule(20, 2000, 5));
+    setRule("GET", "/api/v5/public/instruments", makeRule(20, 2000, 5, "instType"));
+    setRule("GET", "/api/v5/market/history-candles", makeRule(20, 2000, 5));
+    setRule("GET", "/api/v5/public/funding-rate", makeRule(20, 2000, 5, "instId"));
+    setRule("GET", "/api/v5/public/funding-rate-history", makeRule(10, 2000, 2, "instId"));
+    setRule("GET", "/api/v5/public/time", makeRule(10, 2000, 2));
+    setRule("GET", "/api/v5/account/balance", makeRule(10, 2000, 2));
+    setRule("GET", "/api/v5/account/positions", makeRule(10, 2000, 2));
+    setRule("GET", "/api/v5/trade/order", makeRule(60, 2000, 20, "instId"));
+    setRule("POST", "/api/v5/trade/order", makeRule(60, 2000, 20, "instId"));
+    setRule("POST", "/api/v5/trade/cancel-order", makeRule(60, 2000, 20, "instId"));
+
+    /// Not documented, 1 request per second is conservative
+    setRule("GET", "/api/v5/public/market-data-history", makeRule(1, 1000, 1));
+}
+
+void RateLimiterRegistry::setRule(const std::string_view method, const std::string_view path, const RateLimitRule &rule) {
+    std::lock_guard lk(m_locker);
+    m_rules.insert_or_assign(endpointKey(method, path), rule);
+}
+
+RateLimitRule RateLimiterRegistry::rule(const std::string_view method, const std::string_view path) const {
+    std::lock_guard lk(m_locker);
+
+    if (const auto it = m_rules.find(endpointKey(method, path)); it != m_rules.end()) {
+        return it->second;
+    }
+
+    return m_defaultRule;
+}
+
+RateLimiter &RateLimiterRegistry::limiter(const std::string_view method, const std::string_view path, const std::map<std::string, std::string> &parameters) {
+    auto key = endpointKey(method, path);
+
+    std::lock_guard lk(m_locker);
+
+    const auto itRule = m_rules.find(key);
+    const auto &rule = itRule != m_rules.end() ? itRule->second : m_defaultRule;
+
+    if (!rule.keyParameter.empty()) {
+        if (const auto itParam = parameters.find(rule.keyParameter); itParam != parameters.end()) {
+            key.append("|");
+            key.append(itParam->second);
+        }
+    }
+
+    auto it = m_limiters.find(key);
+
+    if (it == m_limiters.end()) {
+        it = m_limiters.emplace(std::move(key), std::make_unique<RateLimiter>(rule)).first;
+    }
+
+    return *it->second;
+}
+
+std::vector<RateLimiterStats> RateLimiterRegistry::stats() const {
+    std::lock_guard lk(m_locker);
+    std::vector<RateLimiterStats> retVal;
+    retVal.reserve(m_limiters.size());
+
+    for (const auto &[key, limiter]: m_limiters) {
+        auto stats = limiter->stats();
+        stats.key = key;
+        retVal.push_back(std::move(stats));
+    }
+
+    return retVal;
+}
+} // namespace stonky::okx
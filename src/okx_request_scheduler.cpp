@@ -0,0 +1,162 @@
+/**
+OKX Request Scheduler
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
+*/
+
+#include "stonky/okx/okx_request_scheduler.h"
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <memory>
+#include <vector>
+
+namespace stonky::okx {
+namespace {
+std::size_t laneIndex(const RequestLane lane) {
+    return static_cast<std::size_t>(lane);
+}
+
+std::chrono::microseconds toMicroseconds(const std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration);
+}
+}
+
+RequestScheduler::Permit::Permit(RequestScheduler *scheduler, const RequestLane lane) : m_scheduler(scheduler), m_lane(lane) {
+}
+
+RequestScheduler::Permit::Permit(Permit &&other) noexcept : m_scheduler(std::exchange(other.m_scheduler, nullptr)), m_lane(other.m_lane) {
+}
+
+RequestScheduler::Permit &RequestScheduler::Permit::operator=(Permit &&other) noexcept {
+    if (this != &other) {
+        if (m_scheduler) {
+            m_scheduler->release(m_lane);
+        }
+
+        m_scheduler = std::exchange(other.m_scheduler, nullptr);
+        m_lane = other.m_lane;
+    }
+
+    return *this;
+}
+
+RequestScheduler::Permit::~Permit() {
+    if (m_scheduler) {
+        m_scheduler->release(m_lane);
+    }
+}
+
+RequestScheduler::RequestScheduler(const RequestSchedulerOptions &options) : m_options(options) {
+}
+
+void RequestScheduler::setOptions(const RequestSchedulerOptions &options) {
+    std::lock_guard lk(m_locker);
+    m_options = options;
+}
+
+RequestSchedulerOptions RequestScheduler::options() const {
+    std::lock_guard lk(m_locker);
+    return m_options;
+}
+
+bool RequestScheduler::canAdmit(const RequestLane lane) const {
+    const auto maxConcurrent = std::max<std::size_t>(m_options.maxConcurrentRequests, 1);
+
+    if (lane == RequestLane::Trading) {
+        return m_inFlight < maxConcurrent;
+    }
+
+    /// History waits as long as any trading request is queued
+    if (!m_lanes[laneIndex(RequestLane::Trading)].waiters.empty()) {
+        return false;
+    }
+
+    const auto reserved = std::min(m_options.reservedTradingSlots, maxConcurrent - 1);
+    return m_inFlight < maxConcurrent - reserved;
+}
+
+void RequestScheduler::admit(const RequestLane lane, const std::chrono::steady_clock::duration wait) {
+    auto &stats = m_lanes[laneIndex(lane)].stats;
+    ++m_inFlight;
+    ++stats.inFlight;
+    ++stats.requests;
+
+    if (wait.count() > 0) {
+        const auto waitUs = toMicroseconds(wait);
+        ++stats.queuedRequests;
+        stats.totalWait += waitUs;
+        stats.maxWait = std::max(stats.maxWait, waitUs);
+    }
+}
+
+void RequestScheduler::release(const RequestLane lane) {
+    std::vector<std::function<void()> > resumed;
+
+    {
+        std::lock_guard lk(m_locker);
+        --m_inFlight;
+        --m_lanes[laneIndex(lane)].stats.inFlight;
+
+        for (const auto candidate: {RequestLane::Trading, RequestLane::History}) {
+            auto &waiters = m_lanes[laneIndex(candidate)].waiters;
+
+            while (!waiters.empty() && canAdmit(candidate)) {
+                auto waiter = std::move(waiters.front());
+                waiters.pop_front();
+                m_lanes[laneIndex(candidate)].stats.queueDepth = waiters.size();
+                admit(candidate, std::chrono::steady_clock::now() - waiter.enqueued);
+                resumed.push_back(std::move(waiter.resume));
+            }
+        }
+    }
+
+    for (const auto &resume: resumed) {
+        resume();
+    }
+}
+
+boost::asio::awaitable<RequestScheduler::Permit> RequestScheduler::acquire(const RequestLane lane) {
+    {
+        std::lock_guard lk(m_locker);
+
+        if (m_lanes[laneIndex(lane)].waiters.empty() && canAdmit(lane)) {
+            admit(lane, {});
+            co_return Permit(this, lane);
+        }
+    }
+
+    co_await boost::asio::async_initiate<decltype(boost::asio::use_awaitable), void()>([this, lane](auto handler) {
+        auto sharedHandler = std::make_shared<decltype(handler)>(std::move(handler));
+        auto resume = [sharedHandler] {
+            const auto executor = boost::asio::get_associated_executor(*sharedHandler);
+            boost::asio::post(executor, std::move(*sharedHandler));
+        };
+
+        std::unique_lock lk(m_locker);
+
+        /// A slot could have been released between the fast path and here
+        if (m_lanes[laneIndex(lane)].waiters.empty() && canAdmit(lane)) {
+            admit(lane, {});
+            lk.unlock();
+            resume();
+            return;
+        }
+
+        auto &queue = m_lanes[laneIndex(lane)];
+        queue.waiters.push_back({std::move(resume), std::chrono::steady_clock::now()});
+        queue.stats.queueDepth = queue.waiters.size();
+        queue.stats.maxQueueDepth = std::max(queue.stats.maxQueueDepth, queue.stats.queueDepth);
+    }, boost::asio::use_awaitable);
+
+    co_return Permit(this, lane);
+}
+
+RequestLaneStats RequestScheduler::stats(const RequestLane lane) const {
+    std::lock_guard lk(m_locker);
+    return m_lanes[laneIndex(lane)].stats;
+}
+} // namespace stonky::okx
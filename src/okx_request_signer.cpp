@@ -0,0 +1,132 @@
+/**
+OKX Request Signer
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
+*/
+
+#include "stonky/okx/okx_request_signer.h"
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#include <mutex>
+#include <stdexcept>
+
+namespace stonky::okx {
+namespace {
+void writeDigits(char *out, unsigned value, const int width) {
+    for (int i = width - 1; i >= 0; i--) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+}
+
+/// Howard Hinnant's days_from_civil inverse, see http://howardhinnant.github.io/date_algorithms.html
+void civilFromDays(std::int64_t days, std::int64_t &year, unsigned &month, unsigned &day) {
+    days += 719468;
+    const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const auto doe = static_cast<unsigned>(days - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    day = doy - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = static_cast<std::int64_t>(yoe) + era * 400 + (month <= 2);
+}
+}
+
+struct RequestSigner::P {
+    EVP_MAC *mac = nullptr;
+    EVP_MAC_CTX *ctx = nullptr;
+
+    /// The MAC context holds the state of a single computation
+    mutable std::mutex locker;
+
+    ~P() {
+        EVP_MAC_CTX_free(ctx);
+        EVP_MAC_free(mac);
+    }
+};
+
+RequestSigner::RequestSigner(const std::string &apiSecret) : m_p(std::make_unique<P>()) {
+    m_p->mac = EVP_MAC_fetch(nullptr, "HMAC", nullptr);
+
+    if (!m_p->mac) {
+        throw std::runtime_error("Failed to fetch HMAC implementation");
+    }
+
+    m_p->ctx = EVP_MAC_CTX_new(m_p->mac);
+
+    if (!m_p->ctx) {
+        throw std::runtime_error("Failed to create HMAC context");
+    }
+
+    char digest[] = "SHA256";
+    const OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0),
+        OSSL_PARAM_construct_end()
+    };
+
+    /// The key is hashed into the inner/outer pads here, later re-initializations without key only restore them
+    if (!EVP_MAC_init(m_p->ctx, reinterpret_cast<const unsigned char *>(apiSecret.data()), apiSecret.size(), params)) {
+        throw std::runtime_error("Failed to initialize HMAC key");
+    }
+}
+
+RequestSigner::~RequestSigner() = default;
+
+void RequestSigner::sign(const std::string_view method, const std::string_view requestPath, const std::string_view body,
+                         const std::chrono::system_clock::time_point now, Signature &signature) const {
+    formatTimestamp(now, signature.timestampBuffer);
+
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    std::size_t digestLength = 0;
+
+    {
+        std::lock_guard lk(m_p->locker);
+
+        const auto update = [this](const std::string_view data) {
+            return EVP_MAC_update(m_p->ctx, reinterpret_cast<const unsigned char *>(data.data()), data.size());
+        };
+
+        if (!EVP_MAC_init(m_p->ctx, nullptr, 0, nullptr) ||
+            !update(signature.timestamp()) ||
+            !update(method) ||
+            !update(requestPath) ||
+            !update(body) ||
+            !EVP_MAC_final(m_p->ctx, digest, &digestLength, sizeof(digest))) {
+            throw std::runtime_error("Failed to compute request signature");
+        }
+    }
+
+    /// 32 bytes of SHA256 digest always encode into 44 characters plus terminating zero
+    EVP_EncodeBlock(reinterpret_cast<unsigned char *>(signature.signBuffer.data()), digest, static_cast<int>(digestLength));
+}
+
+void RequestSigner::formatTimestamp(const std::chrono::system_clock::time_point time, std::array<char, TIMESTAMP_LENGTH> &buffer) {
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+    const auto days = ms / 86400000;
+    const auto msOfDay = static_cast<unsigned>(ms % 86400000);
+
+    std::int64_t year;
+    unsigned month;
+    unsigned day;
+    civilFromDays(days, year, month, day);
+
+    char *out = buffer.data();
+    writeDigits(out, static_cast<unsigned>(year), 4);
+    out[4] = '-';
+    writeDigits(out + 5, month, 2);
+    out[7] = '-';
+    writeDigits(out + 8, day, 2);
+    out[10] = 'T';
+    writeDigits(out + 11, msOfDay / 3600000, 2);
+    out[13] = ':';
+    writeDigits(out + 14, msOfDay / 60000 % 60, 2);
+    out[16] = ':';
+    writeDigits(out + 17, msOfDay / 1000 % 60, 2);
+    out[19] = '.';
+    writeDigits(out + 20, msOfDay % 1000, 3);
+    out[23] = 'Z';
+}
+} // namespace stonky::okx
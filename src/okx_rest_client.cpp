@@ -8,64 +8,291 @@ Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
 
 #include "stonky/okx/okx_rest_client.h"
 #include "stonky/okx/okx_http_session.h"
+#include "stonky/okx/okx_json_reader.h"
 #include "stonky/okx/okx.h"
 #include "stonky/okx/okx_market_data_utils.h"
+#include "stonky/okx/okx_rate_limiter.h"
+#include "stonky/okx/okx_request_scheduler.h"
 #include "stonky/utils/utils.h"
 #include "stonky/utils/magic_enum_wrapper.hpp"
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/use_future.hpp>
+#include <boost/asio/io_context.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
 #include <mutex>
+#include <optional>
+#include <random>
+#include <ranges>
 #include <thread>
-#include <deque>
 #include <spdlog/spdlog.h>
 
 namespace stonky::okx {
-template<typename ValueType>
-ValueType handleOKXResponse(const http::response<http::string_body> &response) {
-    ValueType retVal;
-    retVal.fromJson(nlohmann::json::parse(response.body()));
+constexpr int MAX_RATE_LIMIT_RETRIES = 5;
+constexpr std::size_t RATE_LIMITED_BODY_MAX_SIZE = 256;
+constexpr std::chrono::milliseconds RETRY_BASE_DELAY{200};
+constexpr std::chrono::milliseconds RETRY_MAX_DELAY{10000};
 
-    if (std::stoi(retVal.code) != 0) {
-        throw std::runtime_error(fmt::format("OKX API error, code: {}, msg: {}", retVal.code, retVal.msg).c_str());
+/// Maximum (and default) page size of history-candles
+constexpr std::int64_t MAX_CANDLES_PER_PAGE = 100;
+
+constexpr std::int64_t DAY_MS = 24 * 60 * 60 * 1000;
+
+/// Maximum range of one market data history listing of daily files
+constexpr std::int64_t MAX_DAILY_LISTING_DAYS = 20;
+
+namespace {
+/**
+ * Completion of a group of coroutines spawned on the client's executor, the first error is kept and rethrown
+ * by wait()
+ */
+class CompletionLatch {
+    mutable std::mutex m_locker;
+    std::size_t m_remaining;
+    std::exception_ptr m_error;
+    std::function<void()> m_waiter;
+
+public:
+    explicit CompletionLatch(const std::size_t count) : m_remaining(count) {
     }
 
-    return retVal;
+    [[nodiscard]] bool failed() const {
+        std::lock_guard lk(m_locker);
+        return m_error != nullptr;
+    }
+
+    void done(const std::exception_ptr &error) {
+        std::function<void()> waiter;
+
+        {
+            std::lock_guard lk(m_locker);
+
+            if (error && !m_error) {
+                m_error = error;
+            }
+
+            if (--m_remaining == 0) {
+                waiter = std::move(m_waiter);
+            }
+        }
+
+        if (waiter) {
+            waiter();
+        }
+    }
+
+    boost::asio::awaitable<void> wait() {
+        co_await boost::asio::async_initiate<decltype(boost::asio::use_awaitable), void()>([this](auto handler) {
+            auto sharedHandler = std::make_shared<decltype(handler)>(std::move(handler));
+            auto resume = [sharedHandler] {
+                const auto executor = boost::asio::get_associated_executor(*sharedHandler);
+                boost::asio::post(executor, std::move(*sharedHandler));
+            };
+
+            std::unique_lock lk(m_locker);
+
+            if (m_remaining == 0) {
+                lk.unlock();
+                resume();
+                return;
+            }
+
+            m_waiter = std::move(resume);
+        }, boost::asio::use_awaitable);
+
+        std::lock_guard lk(m_locker);
+
+        if (m_error) {
+            std::rethrow_exception(m_error);
+        }
+    }
+};
+
+/**
+ * Instrument type and family (instId for SPOT) of the market data history files of an instrument
+ */
+std::pair<InstrumentType, std::string> marketDataInstrument(const std::string &instId) {
+    std::vector<std::string_view> parts;
+
+    for (const auto part: std::views::split(std::string_view(instId), '-')) {
+        parts.emplace_back(part.begin(), part.end());
+    }
+
+    if (parts.size() < 3) {
+        return {InstrumentType::SPOT, instId};
+    }
+
+    const auto family = fmt::format("{}-{}", parts[0], parts[1]);
+
+    if (parts.size() == 3 && parts[2] == "SWAP") {
+        return {InstrumentType::SWAP, family};
+    }
+
+    if (parts.size() == 5 && (parts[4] == "C" || parts[4] == "P")) {
+        return {InstrumentType::OPTION, family};
+    }
+
+    return {InstrumentType::FUTURES, family};
+}
+
+/// Number of history-candles pages of the range
+double restPages(const std::int64_t from, const std::int64_t to, const std::int64_t barMs) {
+    const auto candles = (to - from) / barMs + 1;
+    return static_cast<double>((candles + MAX_CANDLES_PER_PAGE - 1) / MAX_CANDLES_PER_PAGE);
 }
 
-struct RateLimiter {
-    std::mutex m_mutex;
-    std::deque<std::int64_t> m_requestTimes;
-    const size_t m_limit;
-    const std::int64_t m_windowSizeMs;
+/**
+ * Chronological sink of a backfill. Candles are taken in order of the steps, everything not newer than the last one
+ * is a seam duplicate, a jump of more than one bar is a gap which is downloaded from REST once more before going on.
+ */
+class BackfillSink {
+    const RESTClient &m_client;
+    const std::string &m_instId;
+    const BarSize m_barSize;
+    const std::int64_t m_barMs;
+    const std::int64_t m_from;
+    const std::int64_t m_to;
+    const BackfillOptions &m_options;
+    const onCandlesDownloaded &m_writer;
+    BackfillResult &m_result;
+
+    /// Months have no fixed length
+    const bool m_checkContinuity;
+    std::optional<std::int64_t> m_last;
+    std::vector<Candle> m_page;
+
+    void push(const Candle &candle, const BackfillSource source) {
+        m_page.push_back(candle);
+        m_last = candle.ts;
+        ++(source == BackfillSource::zip ? m_result.zipCandles : m_result.restCandles);
+    }
+
+    void addGap(const std::int64_t gapFrom, const std::int64_t gapTo) {
+        if (!m_result.gaps.empty() && m_result.gaps.back().to + m_barMs == gapFrom) {
+            m_result.gaps.back().to = gapTo;
+        } else {
+            m_result.gaps.push_back({gapFrom, gapTo});
+        }
+    }
 
-    RateLimiter(const size_t limit, const std::int64_t windowMs) : m_limit(limit), m_windowSizeMs(windowMs) {}
+    /**
+     * Candles missing between the last one (or the start of the range) and next, exclusive
+     * @param next end of the checked interval
+     * @param anchor an expected open time, used before the first candle
+     */
+    void fill(const std::int64_t next, const std::int64_t anchor) {
+        if (!m_checkContinuity) {
+            return;
+        }
 
-    void wait() {
-        std::unique_lock lock(m_mutex);
-        auto now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        /// Expected open times are aligned to the last candle, before the first candle to the anchor
+        const auto first = m_last ? *m_last + m_barMs : anchor - (anchor - m_from) / m_barMs * m_barMs;
 
-        // Remove old requests
-        while (!m_requestTimes.empty() && (now - m_requestTimes.front() > m_windowSizeMs)) {
-            m_requestTimes.pop_front();
+        if (next <= first) {
+            return;
         }
 
-        if (m_requestTimes.size() >= m_limit) {
-            const auto oldest = m_requestTimes.front();
+        const auto last = first + (next - 1 - first) / m_barMs * m_barMs;
 
-            if (auto waitTime = (oldest + m_windowSizeMs) - now + 10; waitTime > 0) {
-#ifdef VERBOSE_LOG
-                spdlog::info("Rate limit reached (Local). Waiting for {} ms", waitTime);
-#endif
-                std::this_thread::sleep_for(std::chrono::milliseconds(waitTime));
+        auto expected = first;
+
+        if (m_options.repairGaps) {
+            for (const auto &candle: m_client.getHistoricalPricesParallel(m_instId, m_barSize, first - 1, last + 1, m_options.maxRestConcurrency)) {
+                if (candle.ts < expected || candle.ts > last) {
+                    continue;
+                }
 
-                // Update now after sleep
-                now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
-                while (!m_requestTimes.empty() && (now - m_requestTimes.front() > m_windowSizeMs)) {
-                    m_requestTimes.pop_front();
+                if (candle.ts > expected) {
+                    addGap(expected, candle.ts - m_barMs);
                 }
+
+                push(candle, BackfillSource::rest);
+                expected = candle.ts + m_barMs;
+            }
+        }
+
+        if (expected <= last) {
+            addGap(expected, last);
+        }
+    }
+
+public:
+    BackfillSink(const RESTClient &client, const std::string &instId, const BarSize barSize, const std::int64_t from, const std::int64_t to,
+                 const BackfillOptions &options, const onCandlesDownloaded &writer, BackfillResult &result) : m_client(client), m_instId(instId),
+        m_barSize(barSize), m_barMs(OKX::numberOfMsForBarSize(barSize)), m_from(from), m_to(to), m_options(options), m_writer(writer),
+        m_result(result), m_checkContinuity(barSize < BarSize::_1M) {
+    }
+
+    /**
+     * @param candles sorted candles of one step or one file of a step
+     * @param source
+     */
+    void write(const std::vector<Candle> &candles, const BackfillSource source) {
+        for (const auto &candle: candles) {
+            if (candle.ts < m_from || candle.ts > m_to) {
+                continue;
+            }
+
+            if (m_last && candle.ts <= *m_last) {
+                ++m_result.duplicates;
+                continue;
             }
+
+            fill(candle.ts, candle.ts);
+            push(candle, source);
+        }
+
+        flush();
+    }
+
+    /// Only bars closed by the end of the range are expected, the last one can still be open. Without any candle the
+    /// bars are aligned to the bar size, the first one opens at or after the start of the range.
+    void finish() {
+        fill(m_to - m_barMs + 1, m_from + (m_barMs - m_from % m_barMs) % m_barMs);
+        flush();
+    }
+
+    void flush() {
+        if (m_page.empty()) {
+            return;
+        }
+
+        if (m_writer) {
+            m_writer(m_page);
+        } else {
+            m_result.candles.insert(m_result.candles.end(), m_page.begin(), m_page.end());
         }
-        m_requestTimes.push_back(now);
+
+        m_page.clear();
     }
 };
+}
+
+template<typename ValueType>
+ValueType handleOKXResponse(const http::response<http::string_body> &response) {
+    ValueType retVal;
+
+    /// Models with a single-pass reader are filled straight from the body, the others go through the DOM
+    if constexpr (requires { readResponse(std::string_view{}, retVal); }) {
+        readResponse(response.body(), retVal);
+    } else {
+        retVal.fromJson(nlohmann::json::parse(response.body()));
+    }
+
+    if (std::stoi(retVal.code) != 0) {
+        throw std::runtime_error(fmt::format("OKX API error, code: {}, msg: {}", retVal.code, retVal.msg).c_str());
+    }
+
+    return retVal;
+}
 
 struct RESTClient::P {
 private:
@@ -73,12 +300,43 @@ private:
     mutable std::recursive_mutex m_locker;
 
 public:
-    mutable RateLimiter klineLimiter{20, 2000};
-    mutable RateLimiter marketDataHistoryLimiter{1, 1000}; // 1 request per second for market-data-history (conservative)
+    mutable RateLimiterRegistry limiters;
+    mutable RequestScheduler scheduler;
     RESTClient *parent = nullptr;
+
+    /// Used only when no executor is supplied by the caller, it must survive credentials change
+    std::unique_ptr<boost::asio::io_context> ioc;
+    std::optional<boost::asio::executor_work_guard<boost::asio::io_context::executor_type> > workGuard;
+    std::thread ioThread;
+    boost::asio::any_io_executor executor;
     std::shared_ptr<HTTPSession> httpSession;
+    std::shared_ptr<MarketDataCache> marketDataCache;
+
+    P(RESTClient *parent, const boost::asio::any_io_executor &ex) {
+        this->parent = parent;
+
+        if (ex) {
+            executor = ex;
+        } else {
+            ioc = std::make_unique<boost::asio::io_context>(1);
+            workGuard.emplace(boost::asio::make_work_guard(*ioc));
+            executor = ioc->get_executor();
+            ioThread = std::thread([this] { ioc->run(); });
+        }
+    }
+
+    ~P() {
+        setHTTPSession(nullptr);
 
-    explicit P(RESTClient *parent) { this->parent = parent; }
+        if (ioc) {
+            workGuard.reset();
+            ioc->stop();
+
+            if (ioThread.joinable()) {
+                ioThread.join();
+            }
+        }
+    }
 
     [[nodiscard]] Instruments getInstruments() const {
         std::lock_guard lk(m_locker);
@@ -95,6 +353,17 @@ public:
         m_instruments.instruments = instruments;
     }
 
+    /// Session is copied so that it stays alive for the whole coroutine even if credentials are changed meanwhile
+    [[nodiscard]] std::shared_ptr<HTTPSession> session() const {
+        std::lock_guard lk(m_locker);
+        return httpSession;
+    }
+
+    void setHTTPSession(std::shared_ptr<HTTPSession> session) {
+        std::lock_guard lk(m_locker);
+        httpSession = std::move(session);
+    }
+
     static http::response<http::string_body> checkResponse(const http::response<http::string_body> &response) {
         if (response.result() != http::status::ok) {
             throw std::runtime_error(fmt::format("Bad response, code {}, msg: {}", response.result_int(), response.body()).c_str());
@@ -102,50 +371,288 @@ public:
         return response;
     }
 
-    std::vector<Candle> getHistoricalPrices(const std::string &instId, BarSize barSize, std::int64_t from, std::int64_t to, std::int32_t limit) const;
+    static boost::asio::awaitable<void> asyncSleep(const std::chrono::nanoseconds delay) {
+        boost::asio::steady_timer timer(co_await boost::asio::this_coro::executor, delay);
+        co_await timer.async_wait(boost::asio::use_awaitable);
+    }
+
+    static boost::asio::awaitable<void> asyncWait(RateLimiter &limiter, const double headroom) {
+        if (const auto delay = limiter.reserve(headroom); delay.count() > 0) {
+#ifdef VERBOSE_LOG
+            spdlog::info("Rate limit reached (Local). Waiting for {} ms", std::chrono::duration_cast<std::chrono::milliseconds>(delay).count());
+#endif
+            co_await asyncSleep(delay);
+        }
+    }
+
+    /// HTTP 429 or OKX code 50011 (Too Many Requests), the error body is short so data responses are not searched
+    static bool isRateLimited(const http::response<http::string_body> &response) {
+        if (response.result() == http::status::too_many_requests) {
+            return true;
+        }
+
+        return response.body().size() < RATE_LIMITED_BODY_MAX_SIZE && response.body().find(R"("code":"50011")") != std::string::npos;
+    }
+
+    /// Exponential backoff with equal jitter, Retry-After is honored when the server sends it
+    static std::chrono::nanoseconds retryDelay(const int attempt, const http::response<http::string_body> &response,
+                                               const std::chrono::nanoseconds pushedBack) {
+        thread_local std::mt19937 generator(std::random_device{}());
+
+        const auto ceiling = std::min(RETRY_BASE_DELAY * (1 << std::min(attempt, 10)), RETRY_MAX_DELAY);
+        std::uniform_int_distribution<std::int64_t> distribution(ceiling.count() / 2, ceiling.count());
+        std::chrono::nanoseconds retVal = std::max<std::chrono::nanoseconds>(std::chrono::milliseconds(distribution(generator)), pushedBack);
+
+        if (const auto it = response.find(http::field::retry_after); it != response.end()) {
+            try {
+                retVal = std::max<std::chrono::nanoseconds>(retVal, std::chrono::seconds(std::stoi(std::string(it->value()))));
+            } catch (const std::exception &) {
+                /// HTTP-date form is not used by OKX
+            }
+        }
+
+        return retVal;
+    }
+
+    /// History requests leave part of every bucket's burst to trading requests
+    [[nodiscard]] double headroom(const RequestLane lane) const {
+        return lane == RequestLane::History ? scheduler.options().historyRateHeadroom : 0.0;
+    }
+
+    /**
+     * Every GET request goes through here so that it is paced by the endpoint's limiter and admitted by its lane.
+     * GET requests are idempotent so rate limit rejections are retried after a backoff.
+     */
+    boost::asio::awaitable<http::response<http::string_body> > get(const RequestLane lane, const std::string &path,
+                                                                   const std::map<std::string, std::string> &parameters, const bool isPublic = true) const {
+        auto &limiter = limiters.limiter("GET", path, parameters);
+
+        for (int attempt = 0;; ++attempt) {
+            co_await asyncWait(limiter, headroom(lane));
+            http::response<http::string_body> response;
+
+            {
+                const auto permit = co_await scheduler.acquire(lane);
+                const auto httpSession = session();
+                response = co_await httpSession->asyncGet(path, parameters, isPublic);
+            }
+
+            if (!isRateLimited(response)) {
+                if (response.result() == http::status::ok) {
+                    limiter.onSuccess();
+                }
+
+                co_return checkResponse(response);
+            }
+
+            const auto pushedBack = limiter.onThrottled();
+
+            if (attempt >= MAX_RATE_LIMIT_RETRIES) {
+                throw std::runtime_error(fmt::format("Rate limit reached, {} retries exhausted, path: {}", MAX_RATE_LIMIT_RETRIES, path).c_str());
+            }
+
+            const auto delay = retryDelay(attempt, response, pushedBack);
+            spdlog::warn("Rate limit reached (Server), path: {}, retrying in {} ms", path, std::chrono::duration_cast<std::chrono::milliseconds>(delay).count());
+            co_await asyncSleep(delay);
+        }
+    }
+
+    /**
+     * Every POST request goes through here so that it is paced by the endpoint's limiter and admitted by its lane.
+     * POST requests are not retried, rate limit rejections only slow the limiter down.
+     */
+    boost::asio::awaitable<http::response<http::string_body> > post(const RequestLane lane, const std::string &path, const nlohmann::json &json,
+                                                                    const bool isPublic = true) const {
+        std::map<std::string, std::string> keyParameters;
 
-    std::vector<FundingRate> getFundingRates(const std::string &instId, int64_t from, int64_t to, int limit) const;
+        if (const auto it = json.find("instId"); it != json.end() && it->is_string()) {
+            keyParameters.insert_or_assign("instId", it->get<std::string>());
+        }
+
+        auto &limiter = limiters.limiter("POST", path, keyParameters);
+        co_await asyncWait(limiter, headroom(lane));
+        http::response<http::string_body> response;
+
+        {
+            const auto permit = co_await scheduler.acquire(lane);
+            const auto httpSession = session();
+            response = co_await httpSession->asyncPost(path, json, isPublic);
+        }
+
+        if (isRateLimited(response)) {
+            static_cast<void>(limiter.onThrottled());
+        } else if (response.result() == http::status::ok) {
+            limiter.onSuccess();
+        }
+
+        co_return checkResponse(response);
+    }
+
+    template<typename ValueType>
+    ValueType runSync(boost::asio::awaitable<ValueType> awaitable) const {
+        return boost::asio::co_spawn(executor, std::move(awaitable), boost::asio::use_future).get();
+    }
+
+    /**
+     * runSync() for the downloads with a writer. The pages are queued on the executor and the writer is called on the
+     * calling thread, so a slow writer does not stall other requests and it may call the synchronous methods of the
+     * client. If the writer throws, the download is stopped at its next page.
+     * @param start creates the download with the given writer
+     */
+    std::vector<Candle> runSyncWithWriter(const onCandlesDownloaded &writer,
+                                          const std::function<boost::asio::awaitable<std::vector<Candle> >(onCandlesDownloaded)> &start) const {
+        if (!writer) {
+            return runSync(start({}));
+        }
+
+        struct Pages {
+            std::mutex locker;
+            std::condition_variable cv;
+            std::deque<std::vector<Candle> > queue;
+            bool finished = false;
+            bool cancelled = false;
+            std::exception_ptr error;
+            std::vector<Candle> result;
+        };
+
+        const auto pages = std::make_shared<Pages>();
+
+        auto queueWriter = [pages](const std::vector<Candle> &page) {
+            {
+                std::lock_guard lk(pages->locker);
+
+                if (pages->cancelled) {
+                    throw std::runtime_error("Download cancelled, the writer failed");
+                }
+
+                pages->queue.push_back(page);
+            }
+
+            pages->cv.notify_one();
+        };
+
+        boost::asio::co_spawn(executor, start(std::move(queueWriter)), [pages](const std::exception_ptr &e, std::vector<Candle> result) {
+            {
+                std::lock_guard lk(pages->locker);
+                pages->finished = true;
+                pages->error = e;
+                pages->result = std::move(result);
+            }
+
+            pages->cv.notify_one();
+        });
+
+        for (;;) {
+            std::unique_lock lk(pages->locker);
+            pages->cv.wait(lk, [&pages] { return pages->finished || !pages->queue.empty(); });
+
+            if (pages->queue.empty()) {
+                break;
+            }
+
+            auto page = std::move(pages->queue.front());
+            pages->queue.pop_front();
+            lk.unlock();
+
+            try {
+                writer(page);
+            } catch (...) {
+                lk.lock();
+                pages->cancelled = true;
+                throw;
+            }
+        }
+
+        if (pages->error) {
+            std::rethrow_exception(pages->error);
+        }
+
+        return std::move(pages->result);
+    }
+
+    boost::asio::awaitable<std::vector<Candle> > asyncGetHistoricalPrices(const std::string &instId, BarSize barSize, std::int64_t from, std::int64_t to,
+                                                                           std::int32_t limit) const;
+
+    /**
+     * Download all candles with timestamp in [from, to) in chronological order, unconfirmed candle excluded
+     */
+    boost::asio::awaitable<std::vector<Candle> > asyncGetHistoricalShard(const std::string &instId, BarSize barSize, std::int64_t from,
+                                                                          std::int64_t to) const;
+
+    boost::asio::awaitable<std::vector<FundingRate> > asyncGetFundingRates(const std::string &instId, int64_t from, int64_t to, int limit) const;
 };
 
-RESTClient::RESTClient(const std::string &apiKey, const std::string &apiSecret, const std::string &passphrase) : m_p(std::make_unique<P>(this)) {
-    m_p->httpSession = std::make_shared<HTTPSession>(apiKey, apiSecret, passphrase);
+RESTClient::RESTClient(const std::string &apiKey, const std::string &apiSecret, const std::string &passphrase) :
+    RESTClient(boost::asio::any_io_executor{}, apiKey, apiSecret, passphrase) {
+}
+
+RESTClient::RESTClient(const boost::asio::any_io_executor &executor, const std::string &apiKey, const std::string &apiSecret,
+                       const std::string &passphrase) : m_p(std::make_unique<P>(this, executor)) {
+    m_p->httpSession = std::make_shared<HTTPSession>(m_p->executor, apiKey, apiSecret, passphrase);
 }
 
 RESTClient::~RESTClient() = default;
 
+boost::asio::any_io_executor RESTClient::executor() const {
+    return m_p->executor;
+}
+
+std::vector<RateLimiterStats> RESTClient::rateLimiterStats() const {
+    return m_p->limiters.stats();
+}
+
+void RESTClient::setRateLimitRule(const std::string &method, const std::string &path, const RateLimitRule &rule) const {
+    m_p->limiters.setRule(method, path, rule);
+}
+
+void RESTClient::setRequestSchedulerOptions(const RequestSchedulerOptions &options) const {
+    m_p->scheduler.setOptions(options);
+}
+
+RequestLaneStats RESTClient::requestLaneStats(const RequestLane lane) const {
+    return m_p->scheduler.stats(lane);
+}
+
 void RESTClient::setCredentials(const std::string &apiKey, const std::string &apiSecret, const std::string &passphrase) const {
-    m_p->httpSession.reset();
-    m_p->httpSession = std::make_shared<HTTPSession>(apiKey, apiSecret, passphrase);
+    m_p->setHTTPSession(std::make_shared<HTTPSession>(m_p->executor, apiKey, apiSecret, passphrase));
 }
 
 std::vector<Ticker> RESTClient::getTickers(const InstrumentType instrumentType) const {
+    return m_p->runSync(asyncGetTickers(instrumentType));
+}
+
+boost::asio::awaitable<std::vector<Ticker> > RESTClient::asyncGetTickers(const InstrumentType instrumentType) const {
     const std::string path = "/api/v5/market/tickers";
     std::map<std::string, std::string> parameters;
 
     parameters.insert_or_assign("instType", magic_enum::enum_name(instrumentType));
 
-    const auto response = P::checkResponse(m_p->httpSession->get(path, parameters));
-    return handleOKXResponse<Tickers>(response).tickers;
+    const auto response = co_await m_p->get(RequestLane::History, path, parameters);
+    co_return handleOKXResponse<Tickers>(response).tickers;
 }
 
 std::vector<Instrument> RESTClient::getInstruments(const InstrumentType instrumentType, const bool force) const {
+    return m_p->runSync(asyncGetInstruments(instrumentType, force));
+}
+
+boost::asio::awaitable<std::vector<Instrument> > RESTClient::asyncGetInstruments(const InstrumentType instrumentType, const bool force) const {
     if (m_p->getInstruments().instruments.empty() || force) {
         const std::string path = "/api/v5/public/instruments";
         std::map<std::string, std::string> parameters;
 
         parameters.insert_or_assign("instType", magic_enum::enum_name(instrumentType));
 
-        const auto response = P::checkResponse(m_p->httpSession->get(path, parameters));
+        const auto response = co_await m_p->get(RequestLane::History, path, parameters);
         m_p->setInstruments(handleOKXResponse<Instruments>(response));
     }
 
-    return m_p->getInstruments().instruments;
+    co_return m_p->getInstruments().instruments;
 }
 
 void RESTClient::setInstruments(const std::vector<Instrument> &instruments) const { m_p->setInstruments(instruments); }
 
-std::vector<Candle> RESTClient::P::getHistoricalPrices(const std::string &instId, const BarSize barSize, const std::int64_t from, const std::int64_t to,
-                                                       const std::int32_t limit) const {
+boost::asio::awaitable<std::vector<Candle> > RESTClient::P::asyncGetHistoricalPrices(const std::string &instId, const BarSize barSize, const std::int64_t from,
+                                                                                      const std::int64_t to, const std::int32_t limit) const {
     const std::string path = "/api/v5/market/history-candles";
     std::map<std::string, std::string> parameters;
 
@@ -164,36 +671,44 @@ std::vector<Candle> RESTClient::P::getHistoricalPrices(const std::string &instId
         parameters.insert_or_assign("limit", std::to_string(limit));
     }
 
-    klineLimiter.wait();
-    const auto response = checkResponse(httpSession->get(path, parameters));
-    return handleOKXResponse<Candles>(response).candles;
+    const auto response = co_await get(RequestLane::History, path, parameters);
+    co_return handleOKXResponse<Candles>(response).candles;
 }
 
 std::vector<Candle> RESTClient::getHistoricalPrices(const std::string &instId, const BarSize barSize, const std::int64_t from, const std::int64_t to, const std::int32_t limit,
                                                     const onCandlesDownloaded &writer) const {
+    return m_p->runSyncWithWriter(writer, [&](onCandlesDownloaded queueWriter) {
+        return asyncGetHistoricalPrices(instId, barSize, from, to, limit, std::move(queueWriter));
+    });
+}
+
+boost::asio::awaitable<std::vector<Candle> > RESTClient::asyncGetHistoricalPrices(const std::string instId, const BarSize barSize, const std::int64_t from,
+                                                                                   const std::int64_t to, const std::int32_t limit, const onCandlesDownloaded writer) const {
     std::vector<Candle> retVal;
     std::vector<Candle> candles;
 
     if (from < to) {
-        candles = m_p->getHistoricalPrices(instId, barSize, from, to, limit);
+        candles = co_await m_p->asyncGetHistoricalPrices(instId, barSize, from, to, limit);
     }
 
     while (!candles.empty()) {
-        retVal.insert(retVal.end(), candles.begin(), candles.end());
         const std::int64_t lastToTime = candles.back().ts;
 
+        /// Pages handed to the writer are not accumulated
         if (writer) {
             if (!candles.back().confirm) {
                 candles.pop_back();
             }
 
             writer(candles);
+        } else {
+            retVal.insert(retVal.end(), candles.begin(), candles.end());
         }
 
         candles.clear();
 
         if (from < lastToTime) {
-            candles = m_p->getHistoricalPrices(instId, barSize, from, lastToTime, limit);
+            candles = co_await m_p->asyncGetHistoricalPrices(instId, barSize, from, lastToTime, limit);
         }
     }
 
@@ -205,19 +720,159 @@ std::vector<Candle> RESTClient::getHistoricalPrices(const std::string &instId, c
     }
 
     std::ranges::reverse(retVal);
-    return retVal;
+    co_return retVal;
+}
+
+boost::asio::awaitable<std::vector<Candle> > RESTClient::P::asyncGetHistoricalShard(const std::string &instId, const BarSize barSize, const std::int64_t from,
+                                                                                     const std::int64_t to) const {
+    std::vector<Candle> retVal;
+    const auto barMs = OKX::numberOfMsForBarSize(barSize);
+    auto upper = to;
+
+    /// "before" is exclusive, the shard starts with the candle at "from"
+    while (from < upper) {
+        const auto page = co_await asyncGetHistoricalPrices(instId, barSize, from - 1, upper, MAX_CANDLES_PER_PAGE);
+        retVal.insert(retVal.end(), page.begin(), page.end());
+
+        /// Another page is needed only when older bars of the shard can still exist
+        if (static_cast<std::int64_t>(page.size()) < MAX_CANDLES_PER_PAGE || page.back().ts - barMs < from) {
+            break;
+        }
+
+        upper = page.back().ts;
+    }
+
+    std::ranges::reverse(retVal);
+
+    if (!retVal.empty() && !retVal.back().confirm) {
+        retVal.pop_back();
+    }
+
+    co_return retVal;
+}
+
+std::vector<Candle> RESTClient::getHistoricalPricesParallel(const std::string &instId, const BarSize barSize, const std::int64_t from, const std::int64_t to,
+                                                            const std::size_t maxConcurrency, const onCandlesDownloaded &writer) const {
+    return m_p->runSyncWithWriter(writer, [&](onCandlesDownloaded queueWriter) {
+        return asyncGetHistoricalPricesParallel(instId, barSize, from, to, maxConcurrency, std::move(queueWriter));
+    });
+}
+
+boost::asio::awaitable<std::vector<Candle> > RESTClient::asyncGetHistoricalPricesParallel(const std::string instId, const BarSize barSize,
+                                                                                           const std::int64_t from, const std::int64_t to,
+                                                                                           const std::size_t maxConcurrency,
+                                                                                           const onCandlesDownloaded writer) const {
+    std::vector<Candle> retVal;
+
+    if (from >= to) {
+        co_return retVal;
+    }
+
+    /// One shard is exactly one full page, shards do not depend on each other
+    const auto shardSpan = OKX::numberOfMsForBarSize(barSize) * MAX_CANDLES_PER_PAGE;
+    const auto shardCount = static_cast<std::size_t>((to - from + shardSpan - 1) / shardSpan);
+
+    struct Backfill {
+        std::mutex locker;
+        std::vector<std::vector<Candle> > shards;
+        std::vector<bool> completed;
+        std::size_t nextShard = 0;
+        std::size_t flushedShards = 0;
+
+        /// Set while a worker hands the shards to the writer
+        bool flushing = false;
+    };
+
+    const auto backfill = std::make_shared<Backfill>();
+    backfill->shards.resize(shardCount);
+    backfill->completed.resize(shardCount, false);
+
+    const auto workerCount = std::clamp<std::size_t>(maxConcurrency, 1, shardCount);
+    const auto latch = std::make_shared<CompletionLatch>(workerCount);
+
+    auto worker = [this, instId, barSize, from, to, shardSpan, shardCount, writer, backfill, latch]() -> boost::asio::awaitable<void> {
+        while (!latch->failed()) {
+            std::size_t shard;
+
+            {
+                std::lock_guard lk(backfill->locker);
+
+                if (backfill->nextShard == shardCount) {
+                    break;
+                }
+
+                shard = backfill->nextShard++;
+            }
+
+            /// The first shard keeps the exclusive lower bound of the sequential version
+            const auto shardFrom = from + static_cast<std::int64_t>(shard) * shardSpan + (shard == 0 ? 1 : 0);
+            const auto shardTo = std::min(from + static_cast<std::int64_t>(shard + 1) * shardSpan, to);
+            auto candles = co_await m_p->asyncGetHistoricalShard(instId, barSize, shardFrom, shardTo);
+
+            /// Shards are handed to the writer strictly in chronological order, by one worker at a time and outside of the
+            /// lock. Completed shards are not modified anymore.
+            std::unique_lock lk(backfill->locker);
+            backfill->shards[shard] = std::move(candles);
+            backfill->completed[shard] = true;
+
+            if (!writer || backfill->flushing) {
+                continue;
+            }
+
+            backfill->flushing = true;
+
+            while (backfill->flushedShards < shardCount && backfill->completed[backfill->flushedShards]) {
+                const auto &ready = backfill->shards[backfill->flushedShards];
+                lk.unlock();
+
+                if (!ready.empty()) {
+                    writer(ready);
+                }
+
+                lk.lock();
+                ++backfill->flushedShards;
+            }
+
+            backfill->flushing = false;
+        }
+    };
+
+    for (std::size_t i = 0; i < workerCount; ++i) {
+        boost::asio::co_spawn(m_p->executor, worker, [latch](const std::exception_ptr &e) { latch->done(e); });
+    }
+
+    co_await latch->wait();
+
+    std::size_t total = 0;
+
+    for (const auto &shard: backfill->shards) {
+        total += shard.size();
+    }
+
+    retVal.reserve(total);
+
+    for (auto &shard: backfill->shards) {
+        retVal.insert(retVal.end(), std::make_move_iterator(shard.begin()), std::make_move_iterator(shard.end()));
+    }
+
+    co_return retVal;
 }
 
 FundingRate RESTClient::getLastFundingRate(const std::string &instId) const {
+    return m_p->runSync(asyncGetLastFundingRate(instId));
+}
+
+boost::asio::awaitable<FundingRate> RESTClient::asyncGetLastFundingRate(const std::string instId) const {
     const std::string path = "/api/v5/public/funding-rate";
     std::map<std::string, std::string> parameters;
     parameters.insert_or_assign("instId", instId);
 
-    const auto response = P::checkResponse(m_p->httpSession->get(path, parameters));
-    return handleOKXResponse<FundingRate>(response);
+    const auto response = co_await m_p->get(RequestLane::History, path, parameters);
+    co_return handleOKXResponse<FundingRate>(response);
 }
 
-std::vector<FundingRate> RESTClient::P::getFundingRates(const std::string &instId, const int64_t from, const int64_t to, const int limit) const {
+boost::asio::awaitable<std::vector<FundingRate> > RESTClient::P::asyncGetFundingRates(const std::string &instId, const int64_t from, const int64_t to,
+                                                                                       const int limit) const {
     const std::string path = "/api/v5/public/funding-rate-history";
     std::map<std::string, std::string> parameters;
 
@@ -235,16 +890,21 @@ std::vector<FundingRate> RESTClient::P::getFundingRates(const std::string &instI
         parameters.insert_or_assign("limit", std::to_string(limit));
     }
 
-    const auto response = checkResponse(httpSession->get(path, parameters));
-    return handleOKXResponse<FundingRates>(response).rates;
+    const auto response = co_await get(RequestLane::History, path, parameters);
+    co_return handleOKXResponse<FundingRates>(response).rates;
 }
 
 std::vector<FundingRate> RESTClient::getFundingRates(const std::string &instId, const int64_t from, const int64_t to, const int limit) const {
+    return m_p->runSync(asyncGetFundingRates(instId, from, to, limit));
+}
+
+boost::asio::awaitable<std::vector<FundingRate> > RESTClient::asyncGetFundingRates(const std::string instId, const int64_t from, const int64_t to,
+                                                                                    const int limit) const {
     std::vector<FundingRate> retVal;
     std::vector<FundingRate> rates;
 
     if (from < to) {
-        rates = m_p->getFundingRates(instId, from, to, limit);
+        rates = co_await m_p->asyncGetFundingRates(instId, from, to, limit);
     }
 
     while (!rates.empty()) {
@@ -253,15 +913,19 @@ std::vector<FundingRate> RESTClient::getFundingRates(const std::string &instId,
         rates.clear();
 
         if (from < lastToTime) {
-            rates = m_p->getFundingRates(instId, from, lastToTime, limit);
+            rates = co_await m_p->asyncGetFundingRates(instId, from, lastToTime, limit);
         }
     }
 
     std::ranges::reverse(retVal);
-    return retVal;
+    co_return retVal;
 }
 
 Balance RESTClient::getBalance(const std::string &ccy) const {
+    return m_p->runSync(asyncGetBalance(ccy));
+}
+
+boost::asio::awaitable<Balance> RESTClient::asyncGetBalance(const std::string ccy) const {
     const std::string path = "/api/v5/account/balance";
     std::map<std::string, std::string> parameters;
 
@@ -269,19 +933,27 @@ Balance RESTClient::getBalance(const std::string &ccy) const {
         parameters.insert_or_assign("ccy", ccy);
     }
 
-    const auto response = P::checkResponse(m_p->httpSession->get(path, parameters, false));
-    return handleOKXResponse<Balance>(response);
+    const auto response = co_await m_p->get(RequestLane::Trading, path, parameters, false);
+    co_return handleOKXResponse<Balance>(response);
 }
 
 std::int64_t RESTClient::getSystemTime() const {
+    return m_p->runSync(asyncGetSystemTime());
+}
+
+boost::asio::awaitable<std::int64_t> RESTClient::asyncGetSystemTime() const {
     const std::string path = "/api/v5/public/time";
     const std::map<std::string, std::string> parameters;
 
-    const auto response = P::checkResponse(m_p->httpSession->get(path, parameters));
-    return handleOKXResponse<SystemTime>(response).ts;
+    const auto response = co_await m_p->get(RequestLane::Trading, path, parameters);
+    co_return handleOKXResponse<SystemTime>(response).ts;
 }
 
 std::vector<Position> RESTClient::getPositions(const InstrumentType instrumentType, const std::string &instId) const {
+    return m_p->runSync(asyncGetPositions(instrumentType, instId));
+}
+
+boost::asio::awaitable<std::vector<Position> > RESTClient::asyncGetPositions(const InstrumentType instrumentType, const std::string instId) const {
     const std::string path = "/api/v5/account/positions";
     std::map<std::string, std::string> parameters;
 
@@ -291,11 +963,16 @@ std::vector<Position> RESTClient::getPositions(const InstrumentType instrumentTy
         parameters.insert_or_assign("instId", instId);
     }
 
-    const auto response = P::checkResponse(m_p->httpSession->get(path, parameters, false));
-    return handleOKXResponse<Positions>(response).positions;
+    const auto response = co_await m_p->get(RequestLane::Trading, path, parameters, false);
+    co_return handleOKXResponse<Positions>(response).positions;
 }
 
 std::vector<OrderResponse> RESTClient::cancelOrder(const std::string &instId, const std::string &clientOrderId, const std::string &orderId) const {
+    return m_p->runSync(asyncCancelOrder(instId, clientOrderId, orderId));
+}
+
+boost::asio::awaitable<std::vector<OrderResponse> > RESTClient::asyncCancelOrder(const std::string instId, const std::string clientOrderId,
+                                                                                  const std::string orderId) const {
     const std::string path = "/api/v5/trade/cancel-order";
 
     nlohmann::json json;
@@ -303,17 +980,26 @@ std::vector<OrderResponse> RESTClient::cancelOrder(const std::string &instId, co
     json["clOrdId"] = clientOrderId;
     json["ordId"] = orderId;
 
-    const auto response = P::checkResponse(m_p->httpSession->post(path, json, false));
-    return handleOKXResponse<OrderResponses>(response).orderResponses;
+    const auto response = co_await m_p->post(RequestLane::Trading, path, json, false);
+    co_return handleOKXResponse<OrderResponses>(response).orderResponses;
 }
 
 std::vector<OrderResponse> RESTClient::placeOrder(const Order &order) const {
+    return m_p->runSync(asyncPlaceOrder(order));
+}
+
+boost::asio::awaitable<std::vector<OrderResponse> > RESTClient::asyncPlaceOrder(const Order order) const {
     const std::string path = "/api/v5/trade/order";
-    const auto response = P::checkResponse(m_p->httpSession->post(path, order.toJson(), false));
-    return handleOKXResponse<OrderResponses>(response).orderResponses;
+    const auto response = co_await m_p->post(RequestLane::Trading, path, order.toJson(), false);
+    co_return handleOKXResponse<OrderResponses>(response).orderResponses;
 }
 
 std::vector<OrderDetail> RESTClient::getOrderDetail(const std::string &instId, const std::string &clientOrderId, const std::string &orderId) const {
+    return m_p->runSync(asyncGetOrderDetail(instId, clientOrderId, orderId));
+}
+
+boost::asio::awaitable<std::vector<OrderDetail> > RESTClient::asyncGetOrderDetail(const std::string instId, const std::string clientOrderId,
+                                                                                   const std::string orderId) const {
     const std::string path = "/api/v5/trade/order";
     std::map<std::string, std::string> parameters;
 
@@ -321,8 +1007,8 @@ std::vector<OrderDetail> RESTClient::getOrderDetail(const std::string &instId, c
     parameters.insert_or_assign("clOrdId", clientOrderId);
     parameters.insert_or_assign("ordId", orderId);
 
-    const auto response = P::checkResponse(m_p->httpSession->get(path, parameters, false));
-    return handleOKXResponse<OrderDetails>(response).orderDetails;
+    const auto response = co_await m_p->get(RequestLane::Trading, path, parameters, false);
+    co_return handleOKXResponse<OrderDetails>(response).orderDetails;
 }
 
 MarketDataHistory RESTClient::getMarketDataHistory(
@@ -332,6 +1018,16 @@ MarketDataHistory RESTClient::getMarketDataHistory(
     const DateAggrType dateAggrType,
     const std::int64_t begin,
     const std::int64_t end) const {
+    return m_p->runSync(asyncGetMarketDataHistory(module, instType, instFamilyOrIdList, dateAggrType, begin, end));
+}
+
+boost::asio::awaitable<MarketDataHistory> RESTClient::asyncGetMarketDataHistory(
+    const MarketDataModule module,
+    const InstrumentType instType,
+    const std::string instFamilyOrIdList,
+    const DateAggrType dateAggrType,
+    const std::int64_t begin,
+    const std::int64_t end) const {
 
     const std::string path = "/api/v5/public/market-data-history";
     std::map<std::string, std::string> parameters;
@@ -356,21 +1052,40 @@ MarketDataHistory RESTClient::getMarketDataHistory(
     parameters.insert_or_assign("begin", std::to_string(begin));
     parameters.insert_or_assign("end", std::to_string(end));
 
-    m_p->marketDataHistoryLimiter.wait();
-    const auto response = P::checkResponse(m_p->httpSession->get(path, parameters));
-    return handleOKXResponse<MarketDataHistory>(response);
+    const auto response = co_await m_p->get(RequestLane::History, path, parameters);
+    co_return handleOKXResponse<MarketDataHistory>(response);
 }
 
 std::vector<std::uint8_t> RESTClient::downloadMarketDataFile(const std::string &url) {
     return HTTPSession::downloadBinary(url);
 }
 
+void RESTClient::setMarketDataCache(std::shared_ptr<MarketDataCache> cache) const {
+    m_p->marketDataCache = std::move(cache);
+}
+
+std::vector<std::uint8_t> RESTClient::fetchMarketDataFile(const MarketDataFileInfo &file) const {
+    // The slot is held only for the download itself
+    const auto download = [this](const std::string &url) {
+        const auto permit = m_p->runSync(m_p->scheduler.acquire(RequestLane::History));
+        return downloadMarketDataFile(url);
+    };
+
+    if (m_p->marketDataCache) {
+        return m_p->marketDataCache->fetch(file, download);
+    }
+
+    return download(file.url);
+}
+
 std::vector<Candle> RESTClient::downloadAndParseHistoricalCandles(
     const InstrumentType instType,
     const std::string &instFamily,
     const DateAggrType dateAggrType,
     const std::int64_t begin,
-    const std::int64_t end) const {
+    const std::int64_t end,
+    const MarketDataPipelineOptions &options,
+    const onCandlesDownloaded &writer) const {
 
     // Get download URLs
     const auto history = getMarketDataHistory(
@@ -381,31 +1096,327 @@ std::vector<Candle> RESTClient::downloadAndParseHistoricalCandles(
         begin,
         end);
 
-    std::vector<Candle> allCandles;
+    std::vector<MarketDataFileInfo> files;
 
-    // Process each group detail
     for (const auto &detail: history.details) {
-        // Download and parse each file
-        for (const auto &fileInfo: detail.groupDetails) {
-            // Download ZIP file
-            const auto zipData = downloadMarketDataFile(fileInfo.url);
+        files.insert(files.end(), detail.groupDetails.begin(), detail.groupDetails.end());
+    }
+
+    return downloadAndParseCandleFiles(files, options, writer);
+}
+
+std::vector<Candle> RESTClient::downloadAndParseCandleFiles(const std::vector<MarketDataFileInfo> &unorderedFiles, const MarketDataPipelineOptions &options,
+                                                            const onCandlesDownloaded &writer) const {
+    // Files are downloaded and handed to the writer by date
+    auto files = unorderedFiles;
+    std::ranges::stable_sort(files, [](const MarketDataFileInfo &a, const MarketDataFileInfo &b) {
+        return a.dateTs < b.dateTs || (a.dateTs == b.dateTs && a.filename < b.filename);
+    });
+
+    struct Pipeline {
+        std::mutex locker;
+
+        /// A ZIP file is waiting for a parser or the downloads have ended
+        std::condition_variable downloaded;
+
+        /// A parser has released its ZIP file
+        std::condition_variable released;
+        std::size_t nextDownload = 0;
+        std::size_t runningDownloaders = 0;
+        std::deque<std::pair<std::size_t, std::vector<std::uint8_t> > > zipFiles;
+
+        /// Size of the downloaded ZIP files not parsed yet, including those being parsed
+        std::size_t bufferedBytes = 0;
+
+        /// Parsed candles of every file, each sorted by timestamp
+        std::vector<std::vector<Candle> > runs;
+        std::vector<bool> parsed;
+
+        /// Next file for the writer, one parser at a time writes
+        std::size_t nextWrite = 0;
+        bool writing = false;
+        std::exception_ptr error;
+
+        void fail(const std::exception_ptr &e) {
+            std::lock_guard lk(locker);
+
+            if (!error) {
+                error = e;
+            }
+
+            downloaded.notify_all();
+            released.notify_all();
+        }
+
+        /// Hand the parsed files to the writer in order, a file which is not parsed yet is handed over by its parser
+        void write(const onCandlesDownloaded &writer) {
+            std::unique_lock lk(locker);
+
+            while (!writing && !error && nextWrite < parsed.size() && parsed[nextWrite]) {
+                writing = true;
+                const auto run = std::move(runs[nextWrite]);
+                runs[nextWrite].clear();
+                lk.unlock();
+
+                try {
+                    writer(run);
+                } catch (...) {
+                    fail(std::current_exception());
+                    return;
+                }
+
+                lk.lock();
+                writing = false;
+                ++nextWrite;
+            }
+        }
+    } pipeline;
+
+    pipeline.runs.resize(files.size());
+    pipeline.parsed.resize(files.size());
+
+    const auto numDownloaders = std::clamp<std::size_t>(options.maxDownloads, 1, std::max<std::size_t>(files.size(), 1));
+    const auto numParsers = std::clamp<std::size_t>(options.maxParsers, 1, std::max<std::size_t>(files.size(), 1));
+    pipeline.runningDownloaders = numDownloaders;
+
+    auto downloader = [this, &files, &options, &pipeline] {
+        while (true) {
+            std::size_t index;
 
-            // Extract CSV from ZIP
-            const auto csvData = utils::extractZip(zipData);
+            {
+                /// Downloads pause while the parsers are behind, a file larger than the budget goes through alone
+                std::unique_lock lk(pipeline.locker);
+                pipeline.released.wait(lk, [&] {
+                    return pipeline.error || pipeline.bufferedBytes < options.maxBufferedBytes || pipeline.bufferedBytes == 0;
+                });
 
-            // Parse CSV to candles
-            auto candles = utils::parseCandlesCsv(csvData);
+                if (pipeline.error || pipeline.nextDownload == files.size()) {
+                    break;
+                }
+
+                index = pipeline.nextDownload++;
+            }
+
+            try {
+                // Download ZIP file or take it from the cache
+                auto zipData = fetchMarketDataFile(files[index]);
+
+                std::lock_guard lk(pipeline.locker);
+                pipeline.bufferedBytes += zipData.size();
+                pipeline.zipFiles.emplace_back(index, std::move(zipData));
+                pipeline.downloaded.notify_one();
+            } catch (...) {
+                pipeline.fail(std::current_exception());
+                break;
+            }
+        }
+
+        std::lock_guard lk(pipeline.locker);
+        --pipeline.runningDownloaders;
+        pipeline.downloaded.notify_all();
+    };
+
+    auto parser = [&pipeline, &options, &writer] {
+        while (true) {
+            std::pair<std::size_t, std::vector<std::uint8_t> > zipFile;
+
+            {
+                std::unique_lock lk(pipeline.locker);
+                pipeline.downloaded.wait(lk, [&] { return pipeline.error || !pipeline.zipFiles.empty() || pipeline.runningDownloaders == 0; });
+
+                if (pipeline.error || pipeline.zipFiles.empty()) {
+                    break;
+                }
+
+                zipFile = std::move(pipeline.zipFiles.front());
+                pipeline.zipFiles.pop_front();
+            }
+
+            try {
+                // Parse CSV to candles while the ZIP entry is being inflated
+                auto candles = utils::parseCandlesZip(zipFile.second, options.instId);
+
+                {
+                    std::lock_guard lk(pipeline.locker);
+                    pipeline.runs[zipFile.first] = std::move(candles);
+                    pipeline.parsed[zipFile.first] = true;
+                    pipeline.bufferedBytes -= zipFile.second.size();
+                    pipeline.released.notify_all();
+                }
 
-            // Append to result
-            allCandles.insert(allCandles.end(), candles.begin(), candles.end());
+                if (writer) {
+                    pipeline.write(writer);
+                }
+            } catch (...) {
+                pipeline.fail(std::current_exception());
+                break;
+            }
         }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(numDownloaders + numParsers);
+
+    for (std::size_t i = 0; i < numDownloaders; ++i) {
+        threads.emplace_back(downloader);
+    }
+
+    for (std::size_t i = 0; i < numParsers; ++i) {
+        threads.emplace_back(parser);
+    }
+
+    for (auto &thread: threads) {
+        thread.join();
     }
 
-    // Sort by timestamp
-    std::ranges::sort(allCandles, [](const Candle &a, const Candle &b) {
-        return a.ts < b.ts;
+    if (pipeline.error) {
+        std::rethrow_exception(pipeline.error);
+    }
+
+    // Every file is already sorted, merge them instead of sorting everything again. Files handed to the writer are empty.
+    return utils::mergeSortedCandles(std::move(pipeline.runs));
+}
+
+BackfillPlan RESTClient::planBackfill(const std::string &instId, const BarSize barSize, const std::int64_t from, const std::int64_t to,
+                                      const BackfillOptions &options) const {
+    BackfillPlan retVal;
+
+    if (from > to) {
+        return retVal;
+    }
+
+    const auto barMs = OKX::numberOfMsForBarSize(barSize);
+    std::vector<MarketDataFileInfo> days;
+
+    // ZIP files exist only for 1m candles and whole days
+    if (barSize == BarSize::_1m && to - from + barMs >= DAY_MS && options.zipFileCost < restPages(0, DAY_MS - barMs, barMs)) {
+        const auto [instType, instFamily] = marketDataInstrument(instId);
+
+        try {
+            for (auto begin = from; begin <= to; begin += MAX_DAILY_LISTING_DAYS * DAY_MS) {
+                const auto end = std::min(begin + MAX_DAILY_LISTING_DAYS * DAY_MS - 1, to);
+                const auto history = getMarketDataHistory(MarketDataModule::Candles1m, instType, instFamily, DateAggrType::daily, begin, end);
+                ++retVal.listingRequests;
+
+                for (const auto &detail: history.details) {
+                    for (const auto &file: detail.groupDetails) {
+                        if (file.dateTs >= from && file.dateTs + DAY_MS - barMs <= to) {
+                            days.push_back(file);
+                        }
+                    }
+                }
+            }
+        } catch (const std::exception &e) {
+            spdlog::warn("Market data history of {} is not available, using REST only: {}", instId, e.what());
+            days.clear();
+        }
+
+        std::ranges::sort(days, [](const MarketDataFileInfo &a, const MarketDataFileInfo &b) {
+            return a.dateTs < b.dateTs || (a.dateTs == b.dateTs && a.filename < b.filename);
+        });
+
+        // Overlapping listings or several files of one day, the first one is taken
+        const auto duplicates = std::ranges::unique(days, {}, &MarketDataFileInfo::dateTs);
+        days.erase(duplicates.begin(), duplicates.end());
+    }
+
+    auto addRest = [&](const std::int64_t stepFrom, const std::int64_t stepTo) {
+        if (stepFrom <= stepTo) {
+            retVal.steps.push_back({BackfillSource::rest, stepFrom, stepTo, {}, restPages(stepFrom, stepTo, barMs)});
+        }
+    };
+
+    auto cursor = from;
+
+    for (const auto &day: days) {
+        const auto dayTo = day.dateTs + DAY_MS - barMs;
+        addRest(cursor, day.dateTs - barMs);
+
+        if (!retVal.steps.empty() && retVal.steps.back().source == BackfillSource::zip && retVal.steps.back().to + barMs == day.dateTs) {
+            retVal.steps.back().to = dayTo;
+            retVal.steps.back().files.push_back(day);
+            retVal.steps.back().cost += options.zipFileCost;
+        } else {
+            retVal.steps.push_back({BackfillSource::zip, day.dateTs, dayTo, {day}, options.zipFileCost});
+        }
+
+        cursor = dayTo + barMs;
+    }
+
+    addRest(cursor, to);
+    retVal.cost = static_cast<double>(retVal.listingRequests);
+
+    for (const auto &step: retVal.steps) {
+        retVal.cost += step.cost;
+    }
+
+    return retVal;
+}
+
+BackfillResult RESTClient::backfill(const std::string &instId, const BarSize barSize, const std::int64_t from, const std::int64_t to,
+                                    const BackfillOptions &options, const onCandlesDownloaded &writer) const {
+    const auto plan = planBackfill(instId, barSize, from, to, options);
+
+    // REST steps are downloaded one at a time by a single worker while the ZIP steps go through the pipeline, each
+    // step already runs maxRestConcurrency requests
+    std::vector<std::promise<std::vector<Candle> > > restSteps(std::ranges::count(plan.steps, BackfillSource::rest, &BackfillStep::source));
+    std::vector<std::future<std::vector<Candle> > > restResults;
+
+    for (auto &restStep: restSteps) {
+        restResults.push_back(restStep.get_future());
+    }
+
+    // Set when the backfill fails, the future of the worker waits for it in its destructor
+    std::atomic<bool> cancelled = false;
+
+    const auto restWorker = std::async(std::launch::async, [this, &instId, barSize, &plan, &options, &restSteps, &cancelled] {
+        std::size_t index = 0;
+
+        for (const auto &step: plan.steps) {
+            if (step.source != BackfillSource::rest) {
+                continue;
+            }
+
+            if (cancelled) {
+                return;
+            }
+
+            try {
+                restSteps[index].set_value(getHistoricalPricesParallel(instId, barSize, step.from - 1, step.to + 1, options.maxRestConcurrency));
+            } catch (...) {
+                // The remaining steps are not needed, the backfill fails at this one
+                restSteps[index].set_exception(std::current_exception());
+                return;
+            }
+
+            ++index;
+        }
     });
 
-    return allCandles;
+    BackfillResult retVal;
+    BackfillSink sink(*this, instId, barSize, from, to, options, writer, retVal);
+    auto pipelineOptions = options.pipeline;
+    pipelineOptions.instId = instId;
+    std::size_t nextRestStep = 0;
+
+    try {
+        for (const auto &step: plan.steps) {
+            if (step.source == BackfillSource::rest) {
+                sink.write(restResults[nextRestStep++].get(), BackfillSource::rest);
+            } else {
+                // Files are handed over one at a time in order of their dates
+                [[maybe_unused]] const auto candles = downloadAndParseCandleFiles(step.files, pipelineOptions, [&sink](const std::vector<Candle> &fileCandles) {
+                    sink.write(fileCandles, BackfillSource::zip);
+                });
+            }
+        }
+
+        sink.finish();
+    } catch (...) {
+        cancelled = true;
+        throw;
+    }
+
+    return retVal;
 }
 } // namespace stonky::okx
@@ -0,0 +1,120 @@
+/**
+OKX TLS Context
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
+*/
+
+#include "stonky/okx/okx_tls_context.h"
+#include <boost/asio/ssl/error.hpp>
+#include <boost/system/system_error.hpp>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <atomic>
+#include <map>
+#include <mutex>
+
+namespace stonky::okx {
+namespace {
+struct SessionCache {
+    std::mutex locker;
+    std::map<std::string, SSL_SESSION *, std::less<> > sessions;
+    std::atomic<std::uint64_t> resumptionAttempts{0};
+    std::atomic<std::uint64_t> resumedHandshakes{0};
+    std::atomic<std::uint64_t> fullHandshakes{0};
+
+    ~SessionCache() {
+        for (const auto &[host, session]: sessions) {
+            SSL_SESSION_free(session);
+        }
+    }
+
+    static SessionCache &instance() {
+        static SessionCache cache;
+        return cache;
+    }
+};
+
+/// Called by OpenSSL whenever the server issues a new session (for TLS 1.3 after the handshake is finished)
+int onNewSession(SSL *ssl, SSL_SESSION *session) {
+    const char *host = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+
+    if (!host) {
+        return 0;
+    }
+
+    auto &cache = SessionCache::instance();
+    std::lock_guard lk(cache.locker);
+
+    if (const auto it = cache.sessions.find(host); it != cache.sessions.end()) {
+        SSL_SESSION_free(it->second);
+        it->second = session;
+    } else {
+        cache.sessions.emplace(host, session);
+    }
+
+    /// Returning 1 keeps the reference to the session
+    return 1;
+}
+}
+
+boost::asio::ssl::context &TLSContext::instance() {
+    static boost::asio::ssl::context ctx = [] {
+        /// The cache must outlive the context
+        SessionCache::instance();
+
+        boost::asio::ssl::context context{boost::asio::ssl::context::sslv23_client};
+        context.set_default_verify_paths();
+
+        SSL_CTX_set_session_cache_mode(context.native_handle(), SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_sess_set_new_cb(context.native_handle(), onNewSession);
+        return context;
+    }();
+
+    return ctx;
+}
+
+void TLSContext::prepareConnection(SSL *ssl, const std::string &host) {
+    if (!SSL_set_tlsext_host_name(ssl, host.c_str())) {
+        const boost::system::error_code ec{static_cast<int>(ERR_get_error()), boost::asio::error::get_ssl_category()};
+        throw boost::system::system_error{ec};
+    }
+
+    auto &cache = SessionCache::instance();
+    std::lock_guard lk(cache.locker);
+
+    if (const auto it = cache.sessions.find(host); it != cache.sessions.end()) {
+        /// SSL_set_session takes its own reference
+        if (SSL_set_session(ssl, it->second) == 1) {
+            cache.resumptionAttempts++;
+        }
+    }
+}
+
+void TLSContext::handshakeCompleted(SSL *ssl) {
+    auto &cache = SessionCache::instance();
+
+    if (SSL_session_reused(ssl)) {
+        cache.resumedHandshakes++;
+    } else {
+        cache.fullHandshakes++;
+    }
+}
+
+TLSSessionStats TLSContext::stats() {
+    const auto &cache = SessionCache::instance();
+    return {cache.resumptionAttempts, cache.resumedHandshakes, cache.fullHandshakes};
+}
+
+void TLSContext::clearSessionCache() {
+    auto &cache = SessionCache::instance();
+    std::lock_guard lk(cache.locker);
+
+    for (const auto &[host, session]: cache.sessions) {
+        SSL_SESSION_free(session);
+    }
+
+    cache.sessions.clear();
+}
+} // namespace stonky::okx
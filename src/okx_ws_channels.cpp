@@ -0,0 +1,99 @@
+/**
+OKX WebSocket Channels
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
+*/
+
+#include "stonky/okx/okx_ws_channels.h"
+#include "stonky/okx/okx_json_reader.h"
+
+namespace stonky::okx {
+struct WSChannelDispatcher::P {
+    onTickerEvent tickerEventCB;
+    onCandlestickEvent candlestickEventCB;
+    onTradeEvent tradeEventCB;
+    onOrderBookEvent orderBookEventCB;
+    onFundingRateEvent fundingRateEventCB;
+
+    template<typename EventType, typename Callback>
+    static void decode(const DataEvent &event, EventType &typedEvent, const Callback &callback) {
+        typedEvent.instId = event.instId;
+        readEventData(event.data, typedEvent);
+        callback(typedEvent);
+    }
+};
+
+WSChannelDispatcher::WSChannelDispatcher() : m_p(std::make_unique<P>()) {
+}
+
+WSChannelDispatcher::~WSChannelDispatcher() = default;
+
+void WSChannelDispatcher::setTickerCallback(const onTickerEvent &onTickerEventCB) const {
+    m_p->tickerEventCB = onTickerEventCB;
+}
+
+void WSChannelDispatcher::setCandlestickCallback(const onCandlestickEvent &onCandlestickEventCB) const {
+    m_p->candlestickEventCB = onCandlestickEventCB;
+}
+
+void WSChannelDispatcher::setTradeCallback(const onTradeEvent &onTradeEventCB) const {
+    m_p->tradeEventCB = onTradeEventCB;
+}
+
+void WSChannelDispatcher::setOrderBookCallback(const onOrderBookEvent &onOrderBookEventCB) const {
+    m_p->orderBookEventCB = onOrderBookEventCB;
+}
+
+void WSChannelDispatcher::setFundingRateCallback(const onFundingRateEvent &onFundingRateEventCB) const {
+    m_p->fundingRateEventCB = onFundingRateEventCB;
+}
+
+bool WSChannelDispatcher::dispatch(const DataEvent &event) const {
+    const auto *channel = findChannel(event.channel);
+
+    if (!channel) {
+        return false;
+    }
+
+    switch (channel->type) {
+        case ChannelType::tickers:
+            if (m_p->tickerEventCB) {
+                DataEventTicker typedEvent;
+                P::decode(event, typedEvent, m_p->tickerEventCB);
+            }
+            break;
+        case ChannelType::candle:
+            if (m_p->candlestickEventCB) {
+                DataEventCandlestick typedEvent;
+                typedEvent.barSize = channel->barSize;
+                P::decode(event, typedEvent, m_p->candlestickEventCB);
+            }
+            break;
+        case ChannelType::trades:
+            if (m_p->tradeEventCB) {
+                DataEventTrade typedEvent;
+                P::decode(event, typedEvent, m_p->tradeEventCB);
+            }
+            break;
+        case ChannelType::books:
+            if (m_p->orderBookEventCB) {
+                DataEventOrderBook typedEvent;
+                typedEvent.channel = channel->name;
+                /// books5 and bbo-tbt have no action, every message is a full snapshot
+                typedEvent.snapshot = event.action != "update";
+                P::decode(event, typedEvent, m_p->orderBookEventCB);
+            }
+            break;
+        case ChannelType::fundingRate:
+            if (m_p->fundingRateEventCB) {
+                DataEventFundingRate typedEvent;
+                P::decode(event, typedEvent, m_p->fundingRateEventCB);
+            }
+            break;
+    }
+
+    return true;
+}
+} // namespace stonky::okx
@@ -7,9 +7,23 @@ Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
 */
 
 #include "stonky/okx/okx_ws_client.h"
+#include "stonky/okx/okx_tls_context.h"
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/beast/core.hpp>
+#include <charconv>
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
 #include <thread>
 
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#endif
+
 using namespace std::chrono_literals;
 
 namespace stonky::okx {
@@ -21,64 +35,306 @@ namespace stonky::okx {
 
 static auto OKX_FUTURES_WS_HOST = "wsaws.okx.com";
 static auto OKX_FUTURES_WS_PORT = "8443";
+static constexpr std::chrono::milliseconds RECONNECT_BASE_DELAY{500};
+static constexpr std::chrono::milliseconds RECONNECT_MAX_DELAY{30000};
+
+/// OKX allows 3 connection requests per second per IP, new sessions are spaced accordingly
+static constexpr std::chrono::milliseconds CONNECT_INTERVAL{350};
+
+/// Every n-th message of a shard is sampled for the exchange timestamp to measure the lag
+static constexpr std::uint64_t LAG_SAMPLE_INTERVAL = 16;
+
+namespace {
+/**
+ * First "ts" of the data array, 0 if there is none (candles carry no timestamp key)
+ */
+std::int64_t eventTimestamp(const std::string_view data) {
+    constexpr std::string_view key = R"("ts":")";
+    std::int64_t retVal = 0;
+
+    if (const auto pos = data.find(key); pos != std::string_view::npos) {
+        const auto *begin = data.data() + pos + key.size();
+        std::from_chars(begin, data.data() + data.size(), retVal);
+    }
+
+    return retVal;
+}
+
+void setThreadAffinity(std::thread &thread, const int cpu, const onLogMessage &logMessageCB) {
+#ifdef _WIN32
+    const bool ok = SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << cpu) != 0;
+#elif defined(__linux__)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu, &cpuSet);
+    const bool ok = pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpuSet) == 0;
+#else
+    const bool ok = false;
+#endif
+
+    if (!ok && logMessageCB) {
+        logMessageCB(LogSeverity::Warning, fmt::format("{}: cannot pin WebSocket I/O thread to CPU {}", MAKE_FILELINE, cpu));
+    }
+}
+}
 
 struct WebSocketClient::P {
-    boost::asio::io_context ioContext;
-    boost::asio::ssl::context ctx;
+    enum class ShardState {
+        idle,
+        connecting,
+        connected
+    };
+
+    /// One WebSocket connection with its share of the subscriptions
+    struct Shard {
+        boost::asio::io_context &ioContext;
+        boost::asio::steady_timer connectTimer;
+        std::weak_ptr<WebSocketSession> session;
+
+        /// Guarded by P::subscriptionLocker
+        std::set<std::string> subscriptions;
+        ShardState state = ShardState::idle;
+        int reconnectAttempts = 0;
+        bool hasConnected = false;
+        std::uint64_t messagesAtConnect = 0;
+
+        std::atomic<std::uint64_t> messages{0};
+        std::atomic<std::uint64_t> reconnects{0};
+        std::atomic<double> messageRate{0};
+        std::atomic<std::int64_t> lagMs{0};
+        std::atomic<std::int64_t> maxLagMs{0};
+
+        /// Touched only on the shard's I/O thread
+        std::chrono::steady_clock::time_point windowStart = std::chrono::steady_clock::now();
+        std::uint64_t windowMessages = 0;
+
+        explicit Shard(boost::asio::io_context &ioc) : ioContext(ioc), connectTimer(ioc) {}
+
+        void countMessage(const DataEvent &event) {
+            const auto count = messages.fetch_add(1, std::memory_order_relaxed) + 1;
+            ++windowMessages;
+
+            if (const auto now = std::chrono::steady_clock::now(); now - windowStart >= 1s) {
+                const std::chrono::duration<double> elapsed = now - windowStart;
+                messageRate.store(static_cast<double>(windowMessages) / elapsed.count(), std::memory_order_relaxed);
+                windowStart = now;
+                windowMessages = 0;
+            }
+
+            if (count % LAG_SAMPLE_INTERVAL == 0) {
+                if (const auto ts = eventTimestamp(event.data); ts != 0) {
+                    const auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+                    lagMs.store(nowMs - ts, std::memory_order_relaxed);
+
+                    if (nowMs - ts > maxLagMs.load(std::memory_order_relaxed)) {
+                        maxLagMs.store(nowMs - ts, std::memory_order_relaxed);
+                    }
+                }
+            }
+        }
+    };
+
+    WebSocketClientOptions options;
+    std::vector<std::unique_ptr<boost::asio::io_context> > ioContexts;
+    std::vector<boost::asio::executor_work_guard<boost::asio::io_context::executor_type> > workGuards;
+    std::vector<std::thread> ioThreads;
+    std::vector<std::unique_ptr<Shard> > shards;
     std::string host = {OKX_FUTURES_WS_HOST};
     std::string port = {OKX_FUTURES_WS_PORT};
-    std::weak_ptr<WebSocketSession> session;
-    std::thread ioThread;
     std::atomic<bool> isRunning = false;
     onLogMessage logMessageCB;
     onDataEvent dataEventCB;
+    onReconnect reconnectCB;
+
+    /// Shard of every subscription requested by the user
+    std::map<std::string, std::size_t> assignments;
+    std::mutex subscriptionLocker;
+    std::chrono::steady_clock::time_point nextConnectTime{};
+    bool stopping = false;
+
+    explicit P(const WebSocketClientOptions &clientOptions) : options(clientOptions) {
+        options.numSessions = std::max<std::size_t>(options.numSessions, 1);
+        options.numThreads = std::clamp<std::size_t>(options.numThreads, 1, options.numSessions);
+
+        for (std::size_t i = 0; i < options.numThreads; ++i) {
+            ioContexts.emplace_back(std::make_unique<boost::asio::io_context>(1));
+            workGuards.emplace_back(ioContexts.back()->get_executor());
+        }
+
+        for (std::size_t i = 0; i < options.numSessions; ++i) {
+            shards.emplace_back(std::make_unique<Shard>(*ioContexts[i % ioContexts.size()]));
+        }
+    }
+
+    /**
+     * Exponential backoff with equal jitter, so that many clients dropped at once do not reconnect in lockstep
+     */
+    static std::chrono::milliseconds reconnectDelay(const int attempt) {
+        thread_local std::mt19937 generator(std::random_device{}());
+
+        const auto ceiling = std::min(RECONNECT_BASE_DELAY * (1 << std::min(attempt, 10)), RECONNECT_MAX_DELAY);
+        std::uniform_int_distribution<std::int64_t> distribution(ceiling.count() / 2, ceiling.count());
+        return std::chrono::milliseconds(distribution(generator));
+    }
+
+    /**
+     * Shard with the fewest subscriptions, must be called with subscriptionLocker held
+     */
+    std::size_t selectShard() const {
+        std::size_t retVal = 0;
+
+        for (std::size_t i = 1; i < shards.size(); ++i) {
+            if (shards[i]->subscriptions.size() < shards[retVal]->subscriptions.size()) {
+                retVal = i;
+            }
+        }
+
+        if (shards[retVal]->subscriptions.size() >= options.maxSubscriptionsPerSession && logMessageCB) {
+            logMessageCB(LogSeverity::Warning, fmt::format("All {} WebSocket sessions are full, session {} gets {} subscriptions", shards.size(), retVal,
+                                                           shards[retVal]->subscriptions.size() + 1));
+        }
+
+        return retVal;
+    }
+
+    /**
+     * Start the shard's session after the delay, paced with all other connects of the client. Must be called with
+     * subscriptionLocker held.
+     */
+    void scheduleConnect(const std::size_t index, const std::chrono::milliseconds delay) {
+        auto &shard = *shards[index];
+        const auto start = std::max(std::chrono::steady_clock::now() + delay, nextConnectTime);
+        nextConnectTime = start + CONNECT_INTERVAL;
+        shard.state = ShardState::connecting;
+        shard.connectTimer.expires_at(start);
+        shard.connectTimer.async_wait([this, index](const boost::system::error_code &ec) {
+            if (!ec) {
+                connect(index);
+            }
+        });
+    }
+
+    /**
+     * Start a new session with the whole subscription set of the shard, the session packs it into as few requests
+     * as possible
+     */
+    void connect(const std::size_t index) {
+        auto &shard = *shards[index];
+        std::vector<std::string> requests;
+        bool reconnect = false;
+
+        {
+            std::lock_guard lk(subscriptionLocker);
+            requests.assign(shard.subscriptions.begin(), shard.subscriptions.end());
+
+            if (stopping || requests.empty()) {
+                shard.state = ShardState::idle;
+                return;
+            }
+
+            shard.state = ShardState::connected;
+            reconnect = shard.hasConnected;
+            shard.hasConnected = true;
+            shard.messagesAtConnect = shard.messages;
+        }
+
+        const auto ws = std::make_shared<WebSocketSession>(shard.ioContext, TLSContext::instance(), logMessageCB);
+        ws->setClosedCallback([this, index] { onSessionClosed(index); });
+        shard.session = ws;
+
+        ws->run(host, port, requests.front(), [this, &shard](const DataEvent &event) {
+            shard.countMessage(event);
+
+            if (dataEventCB) {
+                dataEventCB(event);
+            }
+        });
+
+        for (auto it = std::next(requests.begin()); it != requests.end(); ++it) {
+            ws->subscribe(*it);
+        }
+
+        if (reconnect) {
+            ++shard.reconnects;
+
+            if (reconnectCB) {
+                reconnectCB(requests);
+            }
+        }
+    }
+
+    void onSessionClosed(const std::size_t index) {
+        auto &shard = *shards[index];
+        std::lock_guard lk(subscriptionLocker);
+
+        if (stopping || shard.subscriptions.empty()) {
+            shard.state = ShardState::idle;
+            return;
+        }
+
+        /// A session which delivered data was healthy, the backoff starts over
+        if (shard.messages > shard.messagesAtConnect) {
+            shard.reconnectAttempts = 0;
+        }
+
+        const auto delay = reconnectDelay(shard.reconnectAttempts++);
 
-    P() : ctx(boost::asio::ssl::context::sslv23_client) {
+        if (logMessageCB) {
+            logMessageCB(LogSeverity::Warning, fmt::format("WebSocket session {} closed, reconnecting in {} ms", index, delay.count()));
+        }
+
+        scheduleConnect(index, delay);
     }
 };
 
-WebSocketClient::WebSocketClient() : m_p(std::make_unique<P>()) {
+WebSocketClient::WebSocketClient() : WebSocketClient(WebSocketClientOptions{}) {
+}
+
+WebSocketClient::WebSocketClient(const WebSocketClientOptions &options) : m_p(std::make_unique<P>(options)) {
 }
 
 WebSocketClient::~WebSocketClient() {
-    m_p->ioContext.stop();
+    {
+        std::lock_guard lk(m_p->subscriptionLocker);
+        m_p->stopping = true;
+    }
+
+    for (const auto &ioContext: m_p->ioContexts) {
+        ioContext->stop();
+    }
 
-    if (m_p->ioThread.joinable()) {
-        m_p->ioThread.join();
+    for (auto &ioThread: m_p->ioThreads) {
+        if (ioThread.joinable()) {
+            ioThread.join();
+        }
     }
 }
 
 void WebSocketClient::run() const {
-    if (m_p->isRunning) {
+    if (m_p->isRunning.exchange(true)) {
         return;
     }
 
-    m_p->isRunning = true;
+    for (std::size_t i = 0; i < m_p->ioContexts.size(); ++i) {
+        auto &ioContext = *m_p->ioContexts[i];
 
-    if (m_p->ioThread.joinable()) {
-        m_p->ioThread.join();
-    }
-
-    m_p->ioThread = std::thread([&] {
-        for (;;) {
-            try {
-                m_p->isRunning = true;
-
-                if (m_p->ioContext.stopped()) {
-                    m_p->ioContext.restart();
-                }
-                m_p->ioContext.run();
-                m_p->isRunning = false;
-                break;
-            } catch (std::exception &e) {
-                if (m_p->logMessageCB) {
-                    m_p->logMessageCB(LogSeverity::Error, fmt::format("{}: {}\n", MAKE_FILELINE, e.what()));
+        m_p->ioThreads.emplace_back([this, &ioContext] {
+            for (;;) {
+                try {
+                    ioContext.run();
+                    break;
+                } catch (std::exception &e) {
+                    if (m_p->logMessageCB) {
+                        m_p->logMessageCB(LogSeverity::Error, fmt::format("{}: {}\n", MAKE_FILELINE, e.what()));
+                    }
                 }
             }
-        }
+        });
 
-        m_p->isRunning = false;
-    });
+        if (!m_p->options.cpuAffinity.empty()) {
+            setThreadAffinity(m_p->ioThreads.back(), m_p->options.cpuAffinity[i % m_p->options.cpuAffinity.size()], m_p->logMessageCB);
+        }
+    }
 }
 
 void WebSocketClient::setLoggerCallback(const onLogMessage &onLogMessageCB) const {
@@ -89,23 +345,118 @@ void WebSocketClient::setDataEventCallback(const onDataEvent &onDataEventCB) con
     m_p->dataEventCB = onDataEventCB;
 }
 
+void WebSocketClient::setReconnectCallback(const onReconnect &onReconnectCB) const {
+    m_p->reconnectCB = onReconnectCB;
+}
+
 void WebSocketClient::subscribe(const std::string &subscriptionRequest) const {
-    if (const auto session = m_p->session.lock()) {
+    std::shared_ptr<WebSocketSession> session;
+
+    {
+        std::lock_guard lk(m_p->subscriptionLocker);
+
+        if (m_p->assignments.contains(subscriptionRequest)) {
+            return;
+        }
+
+        const auto index = m_p->selectShard();
+        auto &shard = *m_p->shards[index];
+        m_p->assignments.emplace(subscriptionRequest, index);
+        shard.subscriptions.insert(subscriptionRequest);
+
+        switch (shard.state) {
+            case P::ShardState::idle:
+                m_p->scheduleConnect(index, 0ms);
+                return;
+            case P::ShardState::connecting:
+                /// The whole set is sent when the session starts
+                return;
+            case P::ShardState::connected:
+                session = shard.session.lock();
+                break;
+        }
+    }
+
+    if (session) {
         session->subscribe(subscriptionRequest);
-        return;
+    }
+}
+
+void WebSocketClient::unsubscribe(const std::string &subscriptionRequest) const {
+    std::shared_ptr<WebSocketSession> session;
+
+    {
+        std::lock_guard lk(m_p->subscriptionLocker);
+        const auto it = m_p->assignments.find(subscriptionRequest);
+
+        if (it == m_p->assignments.end()) {
+            return;
+        }
+
+        auto &shard = *m_p->shards[it->second];
+        shard.subscriptions.erase(subscriptionRequest);
+        m_p->assignments.erase(it);
+
+        if (shard.state == P::ShardState::connected) {
+            session = shard.session.lock();
+        }
+    }
+
+    if (session) {
+        session->unsubscribe(subscriptionRequest);
+    }
+}
+
+void WebSocketClient::resubscribe(const std::string &subscriptionRequest) const {
+    std::shared_ptr<WebSocketSession> session;
+
+    {
+        std::lock_guard lk(m_p->subscriptionLocker);
+
+        if (const auto it = m_p->assignments.find(subscriptionRequest); it != m_p->assignments.end() && m_p->shards[it->second]->state == P::ShardState::connected) {
+            session = m_p->shards[it->second]->session.lock();
+        }
     }
 
-    const auto ws = std::make_shared<WebSocketSession>(m_p->ioContext, m_p->ctx, m_p->logMessageCB);
-    std::weak_ptr wp{ws};
-    m_p->session = std::move(wp);
-    ws->run(OKX_FUTURES_WS_HOST, OKX_FUTURES_WS_PORT, subscriptionRequest, m_p->dataEventCB);
+    if (session) {
+        session->resubscribe(subscriptionRequest);
+    }
 }
 
 bool WebSocketClient::isSubscribed(const std::string &subscriptionRequest) const {
-    if (const auto session = m_p->session.lock()) {
-        return session->isSubscribed(subscriptionRequest);
+    std::shared_ptr<WebSocketSession> session;
+
+    {
+        std::lock_guard lk(m_p->subscriptionLocker);
+
+        if (const auto it = m_p->assignments.find(subscriptionRequest); it != m_p->assignments.end()) {
+            session = m_p->shards[it->second]->session.lock();
+        }
+    }
+
+    return session && session->isSubscribed(subscriptionRequest);
+}
+
+std::vector<WSShardStats> WebSocketClient::shardStats() const {
+    std::vector<WSShardStats> retVal;
+    std::lock_guard lk(m_p->subscriptionLocker);
+
+    for (const auto &shard: m_p->shards) {
+        auto &stats = retVal.emplace_back();
+        stats.subscriptions = shard->subscriptions.size();
+        stats.connected = shard->state == P::ShardState::connected;
+        stats.messages = shard->messages;
+        stats.messageRate = shard->messageRate;
+        stats.lag = std::chrono::milliseconds(shard->lagMs.load());
+        stats.maxLag = std::chrono::milliseconds(shard->maxLagMs.load());
+        stats.reconnects = shard->reconnects;
+
+        if (const auto session = shard->session.lock()) {
+            stats.pendingSubscriptions = session->pendingSubscriptions();
+            stats.writeQueue = session->writeQueueStats();
+        }
     }
 
-    return false;
+    return retVal;
 }
 }
@@ -7,67 +7,194 @@ Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
 */
 
 #include "stonky/okx/okx_ws_session.h"
+#include "stonky/okx/okx_tls_context.h"
+#include "stonky/okx/okx_json_reader.h"
 #include "stonky/utils/log_utils.h"
 #include "stonky/utils/json_utils.h"
 #include <nlohmann/json.hpp>
-#include <boost/asio/buffers_iterator.hpp>
+#include <fmt/ranges.h>
 #include <boost/asio/strand.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/ssl.hpp>
 #include <boost/beast/websocket.hpp>
+#include <boost/asio/post.hpp>
+#include <atomic>
+#include <deque>
+#include <ranges>
+#include <set>
 #include <utility>
 
 namespace stonky::okx {
 static constexpr int PING_INTERVAL_IN_S = 20;
+static constexpr std::size_t READ_BUFFER_INITIAL_CAPACITY = 64 * 1024;
+
+/// OKX limit of the total length of all channels in one subscribe / unsubscribe request
+static constexpr std::size_t MAX_REQUEST_SIZE = 64 * 1024;
+
+/// Text messages over this depth of the outgoing queue are dropped
+static constexpr std::size_t MAX_WRITE_QUEUE_DEPTH = 4096;
+
+namespace {
+/**
+ * Normalized subscription, the same channel and instId always give the same string regardless of the input formatting
+ */
+std::string subscriptionKey(const std::string &subscriptionRequest) {
+    WSSubscription wsSubscription;
+    wsSubscription.fromJson(nlohmann::json::parse(subscriptionRequest));
+    return wsSubscription.toJson().dump();
+}
+}
 
 struct WebSocketSession::P {
     boost::asio::ip::tcp::resolver resolver;
     boost::beast::websocket::stream<boost::beast::ssl_stream<boost::beast::tcp_stream>> ws;
-    boost::beast::multi_buffer buffer;
+    /// Reused for every frame, it grows to the largest message seen and is never shrunk
+    boost::beast::flat_buffer buffer;
     std::string host;
-    std::vector<std::string> subscriptions;
-    std::string subscriptionRequest;
+    /// Acknowledged subscriptions
+    std::set<std::string> subscriptions;
+
+    /// Subscribe / unsubscribe operations not sent yet, in order of the calls
+    std::deque<std::pair<OperationType, std::string> > pendingOps;
+
+    /// Sent requests, each with the args which have not been acknowledged yet
+    std::deque<std::pair<OperationType, std::set<std::string> > > inFlightRequests;
+
+    enum class OutgoingType {
+        text,
+        /// Placeholder for the pending subscribe / unsubscribe ops, the request is built just before it is written
+        subscriptions,
+        ping,
+        close
+    };
+
+    /// Outgoing queue, touched only on the strand. The front message is the one being written while
+    /// writeInProgress is set, Beast allows just one write operation (write, ping or close) at a time.
+    std::deque<std::pair<OutgoingType, std::string> > writeQueue;
+    bool connected = false;
+    bool writeInProgress = false;
+    bool closing = false;
+
+    std::atomic<std::uint64_t> writtenMessages{0};
+    std::atomic<std::uint64_t> coalescedMessages{0};
+    std::atomic<std::uint64_t> droppedMessages{0};
+    std::atomic<std::size_t> writeQueueDepth{0};
+    std::atomic<std::size_t> maxWriteQueueDepth{0};
     onLogMessage logMessageCB;
     onDataEvent dataEventCB;
+    onSessionClosed sessionClosedCB;
+    bool closedNotified = false;
     boost::asio::steady_timer pingTimer;
     std::chrono::time_point<std::chrono::system_clock> lastPingTime{};
     std::chrono::time_point<std::chrono::system_clock> lastPongTime{};
     mutable std::recursive_mutex subscriptionLocker;
 
     P(boost::asio::io_context &ioc, boost::asio::ssl::context &ctx, onLogMessage onLogMessageCB) :
-        resolver(make_strand(ioc)), ws(make_strand(ioc), ctx), logMessageCB(std::move(onLogMessageCB)), pingTimer(ioc, boost::asio::chrono::seconds(PING_INTERVAL_IN_S)) {}
+        resolver(make_strand(ioc)), ws(make_strand(ioc), ctx), logMessageCB(std::move(onLogMessageCB)), pingTimer(ws.get_executor(), boost::asio::chrono::seconds(PING_INTERVAL_IN_S)) {
+        buffer.reserve(READ_BUFFER_INITIAL_CAPACITY);
+    }
+
+    [[nodiscard]] bool isPending(const OperationType op, const std::string &key) const {
+        if (std::ranges::find(pendingOps, std::pair{op, key}) != pendingOps.end()) {
+            return true;
+        }
+
+        return std::ranges::any_of(inFlightRequests, [&](const auto &request) { return request.first == op && request.second.contains(key); });
+    }
 
-    void writeSubscriptionRequest(const std::string &request) {
+    /**
+     * Queue the operation unless it is a no-op. A subscribe followed by an unsubscribe of the same arg before either
+     * of them is sent cancel each other out.
+     */
+    void enqueue(const OperationType op, const std::string &key) {
         std::lock_guard lk(subscriptionLocker);
+        const auto opposite = op == OperationType::subscribe ? OperationType::unsubscribe : OperationType::subscribe;
 
-        for (const auto &rq: subscriptions) {
-            if (rq == request) {
-                return;
-            }
+        if (const auto it = std::ranges::find(pendingOps, std::pair{opposite, key}); it != pendingOps.end()) {
+            pendingOps.erase(it);
+            return;
+        }
+
+        const bool subscribed = (subscriptions.contains(key) || isPending(OperationType::subscribe, key)) && !isPending(OperationType::unsubscribe, key);
+
+        if ((op == OperationType::subscribe) == subscribed) {
+            return;
         }
 
-        this->subscriptionRequest = request;
+        pendingOps.emplace_back(op, key);
     }
 
-    std::string readSubscriptionRequest() {
+    /**
+     * Queue an unsubscribe and a subscribe of an acknowledged arg, bypassing the cancel out of enqueue(), so the
+     * server starts the stream again, e.g. with a fresh order book snapshot
+     */
+    void requeue(const std::string &key) {
         std::lock_guard lk(subscriptionLocker);
 
-        if (subscriptionRequest.empty()) {
-            return "";
+        if (!subscriptions.contains(key) || isPending(OperationType::unsubscribe, key)) {
+            return;
         }
 
-        WSRequest wsRequest;
-        WSSubscription wsSubscription;
-        wsSubscription.fromJson(nlohmann::json::parse(subscriptionRequest));
-        wsRequest.subscriptions.push_back(wsSubscription);
-        std::string retVal = wsRequest.toJson().dump();
+        pendingOps.emplace_back(OperationType::unsubscribe, key);
+        pendingOps.emplace_back(OperationType::subscribe, key);
+    }
+
+    /**
+     * Pack the leading pending operations with the same op into one request, up to MAX_REQUEST_SIZE
+     * @return empty string if nothing is pending
+     */
+    std::string nextRequestFrame() {
+        std::lock_guard lk(subscriptionLocker);
+
+        if (pendingOps.empty()) {
+            return {};
+        }
+
+        const auto op = pendingOps.front().first;
+        std::string frame = fmt::format(R"({{"op":"{}","args":[)", magic_enum::enum_name(op));
+        auto &[requestOp, args] = inFlightRequests.emplace_back(op, std::set<std::string>{});
 
-        subscriptionRequest.clear();
-        return retVal;
+        while (!pendingOps.empty() && pendingOps.front().first == op) {
+            const auto &key = pendingOps.front().second;
+
+            if (!args.empty() && frame.size() + key.size() + 3 > MAX_REQUEST_SIZE) {
+                break;
+            }
+
+            if (!args.empty()) {
+                frame.push_back(',');
+            }
+
+            frame.append(key);
+            args.insert(key);
+            pendingOps.pop_front();
+        }
+
+        frame.append("]}");
+        return frame;
     }
 
-    static bool isControlEvent(const nlohmann::json &json) { return json.contains("event"); }
+    /**
+     * Mark one arg of the oldest matching request as acknowledged
+     */
+    void acknowledge(const OperationType op, const std::string &key) {
+        for (auto it = inFlightRequests.begin(); it != inFlightRequests.end(); ++it) {
+            if (it->first == op && it->second.erase(key)) {
+                if (it->second.empty()) {
+                    inFlightRequests.erase(it);
+                }
+
+                break;
+            }
+        }
+
+        if (op == OperationType::subscribe) {
+            subscriptions.insert(key);
+        } else {
+            subscriptions.erase(key);
+        }
+    }
 
     void handleControlEvent(const nlohmann::json &json) {
         std::lock_guard lk(subscriptionLocker);
@@ -77,12 +204,17 @@ struct WebSocketSession::P {
 
         if (wsResponse.event == EventType::error) {
             logMessageCB(LogSeverity::Error, fmt::format("OKX Error Event, code: {}, message: {}", wsResponse.code, wsResponse.msg));
+
+            /// The error is not bound to an arg, OKX rejects the whole request, which is the oldest one still waiting
+            if (!inFlightRequests.empty()) {
+                logMessageCB(LogSeverity::Warning, fmt::format("{} request rejected, args not acknowledged: {}", magic_enum::enum_name(inFlightRequests.front().first),
+                                                               fmt::join(inFlightRequests.front().second, ",")));
+                inFlightRequests.pop_front();
+            }
         } else if (wsResponse.event == EventType::subscribe) {
-            subscriptions.push_back(wsResponse.subscription.toJson().dump());
+            acknowledge(OperationType::subscribe, wsResponse.subscription.toJson().dump());
         } else if (wsResponse.event == EventType::unsubscribe) {
-            if (const auto it = std::ranges::find(subscriptions, wsResponse.subscription.toJson().dump()); it != subscriptions.end()) {
-                subscriptions.erase(it);
-            }
+            acknowledge(OperationType::unsubscribe, wsResponse.subscription.toJson().dump());
         }
 
 #ifdef VERBOSE_LOG
@@ -92,7 +224,7 @@ struct WebSocketSession::P {
 
     void onResolve(const std::shared_ptr<WebSocketSession> &self, const boost::system::error_code &ec, const boost::asio::ip::tcp::resolver::results_type &results) {
         if (ec) {
-            return logMessageCB(LogSeverity::Error, fmt::format("{}: {}", MAKE_FILELINE, ec.message()));
+            return fail(fmt::format("{}: {}", MAKE_FILELINE, ec.message()));
         }
 
         get_lowest_layer(ws).expires_after(std::chrono::seconds(30));
@@ -103,14 +235,15 @@ struct WebSocketSession::P {
 
     void onConnect(const std::shared_ptr<WebSocketSession> &self, boost::system::error_code ec, const boost::asio::ip::tcp::resolver::results_type::endpoint_type &ep) {
         if (ec) {
-            return logMessageCB(LogSeverity::Error, fmt::format("{}: {}", MAKE_FILELINE, ec.message()));
+            return fail(fmt::format("{}: {}", MAKE_FILELINE, ec.message()));
         }
 
         get_lowest_layer(ws).expires_after(std::chrono::seconds(30));
 
-        if (!SSL_set_tlsext_host_name(ws.next_layer().native_handle(), host.c_str())) {
-            ec = boost::system::error_code(static_cast<int>(ERR_get_error()), boost::asio::error::get_ssl_category());
-            return logMessageCB(LogSeverity::Error, fmt::format("{}: {}", MAKE_FILELINE, ec.message()));
+        try {
+            TLSContext::prepareConnection(ws.next_layer().native_handle(), host);
+        } catch (const boost::system::system_error &e) {
+            return fail(fmt::format("{}: {}", MAKE_FILELINE, e.what()));
         }
 
         host += ':' + std::to_string(ep.port());
@@ -120,9 +253,11 @@ struct WebSocketSession::P {
 
     void onSSLHandshake(const std::shared_ptr<WebSocketSession> &self, const boost::system::error_code &ec) {
         if (ec) {
-            return logMessageCB(LogSeverity::Error, fmt::format("{}: {}", MAKE_FILELINE, ec.message()));
+            return fail(fmt::format("{}: {}", MAKE_FILELINE, ec.message()));
         }
 
+        TLSContext::handshakeCompleted(ws.next_layer().native_handle());
+
         ws.control_callback([this](boost::beast::websocket::frame_type kind, boost::beast::string_view payload) {
             boost::ignore_unused(kind, payload);
 
@@ -143,104 +278,203 @@ struct WebSocketSession::P {
 
     void onHandshake(const std::shared_ptr<WebSocketSession> &self, const boost::system::error_code &ec) {
         if (ec) {
-            return logMessageCB(LogSeverity::Error, fmt::format("{}: {}", MAKE_FILELINE, ec.message()));
+            return fail(fmt::format("{}: {}", MAKE_FILELINE, ec.message()));
         }
 
         pingTimer.async_wait([this, self](const boost::system::error_code &e) { onPingTimer(self, e); });
 
-        ws.async_write(boost::asio::buffer(readSubscriptionRequest()),
-                         [this, self](const boost::system::error_code &e, const std::size_t bytesTransferred) { onWrite(self, e, bytesTransferred); });
+        connected = true;
+        queueWrite(self, OutgoingType::subscriptions);
+        ws.async_read(buffer, [this, self](const boost::system::error_code &e, const std::size_t transferred) { onRead(self, e, transferred); });
     }
 
-    void onWrite(const std::shared_ptr<WebSocketSession> &self, const boost::system::error_code &ec, std::size_t bytesTransferred) {
-        boost::ignore_unused(bytesTransferred);
+    /**
+     * Add a message to the outgoing queue, must run on the strand. Subscriptions and pings already waiting in the
+     * queue absorb new ones, text messages are dropped when the queue is full.
+     */
+    void queueWrite(const std::shared_ptr<WebSocketSession> &self, const OutgoingType type, std::string payload = {}) {
+        if (closing) {
+            return;
+        }
+
+        if (type == OutgoingType::subscriptions || type == OutgoingType::ping) {
+            const auto waiting = writeQueue.begin() + (writeInProgress ? 1 : 0);
+
+            if (std::any_of(waiting, writeQueue.end(), [type](const auto &message) { return message.first == type; })) {
+                ++coalescedMessages;
+
+                // The absorbing message may have been queued before the handshake, when nothing could be written yet
+                return doWrite(self);
+            }
+        } else if (type == OutgoingType::text && writeQueue.size() >= MAX_WRITE_QUEUE_DEPTH) {
+            ++droppedMessages;
+            return logMessageCB(LogSeverity::Error, fmt::format("{}: write queue full, message dropped", MAKE_FILELINE));
+        }
+
+        closing = type == OutgoingType::close;
+        writeQueue.emplace_back(type, std::move(payload));
+        writeQueueDepth = writeQueue.size();
+
+        if (writeQueue.size() > maxWriteQueueDepth) {
+            maxWriteQueueDepth = writeQueue.size();
+        }
+
+        doWrite(self);
+    }
+
+    /**
+     * Start writing the front message if nothing is being written, must run on the strand
+     */
+    void doWrite(const std::shared_ptr<WebSocketSession> &self) {
+        if (!connected || writeInProgress) {
+            return;
+        }
+
+        while (!writeQueue.empty() && writeQueue.front().first == OutgoingType::subscriptions) {
+            if (writeQueue.front().second = nextRequestFrame(); !writeQueue.front().second.empty()) {
+                break;
+            }
+
+            writeQueue.pop_front();
+        }
+
+        writeQueueDepth = writeQueue.size();
+
+        if (writeQueue.empty()) {
+            return;
+        }
+
+        writeInProgress = true;
+        auto onWritten = [this, self](const boost::system::error_code &e, std::size_t = 0) { onWrite(self, e); };
+
+        switch (const auto &[type, payload] = writeQueue.front(); type) {
+            case OutgoingType::text:
+            case OutgoingType::subscriptions:
+                ws.async_write(boost::asio::buffer(payload), std::move(onWritten));
+                break;
+            case OutgoingType::ping:
+                ws.async_ping({}, std::move(onWritten));
+                break;
+            case OutgoingType::close:
+                ws.async_close(boost::beast::websocket::close_code::normal, [this, self](const boost::system::error_code &e) {
+                    writeInProgress = false;
+                    writeQueue.clear();
+                    writeQueueDepth = 0;
+                    onClose(e);
+                });
+                break;
+        }
+    }
+
+    void onWrite(const std::shared_ptr<WebSocketSession> &self, const boost::system::error_code &ec) {
+        const auto type = writeQueue.front().first;
+        writeInProgress = false;
+        writeQueue.pop_front();
 
         if (ec) {
-            return logMessageCB(LogSeverity::Error, fmt::format("{}: {}", MAKE_FILELINE, ec.message()));
+            writeQueue.clear();
+            writeQueueDepth = 0;
+            logMessageCB(LogSeverity::Error, fmt::format("{}: {}", MAKE_FILELINE, ec.message()));
+
+            /// The pending read fails as well and reports the session closed
+            boost::system::error_code ignored;
+            get_lowest_layer(ws).socket().close(ignored);
+            return;
         }
 
-        ws.async_read(buffer, [this, self](const boost::system::error_code &e, const std::size_t transferred) { onRead(self, e, transferred); });
+        ++writtenMessages;
+
+        if (type == OutgoingType::ping) {
+            lastPingTime = std::chrono::system_clock::now();
+        } else if (type == OutgoingType::subscriptions) {
+            /// Ops which did not fit into the request
+            std::lock_guard lk(subscriptionLocker);
+
+            if (!pendingOps.empty()) {
+                writeQueue.emplace_back(OutgoingType::subscriptions, std::string{});
+            }
+        }
+
+        doWrite(self);
     }
 
     void onRead(const std::shared_ptr<WebSocketSession> &self, const boost::system::error_code &ec, std::size_t bytesTransferred) {
         boost::ignore_unused(bytesTransferred);
 
         if (ec) {
-            pingTimer.cancel();
-            return logMessageCB(LogSeverity::Error, fmt::format("{}: {}", MAKE_FILELINE, ec.message()));
+            return fail(fmt::format("{}: {}", MAKE_FILELINE, ec.message()));
         }
 
         try {
-            const auto size = buffer.size();
-            std::string strBuffer;
-            strBuffer.reserve(size);
-
-            for (const auto &it: buffer.data()) {
-                strBuffer.append(static_cast<const char *>(it.data()), it.size());
+            /// The frame is parsed in place, data event members are views into the buffer until it is consumed
+            const auto frameBuffer = buffer.data();
+            const std::string_view frame(static_cast<const char *>(frameBuffer.data()), frameBuffer.size());
+
+            if (DataEvent dataEvent; !readDataEvent(frame, dataEvent)) {
+                handleControlEvent(nlohmann::json::parse(frame));
+            } else if (dataEventCB) {
+                try {
+                    dataEventCB(dataEvent);
+                } catch (std::exception &e) {
+                    logMessageCB(LogSeverity::Error, fmt::format("{}: {}", MAKE_FILELINE, e.what()));
+                }
             }
 
             buffer.consume(buffer.size());
 
-            if (const nlohmann::json json = nlohmann::json::parse(strBuffer); json.is_object()) {
-                if (isControlEvent(json)) {
-                    handleControlEvent(json);
-                } else {
-                    try {
-                        DataEvent dataEvent;
-                        dataEvent.fromJson(json);
-
-                        if (dataEventCB) {
-                            dataEventCB(dataEvent);
-                        }
-                    } catch (std::exception &e) {
-                        logMessageCB(LogSeverity::Error, fmt::format("{}: {}", MAKE_FILELINE, e.what()));
-                    }
-                }
-            }
-
-            if (const auto subscription = readSubscriptionRequest(); !subscription.empty()) {
-                ws.async_write(boost::asio::buffer(subscription),
-                                 [this, self](const boost::system::error_code &e, const std::size_t transferred) { onWrite(self, e, transferred); });
-            } else {
+            {
                 std::lock_guard lk(subscriptionLocker);
-                if (subscriptions.empty()) {
+                if (subscriptions.empty() && pendingOps.empty() && inFlightRequests.empty()) {
                     logMessageCB(LogSeverity::Warning, fmt::format("No subscriptions, WebSocketSession quit: {}", MAKE_FILELINE));
-                    closeWs();
+                    queueWrite(self, OutgoingType::close);
                 }
-                ws.async_read(buffer, [this, self](const boost::system::error_code &e, const std::size_t transferred) { onRead(self, e, transferred); });
             }
-        } catch (nlohmann::json::exception &exc) {
+
+            ws.async_read(buffer, [this, self](const boost::system::error_code &e, const std::size_t transferred) { onRead(self, e, transferred); });
+        } catch (std::exception &exc) {
             logMessageCB(LogSeverity::Error, fmt::format("{}: {}", MAKE_FILELINE, exc.what()));
-            ws.async_close(boost::beast::websocket::close_code::normal, [this](const boost::system::error_code &e) { onClose(e); });
+            queueWrite(self, OutgoingType::close);
         }
     }
 
-    void ping() {
+    void ping(const std::shared_ptr<WebSocketSession> &self) {
         if (const std::chrono::duration<double> elapsed = lastPingTime - lastPongTime; elapsed.count() > PING_INTERVAL_IN_S) {
             logMessageCB(LogSeverity::Warning, fmt::format("{}: {}", MAKE_FILELINE, "ping expired"));
         }
 
         if (ws.is_open()) {
-            const boost::beast::websocket::ping_data pingWebSocketFrame;
-            ws.async_ping(pingWebSocketFrame, [this](const boost::system::error_code &ec) {
-                if (ec) {
-                    logMessageCB(LogSeverity::Error, fmt::format("{}: {}", MAKE_FILELINE, ec.message()));
-                } else {
-                    lastPingTime = std::chrono::system_clock::now();
-                }
-            });
+            queueWrite(self, OutgoingType::ping);
+        }
+    }
+
+    void onClose(const boost::system::error_code &ec) {
+        if (ec) {
+            logMessageCB(LogSeverity::Error, fmt::format("{}: {}", MAKE_FILELINE, ec.message()));
         }
+
+        sessionClosed();
     }
 
-    void closeWs() {
-        ws.async_close(boost::beast::websocket::close_code::normal, [this](const boost::system::error_code &ec) { onClose(ec); });
+    void fail(const std::string &message) {
+        logMessageCB(LogSeverity::Error, message);
+        sessionClosed();
     }
 
-    void onClose(const boost::system::error_code &ec) {
+    /**
+     * Report the end of the session exactly once, whichever of the read, write or close handlers gets there first
+     */
+    void sessionClosed() {
         pingTimer.cancel();
+        connected = false;
 
-        if (ec) {
-            return logMessageCB(LogSeverity::Error, fmt::format("{}: {}", MAKE_FILELINE, ec.message()));
+        if (closedNotified) {
+            return;
+        }
+
+        closedNotified = true;
+
+        if (sessionClosedCB) {
+            sessionClosedCB();
         }
     }
 
@@ -249,19 +483,14 @@ struct WebSocketSession::P {
             return logMessageCB(LogSeverity::Error, fmt::format("{}: {}", MAKE_FILELINE, ec.message()));
         }
 
-        ping();
+        ping(self);
         pingTimer.expires_after(boost::asio::chrono::seconds(PING_INTERVAL_IN_S));
         pingTimer.async_wait([this, self](const boost::system::error_code &e) { onPingTimer(self, e); });
     }
 
-    [[nodiscard]] bool isSubscribed(const std::string &request) const {
+    [[nodiscard]] bool isSubscribed(const std::string &key) const {
         std::lock_guard lk(subscriptionLocker);
-
-        if (const auto it = std::ranges::find(subscriptions, request); it != subscriptions.end()) {
-            return true;
-        }
-
-        return false;
+        return subscriptions.contains(key);
     }
 };
 
@@ -276,9 +505,54 @@ WebSocketSession::~WebSocketSession() {
 #endif
 }
 
-void WebSocketSession::subscribe(const std::string &subscriptionRequest) const { m_p->writeSubscriptionRequest(subscriptionRequest); }
+void WebSocketSession::subscribe(const std::string &subscriptionRequest) const {
+    m_p->enqueue(OperationType::subscribe, subscriptionKey(subscriptionRequest));
+    flush();
+}
+
+void WebSocketSession::unsubscribe(const std::string &subscriptionRequest) const {
+    m_p->enqueue(OperationType::unsubscribe, subscriptionKey(subscriptionRequest));
+    flush();
+}
+
+void WebSocketSession::resubscribe(const std::string &subscriptionRequest) const {
+    m_p->requeue(subscriptionKey(subscriptionRequest));
+    flush();
+}
+
+bool WebSocketSession::isSubscribed(const std::string &subscriptionRequest) const { return m_p->isSubscribed(subscriptionKey(subscriptionRequest)); }
+
+std::size_t WebSocketSession::pendingSubscriptions() const {
+    std::lock_guard lk(m_p->subscriptionLocker);
+    std::size_t retVal = m_p->pendingOps.size();
 
-bool WebSocketSession::isSubscribed(const std::string &subscriptionRequest) const { return m_p->isSubscribed(subscriptionRequest); }
+    for (const auto &request: m_p->inFlightRequests | std::views::values) {
+        retVal += request.size();
+    }
+
+    return retVal;
+}
+
+void WebSocketSession::send(std::string message) const {
+    auto self = std::const_pointer_cast<WebSocketSession>(shared_from_this());
+    boost::asio::post(m_p->ws.get_executor(), [this, self, message = std::move(message)]() mutable { m_p->queueWrite(self, P::OutgoingType::text, std::move(message)); });
+}
+
+WSWriteQueueStats WebSocketSession::writeQueueStats() const {
+    WSWriteQueueStats retVal;
+    retVal.writtenMessages = m_p->writtenMessages;
+    retVal.coalescedMessages = m_p->coalescedMessages;
+    retVal.droppedMessages = m_p->droppedMessages;
+    retVal.depth = m_p->writeQueueDepth;
+    retVal.maxDepth = m_p->maxWriteQueueDepth;
+    return retVal;
+}
+
+void WebSocketSession::flush() const {
+    /// The session is only ever owned by a shared_ptr, the const is dropped just to keep it alive in the handler
+    auto self = std::const_pointer_cast<WebSocketSession>(shared_from_this());
+    boost::asio::post(m_p->ws.get_executor(), [this, self] { m_p->queueWrite(self, P::OutgoingType::subscriptions); });
+}
 
 void WebSocketSession::run(const std::string &host, const std::string &port, const std::string &subscriptionRequest, const onDataEvent &dataEventCB) {
     if (subscriptionRequest.empty()) {
@@ -286,7 +560,7 @@ void WebSocketSession::run(const std::string &host, const std::string &port, con
     }
 
     m_p->host = host;
-    m_p->writeSubscriptionRequest(subscriptionRequest);
+    m_p->enqueue(OperationType::subscribe, subscriptionKey(subscriptionRequest));
     m_p->dataEventCB = dataEventCB;
 
     auto self = shared_from_this();
@@ -294,5 +568,10 @@ void WebSocketSession::run(const std::string &host, const std::string &port, con
             host, port, [this, self](const boost::system::error_code &ec, const boost::asio::ip::tcp::resolver::results_type &results) { m_p->onResolve(self, ec, results); });
 }
 
-void WebSocketSession::close() const { m_p->closeWs(); }
+void WebSocketSession::setClosedCallback(const onSessionClosed &sessionClosedCB) const { m_p->sessionClosedCB = sessionClosedCB; }
+
+void WebSocketSession::close() const {
+    auto self = std::const_pointer_cast<WebSocketSession>(shared_from_this());
+    boost::asio::post(m_p->ws.get_executor(), [this, self] { m_p->queueWrite(self, P::OutgoingType::close); });
+}
 } // namespace stonky::okx
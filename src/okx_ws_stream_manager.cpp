@@ -9,8 +9,13 @@ Copyright (c) 2025 Vitezslav Kot <vitezslav.kot@stonky.cz>, Stonky s.r.o.
 #include "stonky/okx/okx_rest_client.h"
 #include "stonky/okx/okx_ws_stream_manager.h"
 #include "stonky/okx/okx_ws_client.h"
+#include "stonky/okx/okx_ws_channels.h"
+#include "stonky/okx/okx_latest_value.h"
 #include "stonky/okx/okx.h"
+#include <condition_variable>
+#include <deque>
 #include <mutex>
+#include <set>
 #include <thread>
 
 #ifdef _WIN32
@@ -24,63 +29,265 @@ using namespace std::chrono_literals;
 namespace stonky::okx {
 struct WSStreamManager::P {
     std::unique_ptr<WebSocketClient> wsClient;
-    int timeout = 5;
-    mutable std::recursive_mutex tickersLocker;
-    mutable std::recursive_mutex candlestickLocker;
-    std::map<std::string, DataEventTicker> tickers;
-    std::map<std::string, std::map<BarSize, DataEventCandlestick> > candlesticks;
+    std::atomic<int> timeout = 5;
+    LatestValueMap<std::string, DataEventTicker> tickers;
+    LatestValueMap<std::pair<std::string, BarSize>, DataEventCandlestick> candlesticks;
     onLogMessage logMessageCB;
+    onCandlestickEvent candlestickEventCB;
+    mutable std::mutex orderBooksLocker;
+
+    /// Signalled after every applied message, readers wait for a valid book
+    std::condition_variable orderBooksCV;
+    std::map<std::pair<std::string, OrderBookChannel>, OrderBook> orderBooks;
+    onOrderBook orderBookCB;
+
+    /// Download of the bars missed by a candle stream while reconnecting
+    struct GapJob {
+        std::pair<std::string, BarSize> stream;
+        std::int64_t lastTs = 0;
+        std::int64_t firstTs = 0;
+    };
+
+    /// Candle streams whose next message is checked for bars missed while reconnecting
+    std::mutex gapCheckLocker;
+    std::condition_variable gapJobsCV;
+    std::set<std::pair<std::string, BarSize> > gapCheckStreams;
+
+    /// Live messages of the streams whose gap is being downloaded, delivered after the gap
+    std::map<std::pair<std::string, BarSize>, std::vector<DataEventCandlestick> > pendingGaps;
+    std::deque<GapJob> gapJobs;
+    bool gapWorkerStopping = false;
+    std::thread gapWorker;
+    std::unique_ptr<RESTClient> restClient;
+
+    WSChannelDispatcher dispatcher;
+
+    ~P() {
+        {
+            std::lock_guard lk(gapCheckLocker);
+            gapWorkerStopping = true;
+        }
 
-    explicit P() {
-        wsClient = std::make_unique<WebSocketClient>();
-        wsClient->setDataEventCallback([&](const DataEvent &event) {
-            if (event.channel == "tickers") {
-                std::lock_guard lk(tickersLocker);
+        gapJobsCV.notify_all();
 
-                try {
-                    DataEventTicker dataEventTicker;
-                    dataEventTicker.fromJson(event.data);
+        if (gapWorker.joinable()) {
+            gapWorker.join();
+        }
+    }
 
-                    if (const auto it = tickers.find(event.instId); it == tickers.end()) {
-                        tickers.insert_or_assign(event.instId, dataEventTicker);
-                    }
-                } catch (std::exception &e) {
-                    logMessageCB(LogSeverity::Error, fmt::format("{}: {}", MAKE_FILELINE, e.what()));
+    void deliverCandlestick(const DataEventCandlestick &event) {
+        candlesticks.slot({event.instId, event.barSize})->store(event);
+
+        if (candlestickEventCB) {
+            candlestickEventCB(event);
+        }
+    }
+
+    /**
+     * Hold the message back if the bars between the last one received before the reconnect (included, its final state
+     * was missed) and the first one received after it have to be downloaded first, or if such a download is running.
+     * The download runs on the gap worker, a rate-limited REST request must not stall the WebSocket thread which
+     * serves the other streams of its shards.
+     * @return true if the message is delivered later by the gap worker
+     */
+    bool deferCandlestick(const DataEventCandlestick &event) {
+        std::pair stream{event.instId, event.barSize};
+        std::lock_guard lk(gapCheckLocker);
+
+        if (const auto it = pendingGaps.find(stream); it != pendingGaps.end()) {
+            it->second.push_back(event);
+            return true;
+        }
+
+        if (gapCheckStreams.erase(stream) == 0 || event.candles.empty()) {
+            return false;
+        }
+
+        const auto slot = candlesticks.find(stream);
+        const auto last = slot ? slot->load() : nullptr;
+
+        if (!last || last->candles.empty() || event.candles.front().ts <= last->candles.back().ts) {
+            return false;
+        }
+
+        gapJobs.push_back({stream, last->candles.back().ts, event.candles.front().ts});
+        pendingGaps[std::move(stream)].push_back(event);
+
+        if (!gapWorker.joinable()) {
+            gapWorker = std::thread([this] { runGapWorker(); });
+        }
+
+        gapJobsCV.notify_one();
+        return true;
+    }
+
+    void runGapWorker() {
+        for (;;) {
+            GapJob job;
+
+            {
+                std::unique_lock lk(gapCheckLocker);
+                gapJobsCV.wait(lk, [this] { return gapWorkerStopping || !gapJobs.empty(); });
+
+                if (gapWorkerStopping) {
+                    return;
                 }
-            } else if (event.channel.find("candle") != std::string::npos) {
-                std::lock_guard lk(candlestickLocker);
 
-                try {
-                    DataEventCandlestick eventCandlestick;
-                    eventCandlestick.fromJson(event.data);
+                job = std::move(gapJobs.front());
+                gapJobs.pop_front();
+            }
+
+            if (auto missed = backfillGap(job); !missed.empty() && candlestickEventCB) {
+                DataEventCandlestick gap;
+                gap.instId = job.stream.first;
+                gap.barSize = job.stream.second;
+                gap.candles = std::move(missed);
+                candlestickEventCB(gap);
+            }
 
-                    /// Insert new candle
-                    {
-                        auto it = candlesticks.find(event.instId);
+            /// Live messages keep being buffered until the buffer is drained, so they are delivered in order
+            for (;;) {
+                std::vector<DataEventCandlestick> buffered;
 
-                        if (it == candlesticks.end()) {
-                            candlesticks.insert({event.instId, {}});
-                        }
+                {
+                    std::lock_guard lk(gapCheckLocker);
+                    const auto it = pendingGaps.find(job.stream);
 
-                        it = candlesticks.find(event.instId);
-                        it->second.insert_or_assign(OKX::candlestickChannelToBarSize(
-                                                        *magic_enum::enum_cast<CandlestickChannel>(
-                                                            event.channel)), eventCandlestick);
+                    if (it->second.empty()) {
+                        pendingGaps.erase(it);
+                        break;
                     }
-                } catch (std::exception &e) {
-                    logMessageCB(LogSeverity::Error, fmt::format("{}: {}", MAKE_FILELINE, e.what()));
+
+                    buffered.swap(it->second);
+                }
+
+                for (const auto &event: buffered) {
+                    deliverCandlestick(event);
+                }
+            }
+        }
+    }
+
+    std::vector<Candle> backfillGap(const GapJob &job) {
+        const auto &[instId, barSize] = job.stream;
+
+        try {
+            if (!restClient) {
+                restClient = std::make_unique<RESTClient>("", "", "");
+            }
+
+            auto retVal = restClient->getHistoricalPrices(instId, barSize, job.lastTs - 1, job.firstTs);
+
+            if (logMessageCB) {
+                logMessageCB(LogSeverity::Info, fmt::format("{} {}: {} candles backfilled after reconnect", instId,
+                                                            magic_enum::enum_name(OKX::barSizeToCandlestickChannel(barSize)), retVal.size()));
+            }
+
+            return retVal;
+        } catch (std::exception &e) {
+            if (logMessageCB) {
+                logMessageCB(LogSeverity::Error, fmt::format("{}: candle gap backfill failed: {}", MAKE_FILELINE, e.what()));
+            }
+        }
+
+        return {};
+    }
+
+    static std::string orderBookRequest(const std::string &instId, const OrderBookChannel channel) {
+        WSSubscription wsSubscription;
+        wsSubscription.instId = instId;
+        wsSubscription.channel = orderBookChannelName(channel);
+        return wsSubscription.toJson().dump();
+    }
+
+    /**
+     * Apply the message to the local book, a rejected book is re-subscribed and waits for the new snapshot
+     */
+    void updateOrderBook(const DataEventOrderBook &event) {
+        const auto channel = findOrderBookChannel(event.channel).value_or(OrderBookChannel::books);
+        std::unique_lock lk(orderBooksLocker);
+        const auto it = orderBooks.find({event.instId, channel});
+
+        if (it == orderBooks.end()) {
+            /// Late message of an unsubscribed book
+            return;
+        }
+
+        const auto result = it->second.apply(event);
+
+        if (result == OrderBookUpdate::applied) {
+            if (orderBookCB) {
+                orderBookCB(event.instId, channel, it->second);
+            }
+
+            lk.unlock();
+            orderBooksCV.notify_all();
+            return;
+        }
+
+        lk.unlock();
+
+        if (result == OrderBookUpdate::noSnapshot) {
+            return;
+        }
+
+        if (logMessageCB) {
+            logMessageCB(LogSeverity::Warning, fmt::format("{} {}: {}, re-subscribing", event.instId, event.channel, magic_enum::enum_name(result)));
+        }
+
+        wsClient->resubscribe(orderBookRequest(event.instId, channel));
+    }
+
+    explicit P(const WebSocketClientOptions &options) {
+        dispatcher.setTickerCallback([this](const DataEventTicker &event) { tickers.slot(event.instId)->store(event); });
+
+        dispatcher.setCandlestickCallback([this](const DataEventCandlestick &event) {
+            if (!deferCandlestick(event)) {
+                deliverCandlestick(event);
+            }
+        });
+
+        dispatcher.setOrderBookCallback([this](const DataEventOrderBook &event) { updateOrderBook(event); });
+
+        wsClient = std::make_unique<WebSocketClient>(options);
+        wsClient->setReconnectCallback([this](const std::vector<std::string> &subscriptionRequests) {
+            std::lock_guard lk(gapCheckLocker);
+
+            for (const auto &request: subscriptionRequests) {
+                WSSubscription wsSubscription;
+                wsSubscription.fromJson(nlohmann::json::parse(request));
+
+                if (const auto *channel = findChannel(wsSubscription.channel); channel && channel->type == ChannelType::candle) {
+                    gapCheckStreams.emplace(wsSubscription.instId, channel->barSize);
                 }
             }
         });
+        wsClient->setDataEventCallback([this](const DataEvent &event) {
+            try {
+                dispatcher.dispatch(event);
+            } catch (std::exception &e) {
+                logMessageCB(LogSeverity::Error, fmt::format("{}: {}", MAKE_FILELINE, e.what()));
+            }
+        });
     }
 };
 
-WSStreamManager::WSStreamManager() : m_p(std::make_unique<P>()) {
+WSStreamManager::WSStreamManager() : WSStreamManager(WebSocketClientOptions{}) {
+}
+
+WSStreamManager::WSStreamManager(const WebSocketClientOptions &options) : m_p(std::make_unique<P>(options)) {
 }
 
 WSStreamManager::~WSStreamManager() {
+    {
+        std::lock_guard lk(m_p->orderBooksLocker);
+        m_p->timeout = 0;
+    }
+
+    m_p->orderBooksCV.notify_all();
+    m_p->tickers.close();
+    m_p->candlesticks.close();
     m_p->wsClient.reset();
-    m_p->timeout = 0;
 }
 
 void WSStreamManager::subscribeTickersStream(const std::string &instId) const {
@@ -119,6 +326,55 @@ void WSStreamManager::subscribeCandlestickStream(const std::string &instId, cons
     m_p->wsClient->run();
 }
 
+void WSStreamManager::unsubscribeTickersStream(const std::string &instId) const {
+    WSSubscription wsSubscription;
+    wsSubscription.instId = instId;
+    wsSubscription.channel = "tickers";
+    m_p->wsClient->unsubscribe(wsSubscription.toJson().dump());
+}
+
+void WSStreamManager::unsubscribeCandlestickStream(const std::string &instId, const BarSize barSize) const {
+    WSSubscription wsSubscription;
+    wsSubscription.instId = instId;
+    wsSubscription.channel = magic_enum::enum_name(OKX::barSizeToCandlestickChannel(barSize));
+    m_p->wsClient->unsubscribe(wsSubscription.toJson().dump());
+}
+
+void WSStreamManager::subscribeOrderBookStream(const std::string &instId, const OrderBookChannel channel) const {
+    {
+        std::lock_guard lk(m_p->orderBooksLocker);
+        m_p->orderBooks.try_emplace({instId, channel}, orderBookChannelName(channel));
+    }
+
+    if (const auto subscriptionRequest = P::orderBookRequest(instId, channel); !m_p->wsClient->isSubscribed(subscriptionRequest)) {
+        if (m_p->logMessageCB) {
+            m_p->logMessageCB(LogSeverity::Info, fmt::format("subscribing: {}", subscriptionRequest));
+        }
+
+        m_p->wsClient->subscribe(subscriptionRequest);
+    }
+
+    m_p->wsClient->run();
+}
+
+void WSStreamManager::unsubscribeOrderBookStream(const std::string &instId, const OrderBookChannel channel) const {
+    m_p->wsClient->unsubscribe(P::orderBookRequest(instId, channel));
+    std::lock_guard lk(m_p->orderBooksLocker);
+    m_p->orderBooks.erase({instId, channel});
+}
+
+void WSStreamManager::setOrderBookCallback(const onOrderBook &onOrderBookCB) const {
+    m_p->orderBookCB = onOrderBookCB;
+}
+
+void WSStreamManager::setCandlestickCallback(const onCandlestickEvent &onCandlestickEventCB) const {
+    m_p->candlestickEventCB = onCandlestickEventCB;
+}
+
+std::vector<WSShardStats> WSStreamManager::shardStats() const {
+    return m_p->wsClient->shardStats();
+}
+
 void WSStreamManager::setTimeout(const int seconds) const {
     m_p->timeout = seconds;
 }
@@ -133,25 +389,14 @@ void WSStreamManager::setLoggerCallback(const onLogMessage &onLogMessageCB) cons
 }
 
 std::optional<DataEventTicker> WSStreamManager::readEventInstrumentInfo(const std::string &instId) const {
-    int numTries = 0;
-    const int maxNumTries = static_cast<int>(m_p->timeout / 0.01);
-
-    while (numTries <= maxNumTries) {
-        if (m_p->timeout == 0) {
-            /// No need to wait when destroying object
-            break;
-        }
+    const auto slot = m_p->tickers.slot(instId);
 
-        m_p->tickersLocker.lock();
+    if (const auto value = slot->load()) {
+        return *value;
+    }
 
-        if (const auto it = m_p->tickers.find(instId); it != m_p->tickers.end()) {
-            auto retVal = it->second;
-            m_p->tickersLocker.unlock();
-            return retVal;
-        }
-        m_p->tickersLocker.unlock();
-        numTries++;
-        std::this_thread::sleep_for(3ms);
+    if (const auto value = slot->waitForNext(0, std::chrono::seconds(m_p->timeout))) {
+        return *value;
     }
 
     return {};
@@ -159,28 +404,64 @@ std::optional<DataEventTicker> WSStreamManager::readEventInstrumentInfo(const st
 
 std::optional<DataEventCandlestick>
 WSStreamManager::readEventCandlestick(const std::string &instId, const BarSize barSize) const {
-    int numTries = 0;
-    const int maxNumTries = static_cast<int>(m_p->timeout / 0.01);
+    const auto slot = m_p->candlesticks.slot({instId, barSize});
 
-    while (numTries <= maxNumTries) {
-        if (m_p->timeout == 0) {
-            /// No need to wait when destroying object
-            break;
-        }
-
-        m_p->candlestickLocker.lock();
+    if (const auto value = slot->load()) {
+        return *value;
+    }
 
-        if (const auto it = m_p->candlesticks.find(instId); it != m_p->candlesticks.end()) {
-            if (const auto itCandle = it->second.find(barSize); itCandle != it->second.end()) {
-                auto retVal = itCandle->second;
-                m_p->candlestickLocker.unlock();
-                return retVal;
-            }
-        }
-        m_p->candlestickLocker.unlock();
-        numTries++;
-        std::this_thread::sleep_for(3ms);
+    if (const auto value = slot->waitForNext(0, std::chrono::seconds(m_p->timeout))) {
+        return *value;
     }
+
     return {};
 }
+
+std::shared_ptr<const DataEventTicker> WSStreamManager::latestTicker(const std::string &instId) const {
+    const auto slot = m_p->tickers.find(instId);
+    return slot ? slot->load() : nullptr;
+}
+
+std::shared_ptr<const DataEventCandlestick> WSStreamManager::latestCandlestick(const std::string &instId, const BarSize barSize) const {
+    const auto slot = m_p->candlesticks.find(std::pair{instId, barSize});
+    return slot ? slot->load() : nullptr;
+}
+
+std::shared_ptr<const DataEventTicker> WSStreamManager::waitForNextTicker(const std::string &instId, const std::chrono::milliseconds timeout) const {
+    const auto slot = m_p->tickers.slot(instId);
+    return slot->waitForNext(slot->version(), timeout);
+}
+
+std::shared_ptr<const DataEventCandlestick>
+WSStreamManager::waitForNextCandlestick(const std::string &instId, const BarSize barSize, const std::chrono::milliseconds timeout) const {
+    const auto slot = m_p->candlesticks.slot({instId, barSize});
+    return slot->waitForNext(slot->version(), timeout);
+}
+
+std::optional<DataEventOrderBook>
+WSStreamManager::readOrderBook(const std::string &instId, const OrderBookChannel channel, const std::size_t depth) const {
+    std::unique_lock lk(m_p->orderBooksLocker);
+    auto it = m_p->orderBooks.end();
+
+    /// No need to wait when destroying object
+    m_p->orderBooksCV.wait_for(lk, std::chrono::seconds(m_p->timeout), [this, &it, &instId, channel] {
+        it = m_p->orderBooks.find({instId, channel});
+        return m_p->timeout == 0 || (it != m_p->orderBooks.end() && it->second.isValid());
+    });
+
+    if (it == m_p->orderBooks.end() || !it->second.isValid()) {
+        return {};
+    }
+
+    DataEventOrderBook retVal;
+    retVal.instId = instId;
+    retVal.channel = orderBookChannelName(channel);
+    retVal.snapshot = true;
+    retVal.bids = it->second.bids(depth);
+    retVal.asks = it->second.asks(depth);
+    retVal.ts = it->second.ts();
+    retVal.seqId = it->second.seqId();
+    retVal.checksum = it->second.checksum();
+    return retVal;
+}
 }
@@ -2,14 +2,32 @@
 #include "stonky/utils/json_utils.h"
 #include "stonky/utils/log_utils.h"
 #include "stonky/okx/okx_ws_stream_manager.h"
+#include "stonky/okx/okx_http_session.h"
+#include "stonky/okx/okx_tls_context.h"
+#include "stonky/okx/okx_request_signer.h"
+#include "stonky/okx/okx_candle_stream.h"
+#include "stonky/okx/okx_candle_store.h"
+#include "stonky/okx/okx_json_reader.h"
+#include "stonky/okx/okx_order_book.h"
+#include "stonky/okx/okx_latest_value.h"
+#include "stonky/okx/okx_market_data_utils.h"
 #include <spdlog/spdlog.h>
 #include <filesystem>
 #include <iostream>
 #include <fstream>
 #include <future>
+#include <set>
+#include <sstream>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
 
 #include "stonky/interface/exchange_types.h"
 #include "stonky/utils/semaphore.h"
+#include "base64.h"
+#include "date.h"
+#include <openssl/hmac.h>
+#include <boost/multiprecision/cpp_dec_float.hpp>
 
 using namespace stonky::okx;
 using namespace std::chrono_literals;
@@ -132,16 +150,40 @@ void testData() {
     wsManager->subscribeTickersStream("ADA-USDT");
 
     while (true) {
-        {
-            if (const auto ret = wsManager->readEventInstrumentInfo("ADA-USDT")) {
-                std::cout << fmt::format("ADA ask price: {}, bid price: {}", ret->tickers[0].askPx.str(),
-                                         ret->tickers[0].bidPx.str())
-                        << std::endl;
-            } else {
-                std::cout << "Error" << std::endl;
-            }
+        if (const auto ret = wsManager->waitForNextTicker("ADA-USDT", 5s)) {
+            std::cout << fmt::format("ADA ask price: {}, bid price: {}", ret->tickers[0].askPx.str(),
+                                     ret->tickers[0].bidPx.str())
+                    << std::endl;
+        } else {
+            std::cout << "Error" << std::endl;
+        }
+    }
+}
+
+/**
+ * Spread ticker streams of all SWAP instruments over several sessions and report the load of each
+ */
+[[noreturn]] void testShardedWebsockets(const std::size_t numSessions = 4, const std::size_t numThreads = 2) {
+    WebSocketClientOptions options;
+    options.numSessions = numSessions;
+    options.numThreads = numThreads;
+
+    const auto restClient = std::make_shared<RESTClient>("", "", "");
+    const auto wsManager = std::make_unique<WSStreamManager>(options);
+    wsManager->setLoggerCallback(&logFunction);
+
+    for (const auto &instrument: restClient->getInstruments(InstrumentType::SWAP)) {
+        wsManager->subscribeTickersStream(instrument.instId);
+    }
+
+    while (true) {
+        std::this_thread::sleep_for(5s);
+
+        for (const auto &stats: wsManager->shardStats()) {
+            logFunction(stonky::LogSeverity::Info, fmt::format("subscriptions: {} (pending {}), {:.1f} msg/s, lag: {} ms (max {} ms), reconnects: {}, writes: {}",
+                                                               stats.subscriptions, stats.pendingSubscriptions, stats.messageRate, stats.lag.count(),
+                                                               stats.maxLag.count(), stats.reconnects, stats.writeQueue.writtenMessages));
         }
-        std::this_thread::sleep_for(1000ms);
     }
 }
 
@@ -319,6 +361,648 @@ void testFrSimple() {
     }
 }
 
+/**
+ * Read funding rates of all SWAP instruments concurrently, all requests are in flight at once on a single thread
+ */
+void testAsyncFundingRates() {
+    using std::chrono::high_resolution_clock;
+    using std::chrono::duration;
+
+    boost::asio::io_context ioc;
+    const auto restClient = std::make_shared<RESTClient>(ioc.get_executor(), "", "", "");
+
+    boost::asio::co_spawn(ioc, [restClient]() -> boost::asio::awaitable<void> {
+        const auto instruments = co_await restClient->asyncGetInstruments(InstrumentType::SWAP);
+        const auto t1 = high_resolution_clock::now();
+        auto remaining = std::make_shared<std::size_t>(instruments.size());
+
+        for (const auto &instrument: instruments) {
+            boost::asio::co_spawn(co_await boost::asio::this_coro::executor, restClient->asyncGetLastFundingRate(instrument.instId),
+                                  [remaining, t1](const std::exception_ptr &e, const FundingRate &fr) {
+                                      if (e) {
+                                          logFunction(stonky::LogSeverity::Warning, "Funding rate request failed");
+                                      } else {
+                                          logFunction(stonky::LogSeverity::Info,
+                                                      fmt::format("{}: {}", fr.instId, fr.fundingRate.convert_to<double>()));
+                                      }
+
+                                      if (--*remaining == 0) {
+                                          const duration<double, std::milli> ms = high_resolution_clock::now() - t1;
+                                          logFunction(stonky::LogSeverity::Info, fmt::format("All funding rates read in: {} ms", ms.count()));
+                                      }
+                                  });
+        }
+    }, boost::asio::detached);
+
+    ioc.run();
+
+    for (const auto &stats: restClient->rateLimiterStats()) {
+        logFunction(stonky::LogSeverity::Info, fmt::format("{}: requests: {}, delayed: {}, total wait: {} ms, max wait: {} ms, throttled: {}, rate: {:.2f}/s",
+                                                           stats.key, stats.requests, stats.delayedRequests, stats.totalWait.count() / 1000,
+                                                           stats.maxWait.count() / 1000, stats.throttledResponses, stats.currentRate));
+    }
+
+    for (const auto lane: {RequestLane::Trading, RequestLane::History}) {
+        const auto stats = restClient->requestLaneStats(lane);
+        logFunction(stonky::LogSeverity::Info, fmt::format("{} lane: requests: {}, queued: {}, max queue depth: {}, max wait: {} ms", magic_enum::enum_name(lane),
+                                                           stats.requests, stats.queuedRequests, stats.maxQueueDepth, stats.maxWait.count() / 1000));
+    }
+}
+
+/**
+ * Compare sequential and sharded parallel backfill of 1m candles
+ */
+void measureParallelBackfill(const int days = 30) {
+    using std::chrono::high_resolution_clock;
+    using std::chrono::duration;
+
+    const auto restClient = std::make_shared<RESTClient>("", "", "");
+    const auto nowTimestamp = std::chrono::seconds(std::time(nullptr)).count() * 1000;
+    const auto oldestDate = nowTimestamp - static_cast<std::int64_t>(days) * HISTORY_LENGTH_IN_S * 1000;
+
+    auto t1 = high_resolution_clock::now();
+    const auto sequential = restClient->getHistoricalPrices("ETH-USDT-SWAP", BarSize::_1m, oldestDate, nowTimestamp);
+    const duration<double, std::milli> sequentialMs = high_resolution_clock::now() - t1;
+
+    t1 = high_resolution_clock::now();
+    const auto parallel = restClient->getHistoricalPricesParallel("ETH-USDT-SWAP", BarSize::_1m, oldestDate, nowTimestamp);
+    const duration<double, std::milli> parallelMs = high_resolution_clock::now() - t1;
+
+    const auto equal = std::ranges::equal(sequential, parallel, [](const Candle &a, const Candle &b) { return a.ts == b.ts; });
+    logFunction(stonky::LogSeverity::Info, fmt::format("Sequential: {} candles in {} ms, parallel: {} candles in {} ms, equal: {}", sequential.size(),
+                                                       sequentialMs.count(), parallel.size(), parallelMs.count(), equal));
+}
+
+/**
+ * Stream a bulk market data ZIP file (e.g. a daily Trades or Orderbook5000 file) line by line, the entry is inflated
+ * through a fixed window and never held in memory as a whole
+ */
+void testZipStreaming(const std::filesystem::path &zipFile) {
+    using std::chrono::high_resolution_clock;
+    using std::chrono::duration;
+
+    try {
+        const utils::ZipEntryReader reader(zipFile);
+        std::size_t numLines = 0;
+        const auto t1 = high_resolution_clock::now();
+        const auto bytes = utils::forEachCsvLine(reader, [&numLines](std::string_view) {
+            ++numLines;
+            return true;
+        });
+        const duration<double, std::milli> ms = high_resolution_clock::now() - t1;
+        logFunction(stonky::LogSeverity::Info, fmt::format("{}: {} lines, {} MB inflated at {:.1f} MB/s", zipFile.filename().string(), numLines,
+                                                           bytes / 1000000, static_cast<double>(bytes) / 1000 / ms.count()));
+    } catch (std::exception &e) {
+        logFunction(stonky::LogSeverity::Warning, fmt::format("Exception: {}", e.what()));
+    }
+}
+
+/**
+ * Compare the sequential and the pipelined download of candle ZIP files. Works against a local static-file HTTPS
+ * server, e.g. "openssl s_server -WWW -accept 8443 -cert cert.pem -key key.pem" started in a directory with daily
+ * candle files, baseUrl then is "https://127.0.0.1:8443".
+ */
+void testMarketDataPipeline(const std::string &baseUrl, const std::vector<std::string> &filenames) {
+    using std::chrono::high_resolution_clock;
+    using std::chrono::duration;
+
+    const auto restClient = std::make_shared<RESTClient>("", "", "");
+    std::vector<MarketDataFileInfo> files;
+
+    for (const auto &filename: filenames) {
+        MarketDataFileInfo file;
+        file.filename = filename;
+        file.url = fmt::format("{}/{}", baseUrl, filename);
+        files.push_back(file);
+    }
+
+    try {
+        auto t1 = high_resolution_clock::now();
+        const auto sequential = restClient->downloadAndParseCandleFiles(files, {1, 1, 0});
+        const duration<double, std::milli> sequentialMs = high_resolution_clock::now() - t1;
+
+        t1 = high_resolution_clock::now();
+        const auto pipelined = restClient->downloadAndParseCandleFiles(files, {8, 4, 64 * 1024 * 1024});
+        const duration<double, std::milli> pipelinedMs = high_resolution_clock::now() - t1;
+
+        const auto equal = std::ranges::equal(sequential, pipelined, [](const Candle &a, const Candle &b) { return a.ts == b.ts; });
+        logFunction(stonky::LogSeverity::Info, fmt::format("Sequential: {} candles in {} ms, pipelined: {} candles in {} ms, equal: {}",
+                                                           sequential.size(), sequentialMs.count(), pipelined.size(), pipelinedMs.count(), equal));
+    } catch (std::exception &e) {
+        logFunction(stonky::LogSeverity::Warning, fmt::format("Exception: {}", e.what()));
+    }
+}
+
+/**
+ * Download the same period twice through the market data cache, the second run has to be served from disk only
+ */
+void testMarketDataCache(const std::filesystem::path &cacheDirectory, const int days = 7) {
+    using std::chrono::high_resolution_clock;
+    using std::chrono::duration;
+
+    const auto restClient = std::make_shared<RESTClient>("", "", "");
+    const auto cache = std::make_shared<MarketDataCache>(MarketDataCacheOptions{cacheDirectory});
+    restClient->setMarketDataCache(cache);
+
+    const auto nowTimestamp = std::chrono::seconds(std::time(nullptr)).count() * 1000;
+    const auto oldestDate = nowTimestamp - static_cast<std::int64_t>(days) * 24 * 60 * 60 * 1000;
+
+    try {
+        for (int run = 0; run < 2; run++) {
+            const auto t1 = high_resolution_clock::now();
+            const auto candles = restClient->downloadAndParseHistoricalCandles(InstrumentType::SWAP, "BTC-USDT", DateAggrType::daily, oldestDate,
+                                                                               nowTimestamp);
+            const duration<double, std::milli> ms = high_resolution_clock::now() - t1;
+            const auto stats = cache->stats();
+            logFunction(stonky::LogSeverity::Info, fmt::format("Run {}: {} candles in {} ms, cache hits: {}, misses: {}, files: {}, {} MB", run,
+                                                               candles.size(), ms.count(), stats.hits, stats.misses, stats.files,
+                                                               stats.bytes / 1000000));
+        }
+    } catch (std::exception &e) {
+        logFunction(stonky::LogSeverity::Warning, fmt::format("Exception: {}", e.what()));
+    }
+}
+
+/**
+ * Backfill candles into the columnar store through the getHistoricalPrices writer, then reopen the store and read the
+ * whole series back from the mapped file
+ */
+void testCandleStore(const std::filesystem::path &storeDirectory, const int days = 30) {
+    using std::chrono::high_resolution_clock;
+    using std::chrono::duration;
+
+    const auto restClient = std::make_shared<RESTClient>("", "", "");
+    const auto nowTimestamp = std::chrono::seconds(std::time(nullptr)).count() * 1000;
+    const auto oldestDate = nowTimestamp - static_cast<std::int64_t>(days) * HISTORY_LENGTH_IN_S * 1000;
+
+    try {
+        {
+            const CandleStore store(storeDirectory, "ETH-USDT-SWAP", BarSize::_1m);
+            const auto from = store.lastTs() ? *store.lastTs() : oldestDate;
+            [[maybe_unused]] const auto candles = restClient->getHistoricalPrices("ETH-USDT-SWAP", BarSize::_1m, from, nowTimestamp, -1, store.writer());
+            logFunction(stonky::LogSeverity::Info, fmt::format("Appended {} candles", store.flush()));
+        }
+
+        const auto t1 = high_resolution_clock::now();
+        const CandleStore store(storeDirectory, "ETH-USDT-SWAP", BarSize::_1m);
+        const auto range = store.range(oldestDate, nowTimestamp);
+        double sumClose = 0;
+
+        for (const auto &segment: range.segments()) {
+            for (std::size_t row = 0; row < segment.size(); ++row) {
+                sumClose += static_cast<double>(segment.mantissas[static_cast<std::size_t>(CandleColumn::c)][row]);
+            }
+        }
+
+        const duration<double, std::milli> ms = high_resolution_clock::now() - t1;
+        logFunction(stonky::LogSeverity::Info, fmt::format("Stored candles: {}, opened and scanned {} candles in {} ms (checksum {})", store.size(),
+                                                           range.size(), ms.count(), sumClose));
+    } catch (std::exception &e) {
+        logFunction(stonky::LogSeverity::Warning, fmt::format("Exception: {}", e.what()));
+    }
+}
+
+/**
+ * Plan and run a hybrid backfill, whole days from the ZIP files and the recent tail from REST
+ */
+void testBackfill(const int days = 30) {
+    using std::chrono::high_resolution_clock;
+    using std::chrono::duration;
+
+    const auto restClient = std::make_shared<RESTClient>("", "", "");
+    const auto nowTimestamp = std::chrono::seconds(std::time(nullptr)).count() * 1000;
+    const auto oldestDate = nowTimestamp - static_cast<std::int64_t>(days) * HISTORY_LENGTH_IN_S * 1000;
+
+    try {
+        const auto plan = restClient->planBackfill("ETH-USDT-SWAP", BarSize::_1m, oldestDate, nowTimestamp);
+
+        for (const auto &step: plan.steps) {
+            logFunction(stonky::LogSeverity::Info, fmt::format("{}: {} - {}, files: {}, cost: {}", magic_enum::enum_name(step.source), step.from, step.to,
+                                                               step.files.size(), step.cost));
+        }
+
+        const auto t1 = high_resolution_clock::now();
+        const auto result = restClient->backfill("ETH-USDT-SWAP", BarSize::_1m, oldestDate, nowTimestamp);
+        const duration<double, std::milli> ms = high_resolution_clock::now() - t1;
+        logFunction(stonky::LogSeverity::Info, fmt::format("Backfill: {} candles ({} ZIP, {} REST, {} seam duplicates) in {} ms, gaps: {}, planned cost: {}",
+                                                           result.candles.size(), result.zipCandles, result.restCandles, result.duplicates,
+                                                           ms.count(), result.gaps.size(), plan.cost));
+    } catch (std::exception &e) {
+        logFunction(stonky::LogSeverity::Warning, fmt::format("Exception: {}", e.what()));
+    }
+}
+
+/**
+ * Walk candles page by page, only the current and the prefetched page are held in memory
+ */
+void testCandleStream(const int days = 30) {
+    const auto restClient = std::make_shared<RESTClient>("", "", "");
+    const auto nowTimestamp = std::chrono::seconds(std::time(nullptr)).count() * 1000;
+    const auto oldestDate = nowTimestamp - static_cast<std::int64_t>(days) * HISTORY_LENGTH_IN_S * 1000;
+
+    RESTCandleStream stream(*restClient, "ETH-USDT-SWAP", BarSize::_1m, oldestDate, nowTimestamp);
+    std::vector<Candle> page;
+    std::size_t count = 0;
+    std::int64_t lastTs = 0;
+    bool ordered = true;
+
+    while (stream.next(page)) {
+        ordered = ordered && page.front().ts > lastTs;
+        lastTs = page.back().ts;
+        count += page.size();
+    }
+
+    logFunction(stonky::LogSeverity::Info, fmt::format("Streamed {} candles, chronological: {}", count, ordered));
+}
+
+/**
+ * Compare size and parse throughput of Decimal64 with cpp_dec_float_50
+ */
+void measureDecimalParsing(const int iterations = 1000000) {
+    using std::chrono::high_resolution_clock;
+    using std::chrono::duration;
+
+    const std::vector<std::string> values{"2512.34", "0.0001234", "-0.00012", "65432.1", "1234567.891", "0.362", "15.5", "0"};
+
+    logFunction(stonky::LogSeverity::Info, fmt::format("sizeof cpp_dec_float_50: {}, sizeof Decimal64: {}, sizeof Candle: {} (7 decimals)",
+                                                       sizeof(boost::multiprecision::cpp_dec_float_50), sizeof(Decimal64), sizeof(Candle)));
+
+    auto t1 = high_resolution_clock::now();
+    double checksum = 0.0;
+
+    for (int i = 0; i < iterations; ++i) {
+        const boost::multiprecision::cpp_dec_float_50 value(values[i % values.size()]);
+        checksum += value.convert_to<double>();
+    }
+
+    const duration<double, std::milli> decFloatMs = high_resolution_clock::now() - t1;
+
+    t1 = high_resolution_clock::now();
+
+    for (int i = 0; i < iterations; ++i) {
+        const Decimal64 value(values[i % values.size()]);
+        checksum += value.convert_to<double>();
+    }
+
+    const duration<double, std::milli> decimalMs = high_resolution_clock::now() - t1;
+    logFunction(stonky::LogSeverity::Info, fmt::format("Parse cpp_dec_float_50: {:.1f} M/s, Decimal64: {:.1f} M/s (checksum {})",
+                                                       iterations / decFloatMs.count() / 1000, iterations / decimalMs.count() / 1000, checksum));
+}
+
+/**
+ * Compare DOM parsing (nlohmann::json + fromJson) with the single-pass JsonCursor reader on a synthetic
+ * /market/tickers SWAP response
+ */
+void measureJsonReading(const int numTickers = 300, const int iterations = 1000) {
+    using std::chrono::high_resolution_clock;
+    using std::chrono::duration;
+
+    nlohmann::json data = nlohmann::json::array();
+
+    for (int i = 0; i < numTickers; ++i) {
+        data.push_back({
+            {"instType", "SWAP"}, {"instId", fmt::format("COIN{}-USDT-SWAP", i)}, {"last", "2512.34"}, {"lastSz", "0.5"}, {"askPx", "2512.35"},
+            {"askSz", "120"}, {"bidPx", "2512.33"}, {"bidSz", "87"}, {"open24h", "2480.1"}, {"high24h", "2530.9"}, {"low24h", "2470.05"},
+            {"volCcy24h", "123456.78"}, {"vol24h", "1234567.8"}, {"ts", "1700000000000"}, {"sodUtc0", "2490.2"}, {"sodUtc8", "2500.7"}
+        });
+    }
+
+    const auto body = nlohmann::json{{"code", "0"}, {"msg", ""}, {"data", data}}.dump();
+
+    auto t1 = high_resolution_clock::now();
+    std::size_t count = 0;
+
+    for (int i = 0; i < iterations; ++i) {
+        Tickers tickers;
+        tickers.fromJson(nlohmann::json::parse(body));
+        count += tickers.tickers.size();
+    }
+
+    const duration<double, std::milli> domMs = high_resolution_clock::now() - t1;
+    t1 = high_resolution_clock::now();
+
+    for (int i = 0; i < iterations; ++i) {
+        Tickers tickers;
+        readResponse(body, tickers);
+        count += tickers.tickers.size();
+    }
+
+    const duration<double, std::milli> cursorMs = high_resolution_clock::now() - t1;
+    const auto megabytes = static_cast<double>(body.size()) * iterations / 1e6;
+    logFunction(stonky::LogSeverity::Info, fmt::format("Tickers body {} B, DOM: {:.1f} MB/s, JsonCursor: {:.1f} MB/s ({} tickers)", body.size(),
+                                                       megabytes / domMs.count() * 1000, megabytes / cursorMs.count() * 1000, count));
+}
+
+/**
+ * Parse a synthetic OKX bulk candle CSV, every row twice as in the real files, with the getline / istringstream /
+ * std::set approach and with utils::parseCandlesCsv
+ */
+void measureCsvParsing(const int numRows = 1000000) {
+    using std::chrono::high_resolution_clock;
+    using std::chrono::duration;
+
+    std::string csv = "instrument_name,open,high,low,close,vol,vol_ccy,vol_quote,open_time,confirm\n";
+
+    for (int i = 0; i < numRows; ++i) {
+        const auto row = fmt::format("BTC-USDT-SWAP,{}.{},{}.{},{}.{},{}.{},{}.{},{}.{},{}.{}2,{},1\n", 37000 + i % 500, i % 10, 37010 + i % 500,
+                                     i % 10, 36990 + i % 500, i % 10, 37005 + i % 500, i % 10, 100 + i % 3000, i % 100, i % 30, i % 1000,
+                                     3700000 + i % 500, i % 100, 1700000000000LL + static_cast<std::int64_t>(i) * 60000);
+        csv.append(row).append(row);
+    }
+
+    const auto megabytes = static_cast<double>(csv.size()) / 1000000;
+    std::size_t count = 0;
+    auto t1 = high_resolution_clock::now();
+
+    {
+        std::vector<Candle> candles;
+        std::set<std::int64_t> seenTimestamps;
+        std::istringstream stream(csv);
+        std::string line;
+        std::getline(stream, line);
+
+        while (std::getline(stream, line)) {
+            std::istringstream lineStream(line);
+            std::string field;
+            std::vector<std::string> fields;
+
+            while (std::getline(lineStream, field, ',')) {
+                fields.push_back(field);
+            }
+
+            Candle candle;
+            std::from_chars(fields[8].data(), fields[8].data() + fields[8].size(), candle.ts);
+
+            if (seenTimestamps.insert(candle.ts).second) {
+                candle.o = Decimal(fields[1]);
+                candle.h = Decimal(fields[2]);
+                candle.l = Decimal(fields[3]);
+                candle.c = Decimal(fields[4]);
+                candle.vol = Decimal(fields[5]);
+                candle.volCcy = Decimal(fields[6]);
+                candle.volCcyQuote = Decimal(fields[7]);
+                candles.push_back(candle);
+            }
+        }
+
+        count += candles.size();
+    }
+
+    const duration<double, std::milli> streamMs = high_resolution_clock::now() - t1;
+    t1 = high_resolution_clock::now();
+    count += utils::parseCandlesCsv(csv).size();
+    const duration<double, std::milli> viewMs = high_resolution_clock::now() - t1;
+
+    logFunction(stonky::LogSeverity::Info, fmt::format("Candle CSV {:.0f} MB, istringstream: {:.0f} MB/s, string_view: {:.0f} MB/s ({})", megabytes,
+                                                       megabytes / streamMs.count() * 1000, megabytes / viewMs.count() * 1000, count));
+}
+
+/**
+ * Compare routing a candle push frame through a DOM with the in-place envelope read used by WebSocketSession
+ */
+void measureWSFrameRouting(const int iterations = 1000000) {
+    using std::chrono::high_resolution_clock;
+    using std::chrono::duration;
+
+    const std::string frame =
+            R"({"arg":{"channel":"candle1m","instId":"BTC-USDT-SWAP"},"data":[["1700000040000","37012.5","37020.1","37001.2","37015.3","1523","15.23","563782.11","0"]]})";
+    std::size_t count = 0;
+
+    auto t1 = high_resolution_clock::now();
+
+    for (int i = 0; i < iterations; ++i) {
+        const std::string copy(frame);
+        const auto json = nlohmann::json::parse(copy);
+        const auto &arg = json["arg"];
+        const auto channel = arg["channel"].get<std::string>();
+        const nlohmann::json data = json["data"];
+        DataEventCandlestick event;
+        event.fromJson(data);
+        count += event.candles.size() + channel.size();
+    }
+
+    const duration<double, std::milli> domMs = high_resolution_clock::now() - t1;
+    t1 = high_resolution_clock::now();
+
+    for (int i = 0; i < iterations; ++i) {
+        DataEvent dataEvent;
+        readDataEvent(frame, dataEvent);
+        DataEventCandlestick event;
+        readEventData(dataEvent.data, event);
+        count += event.candles.size() + dataEvent.channel.size();
+    }
+
+    const duration<double, std::milli> viewMs = high_resolution_clock::now() - t1;
+    logFunction(stonky::LogSeverity::Info, fmt::format("Candle frame routing, DOM: {:.0f} msg/s, in place: {:.0f} msg/s ({})",
+                                                       iterations / domMs.count() * 1000, iterations / viewMs.count() * 1000, count));
+}
+
+/**
+ * Read a ticker slot from several threads while one thread publishes a new value as fast as it can
+ */
+void measureLatestValueReads(const int numReaders = 4, const std::chrono::milliseconds duration = 2000ms) {
+    LatestValue<DataEventTicker> slot;
+    DataEventTicker ticker;
+    ticker.instId = "BTC-USDT-SWAP";
+    ticker.tickers.resize(1);
+    std::atomic<bool> running = true;
+    std::atomic<std::uint64_t> reads = 0;
+    std::vector<std::thread> readers;
+
+    for (int i = 0; i < numReaders; ++i) {
+        readers.emplace_back([&] {
+            std::uint64_t count = 0;
+
+            while (running) {
+                if (const auto value = slot.load()) {
+                    count += value->tickers.size();
+                }
+            }
+
+            reads += count;
+        });
+    }
+
+    std::uint64_t writes = 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    while (std::chrono::steady_clock::now() - start < duration) {
+        slot.store(ticker);
+        ++writes;
+    }
+
+    running = false;
+
+    for (auto &reader: readers) {
+        reader.join();
+    }
+
+    const auto seconds = std::chrono::duration<double>(duration).count();
+    logFunction(stonky::LogSeverity::Info, fmt::format("Latest value slot, {} readers: {:.0f} reads/s, {:.0f} writes/s", numReaders,
+                                                       static_cast<double>(reads) / seconds, static_cast<double>(writes) / seconds));
+}
+
+/**
+ * Replay a synthetic books-l2-tbt stream, 400 levels a side and updates near the top, with and without checksum
+ * verification
+ */
+void measureOrderBookReplay(const int numUpdates = 1000000) {
+    using std::chrono::high_resolution_clock;
+    using std::chrono::duration;
+
+    auto makeLevel = [](const std::int64_t pxTicks, const std::int64_t szLots) {
+        BookLevel level;
+        level.px = Decimal64::fromMantissa(pxTicks, 1);
+        level.sz = Decimal64::fromMantissa(szLots, 3);
+        level.numOrders = static_cast<std::int32_t>(szLots % 7 + 1);
+        return level;
+    };
+
+    std::vector<DataEventOrderBook> events(numUpdates + 1);
+    events[0].instId = "BTC-USDT-SWAP";
+    events[0].channel = "books-l2-tbt";
+    events[0].snapshot = true;
+    events[0].seqId = 1;
+
+    for (std::int64_t i = 0; i < 400; ++i) {
+        events[0].bids.push_back(makeLevel(300000 - i, 1000 + i));
+        events[0].asks.push_back(makeLevel(300001 + i, 1000 + i));
+    }
+
+    std::uint64_t state = 88172645463325252ull;
+
+    auto next = [&state] {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    };
+
+    for (int i = 1; i <= numUpdates; ++i) {
+        auto &event = events[i];
+        event.instId = events[0].instId;
+        event.channel = events[0].channel;
+        event.snapshot = false;
+        event.prevSeqId = events[i - 1].seqId;
+        event.seqId = event.prevSeqId + 1;
+        /// Levels 1-40 away from the spread, a quarter of them deletes
+        const auto bid = next();
+        const auto ask = next();
+        event.bids.push_back(makeLevel(300000 - static_cast<std::int64_t>(bid % 40), bid % 4 == 0 ? 0 : 1 + static_cast<std::int64_t>(bid % 5000)));
+        event.asks.push_back(makeLevel(300001 + static_cast<std::int64_t>(ask % 40), ask % 4 == 0 ? 0 : 1 + static_cast<std::int64_t>(ask % 5000)));
+    }
+
+    /// Checksums from a reference book, as OKX would send them
+    OrderBook reference("books-l2-tbt");
+    reference.setVerifyChecksum(false);
+
+    for (auto &event: events) {
+        reference.apply(event);
+        event.checksum = reference.checksum();
+    }
+
+    for (const bool verify: {false, true}) {
+        OrderBook book("books-l2-tbt");
+        book.setVerifyChecksum(verify);
+        std::size_t applied = 0;
+        const auto t1 = high_resolution_clock::now();
+
+        for (const auto &event: events) {
+            applied += book.apply(event) == OrderBookUpdate::applied;
+        }
+
+        const duration<double, std::milli> ms = high_resolution_clock::now() - t1;
+        logFunction(stonky::LogSeverity::Info, fmt::format("Order book replay, checksum {}: {:.0f} updates/s, {} of {} applied, best {} / {}",
+                                                           verify ? "on" : "off", static_cast<double>(events.size()) / ms.count() * 1000, applied,
+                                                           events.size(), book.bestBid()->px.str(), book.bestAsk()->px.str()));
+    }
+}
+
+/**
+ * Compare per-request signing cost of the one-shot HMAC path with RequestSigner
+ */
+void measureRequestSigning(const int iterations = 1000000) {
+    using std::chrono::high_resolution_clock;
+    using std::chrono::duration;
+
+    const std::string apiSecret = "22582BD0CFF14C41EDBF1AB98506286D";
+    const std::string target = "/api/v5/trade/order?instId=BTC-USDT-SWAP&ordId=590908157585625111";
+    std::size_t checksum = 0;
+
+    auto t1 = high_resolution_clock::now();
+
+    for (int i = 0; i < iterations; i++) {
+        std::string parameterString;
+        const auto now = time_point_cast<std::chrono::milliseconds>(std::chrono::system_clock::now());
+        const auto ts = date::format("%FT%T", date::sys_time{now}).append("Z");
+
+        parameterString.append(ts);
+        parameterString.append("GET");
+        parameterString.append(target);
+
+        unsigned char digest[SHA256_DIGEST_LENGTH];
+        unsigned int digestLength = SHA256_DIGEST_LENGTH;
+
+        HMAC(EVP_sha256(), apiSecret.data(), static_cast<int>(apiSecret.size()),
+             reinterpret_cast<const unsigned char *>(parameterString.data()), parameterString.length(), digest, &digestLength);
+
+        const std::string signature = base64_encode(digest, sizeof(digest));
+        checksum += signature[0] + ts[22];
+    }
+
+    const duration<double, std::nano> legacyNs = high_resolution_clock::now() - t1;
+
+    const RequestSigner signer(apiSecret);
+    RequestSigner::Signature signature;
+    t1 = high_resolution_clock::now();
+
+    for (int i = 0; i < iterations; i++) {
+        signer.sign("GET", target, {}, std::chrono::system_clock::now(), signature);
+        checksum += signature.sign()[0] + signature.timestamp()[22];
+    }
+
+    const duration<double, std::nano> signerNs = high_resolution_clock::now() - t1;
+
+    logFunction(stonky::LogSeverity::Info, fmt::format("One-shot HMAC: {:.0f} ns/sign, RequestSigner: {:.0f} ns/sign (checksum {})",
+                                                       legacyNs.count() / iterations, signerNs.count() / iterations, checksum));
+}
+
+/**
+ * Compare request latency with and without keep-alive connections. Works against any local HTTPS server supporting
+ * keep-alive, e.g. nginx with a self-signed certificate listening on 127.0.0.1:8443.
+ */
+void measureConnectionPool(const std::string &host = "127.0.0.1", const std::string &port = "8443", const int numRequests = 1000) {
+    using std::chrono::high_resolution_clock;
+    using std::chrono::duration;
+
+    try {
+        for (const auto maxIdle: {0, 8}) {
+            HTTPSession session("", "", "");
+            session.setHost(host, port);
+            session.setConnectionPoolOptions({static_cast<std::size_t>(maxIdle), std::chrono::seconds(25)});
+
+            const auto t1 = high_resolution_clock::now();
+
+            for (int i = 0; i < numRequests; i++) {
+                [[maybe_unused]] const auto response = session.get("/", {});
+            }
+
+            const duration<double, std::milli> ms = high_resolution_clock::now() - t1;
+            const auto stats = session.connectionPoolStats();
+            logFunction(stonky::LogSeverity::Info,
+                        fmt::format("Keep-alive: {}, avg request time: {} ms, connections opened: {}, reused: {}, evicted: {}",
+                                    maxIdle != 0, ms.count() / numRequests, stats.connectionsOpened, stats.connectionsReused,
+                                    stats.connectionsEvicted));
+        }
+
+        const auto tlsStats = TLSContext::stats();
+        logFunction(stonky::LogSeverity::Info, fmt::format("TLS handshakes full: {}, resumed: {} of {} attempts", tlsStats.fullHandshakes,
+                                                           tlsStats.resumedHandshakes, tlsStats.resumptionAttempts));
+    } catch (std::exception &e) {
+        logFunction(stonky::LogSeverity::Warning, fmt::format("Exception: {}", e.what()));
+    }
+}
+
 int main() {
     testData();
     return getchar();